@@ -0,0 +1,300 @@
+#ifndef ALLOCATION_H
+#define ALLOCATION_H
+
+#include <memory>
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <utility>
+
+using namespace std;
+
+/*
+ * Allocation policy of blocks, transactions and leaves, the objects shared between nodes and events.
+ * ArenaAllocation (default) takes them from thread-local typed pools and counts references inside the object without
+ * atomics. A simulation runs on one thread and the stats workers only read through references, so every count change
+ * and every free happens on the thread that allocated the object. The slots of freed objects are reused by the next
+ * object of the same type, the memory goes back to malloc with release_object_pools() or when the thread exits.
+ * SharedAllocation is make_shared with atomic counts, compile with SHARED_PTR_ALLOCATION
+ * (cmake -DSHARED_PTR_ALLOCATION=ON) to compare against it.
+ */
+
+// reference count of an object owned through object_ptr
+#ifdef SHARED_PTR_ALLOCATION
+struct pooled_object
+{
+};
+#else
+struct pooled_object
+{
+    unsigned int references = 0;
+
+    pooled_object() = default;
+    // a copy is a new object, nothing refers to it yet
+    pooled_object(const pooled_object&) {}
+    pooled_object& operator=(const pooled_object&) { return *this; }
+};
+#endif
+
+// fixed size slots for objects of type T, carved from chunks that double in size up to POOL_MAX_CHUNK_SLOTS
+#define POOL_FIRST_CHUNK_SLOTS 64
+#define POOL_MAX_CHUNK_SLOTS 4096
+
+template <typename T>
+class ObjectPool
+{
+    union Slot
+    {
+        Slot* next; // while free
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    vector<unique_ptr<Slot[]>> chunks;
+    Slot* free_list = nullptr;
+    Slot* next_unused = nullptr; // bump pointer in the last chunk
+    Slot* chunk_end = nullptr;
+    size_t next_chunk_slots = POOL_FIRST_CHUNK_SLOTS;
+    size_t capacity = 0;
+    size_t live = 0;
+    bool thread_exited = false;
+
+    // plain pointer, so it stays valid while the other thread-locals (e.g. the event queue) release their objects
+    static thread_local ObjectPool* current;
+
+    // frees the pool when the thread exits, or with the last object if some outlive the reaper
+    struct Reaper
+    {
+        ~Reaper()
+        {
+            if (current == nullptr)
+                return;
+            current->thread_exited = true;
+            if (current->live == 0)
+            {
+                delete current;
+                current = nullptr;
+            }
+        }
+    };
+
+public:
+    static constexpr size_t slot_size = sizeof(Slot);
+
+    // pool of the calling thread
+    static ObjectPool& local()
+    {
+        if (current == nullptr)
+        {
+            static thread_local Reaper reaper;
+            current = new ObjectPool;
+        }
+        return *current;
+    }
+
+    void* allocate()
+    {
+        live++;
+        if (free_list != nullptr)
+        {
+            Slot* slot = free_list;
+            free_list = slot->next;
+            return slot;
+        }
+        if (next_unused == chunk_end)
+        {
+            chunks.emplace_back(new Slot[next_chunk_slots]);
+            next_unused = chunks.back().get();
+            chunk_end = next_unused + next_chunk_slots;
+            capacity += next_chunk_slots;
+            if (next_chunk_slots < POOL_MAX_CHUNK_SLOTS)
+                next_chunk_slots *= 2;
+        }
+        return next_unused++;
+    }
+
+    void deallocate(void* object)
+    {
+        live--;
+        Slot* slot = static_cast<Slot*>(object);
+        slot->next = free_list;
+        free_list = slot;
+        if (live == 0 && thread_exited)
+        {
+            current = nullptr;
+            delete this;
+        }
+    }
+
+    // hands all chunks back to malloc, only possible once every object is freed
+    bool release()
+    {
+        if (live > 0)
+            return false;
+        chunks.clear();
+        free_list = next_unused = chunk_end = nullptr;
+        next_chunk_slots = POOL_FIRST_CHUNK_SLOTS;
+        capacity = 0;
+        return true;
+    }
+
+    size_t live_objects() const { return live; }
+    size_t capacity_objects() const { return capacity; }
+};
+
+template <typename T>
+thread_local ObjectPool<T>* ObjectPool<T>::current = nullptr;
+
+// intrusive pointer to a pooled object, copies only touch the plain counter in the object
+template <typename T>
+class pool_ptr
+{
+    T* object = nullptr;
+
+    void release()
+    {
+        if (object != nullptr && --object->references == 0)
+        {
+            object->~T();
+            ObjectPool<T>::local().deallocate(object);
+        }
+    }
+
+public:
+    pool_ptr() = default;
+    pool_ptr(nullptr_t) {}
+
+    // takes a reference to an object constructed in a slot of ObjectPool<T>
+    explicit pool_ptr(T* object) : object(object)
+    {
+        if (object != nullptr)
+            object->references++;
+    }
+
+    pool_ptr(const pool_ptr& other) : object(other.object)
+    {
+        if (object != nullptr)
+            object->references++;
+    }
+
+    pool_ptr(pool_ptr&& other) noexcept : object(other.object)
+    {
+        other.object = nullptr;
+    }
+
+    pool_ptr& operator=(const pool_ptr& other)
+    {
+        if (other.object != nullptr)
+            other.object->references++;
+        release();
+        object = other.object;
+        return *this;
+    }
+
+    pool_ptr& operator=(pool_ptr&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            object = other.object;
+            other.object = nullptr;
+        }
+        return *this;
+    }
+
+    ~pool_ptr() { release(); }
+
+    T* get() const { return object; }
+    T& operator*() const { return *object; }
+    T* operator->() const { return object; }
+    explicit operator bool() const { return object != nullptr; }
+
+    friend bool operator==(const pool_ptr& a, const pool_ptr& b) { return a.object == b.object; }
+    friend bool operator!=(const pool_ptr& a, const pool_ptr& b) { return a.object != b.object; }
+};
+
+struct SharedAllocation
+{
+    template <typename T>
+    using pointer = shared_ptr<T>;
+
+    template <typename T, typename... Args>
+    static pointer<T> make(Args&&... args)
+    {
+        return make_shared<T>(std::forward<Args>(args)...);
+    }
+
+    // bytes one object occupies, make_shared puts the control block into the same malloc chunk
+    template <typename T>
+    static constexpr size_t object_bytes()
+    {
+        const size_t size = (sizeof(T) + 16 + 8 + 15) & ~static_cast<size_t>(15);
+        return size < 32 ? 32 : size;
+    }
+};
+
+struct ArenaAllocation
+{
+    template <typename T>
+    using pointer = pool_ptr<T>;
+
+    template <typename T, typename... Args>
+    static pointer<T> make(Args&&... args)
+    {
+        ObjectPool<T>& pool = ObjectPool<T>::local();
+        void* slot = pool.allocate();
+        try
+        {
+            return pointer<T>(new(slot) T(std::forward<Args>(args)...));
+        }
+        catch (...)
+        {
+            pool.deallocate(slot);
+            throw;
+        }
+    }
+
+    template <typename T>
+    static constexpr size_t object_bytes()
+    {
+        return ObjectPool<T>::slot_size;
+    }
+};
+
+#ifdef SHARED_PTR_ALLOCATION
+typedef SharedAllocation Allocation;
+#else
+typedef ArenaAllocation Allocation;
+#endif
+
+template <typename T>
+using object_ptr = Allocation::pointer<T>;
+
+template <typename T, typename... Args>
+object_ptr<T> make_object(Args&&... args)
+{
+    return Allocation::make<T>(std::forward<Args>(args)...);
+}
+
+// base of objects whose pointer is recovered from a plain pointer with object_ptr_from
+#ifdef SHARED_PTR_ALLOCATION
+template <typename T>
+using referable = enable_shared_from_this<T>;
+#else
+template <typename T>
+struct referable
+{
+};
+#endif
+
+// another reference to an object that is still owned through an object_ptr
+template <typename T>
+object_ptr<T> object_ptr_from(T* object)
+{
+#ifdef SHARED_PTR_ALLOCATION
+    return object->shared_from_this();
+#else
+    return object_ptr<T>(object);
+#endif
+}
+
+#endif //ALLOCATION_H
@@ -1,62 +1,315 @@
 #include "Blockchain.h"
 
+#include <cstring>
 #include <utility>
+#include <unordered_map>
 
-long long Transaction::transaction_ticket = 0;
-long long Block::block_ticket = 0;
+thread_local long long Transaction::transaction_ticket = 0;
+thread_local long long Block::block_ticket = 0;
 
 Transaction::Transaction(const int receiver, const int amount, const bool coinbase, const int sender)
 {
+    if (coinbase && sender != -1) throw invalid_argument("sender present for coinbase transaction");
+
     id = transaction_ticket++;
-    this->receiver = receiver;
-    this->amount = amount;
-    this->coinbase = coinbase;
-    this->sender = sender;
+    this->store_index = chain_store.add_transaction(*this, receiver, amount, coinbase, sender);
+}
 
-    if (coinbase && sender != -1) throw invalid_argument("sender present for coinbase transaction");
+Transaction::~Transaction()
+{
+    if (!chain_store_destroyed)
+        chain_store.release(*this);
 }
 
-Block::Block(const long long creation_time,  shared_ptr<Block> parent_block,bool is_private,bool is_honest)
+void Transaction::reset_ticket()
+{
+    transaction_ticket = 0;
+}
+
+long long Transaction::get_ticket()
+{
+    return transaction_ticket;
+}
+
+void Transaction::set_ticket(const long long ticket)
+{
+    transaction_ticket = ticket;
+}
+
+Block::Block(const long long creation_time,  object_ptr<Block> parent_block,bool is_private,bool is_honest)
 {
     id = block_ticket++;
     this->parent_block = std::move(parent_block);
-    this->creation_time = creation_time;
-    this->is_private = is_private;
-    this->is_honest = is_honest;
+    this->height = this->parent_block ? this->parent_block->height + 1 : 1;
+    // the ancestor 2^k below is 2^(k-1) below the ancestor 2^(k-1) below
+    if (this->parent_block)
+    {
+        jumps.push_back(this->parent_block.get());
+        while (jumps.back()->jumps.size() >= jumps.size())
+            jumps.push_back(jumps.back()->jumps[jumps.size() - 1]);
+    }
+    this->nonce = 0;
+    this->store_index = chain_store.add_block(*this, creation_time, (is_private ? BLOCK_PRIVATE : 0) |
+                                              (is_honest ? BLOCK_HONEST : 0));
+    this->hash_cached = false;
+    this->merkle_root_cached = false;
+}
+
+Block::~Block()
+{
+    if (!chain_store_destroyed)
+        chain_store.release(*this);
+}
+
+const Block* Block::ancestor(const long long height) const
+{
+    if (height > this->height || height < 1)
+        return nullptr;
+    // one jump per set bit of the distance, lowest first, every jump stays at or above height, a missing jump means
+    // the height is below a root cut from its parent
+    const Block* blk = this;
+    for (unsigned long long distance = this->height - height, k = 0; distance != 0; distance >>= 1, k++)
+        if (distance & 1)
+        {
+            if (k >= blk->jumps.size())
+                return nullptr;
+            blk = blk->jumps[k];
+        }
+    return blk;
+}
+
+void Block::cut_parent()
+{
+    hash();
+    jumps.clear();
+    parent_block = nullptr;
+    chain_store.block_parent[store_index] = NO_STORE_INDEX;
+}
+
+void Block::drop_jumps_below(const long long height)
+{
+    while (!jumps.empty() && jumps.back()->height < height)
+        jumps.pop_back();
+}
+
+const Block* lowest_common_ancestor(const Block* a, const Block* b)
+{
+    if (a->height > b->height)
+        a = a->ancestor(b->height);
+    else
+        b = b->ancestor(a->height);
+    if (a == b)
+        return a;
+
+    // a and b stay at equal heights, take every jump that lands below their common ancestor
+    for (size_t k = a->jumps.size(); k-- > 0;)
+        if (k < a->jumps.size() && a->jumps[k] != b->jumps[k])
+        {
+            a = a->jumps[k];
+            b = b->jumps[k];
+        }
+    return a->jumps[0];
+}
+
+bool is_ancestor(const Block* ancestor, const Block* blk)
+{
+    return blk->ancestor(ancestor->height) == ancestor;
+}
+
+// little endian encoding of the header and transaction fields
+static void put_bytes(uint8_t*& out, const long long value)
+{
+    for (int i = 0; i < 8; i++)
+        *out++ = static_cast<uint8_t>(static_cast<unsigned long long>(value) >> (8 * i));
+}
+
+const sha256_digest& Block::merkle_root()
+{
+    if (merkle_root_cached)
+        return cached_merkle_root;
+
+    // leaves: one 32 byte record per transaction (id, receiver, sender, amount, coinbase), hashed as a batch
+    const size_t count = transactions.size();
+    vector<uint8_t> records(count * 32, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Transaction& txn = *transactions[i];
+        uint8_t* out = records.data() + i * 32;
+        put_bytes(out, txn.id);
+        put_bytes(out, (static_cast<long long>(txn.sender()) << 32) | static_cast<unsigned int>(txn.receiver()));
+        put_bytes(out, txn.amount());
+        *out = txn.coinbase();
+    }
+    vector<sha256_digest> level(count);
+    sha256_many(records.data(), 32, count, level.data());
+
+    // each level hashes pairs of children, an odd last child is paired with itself
+    while (level.size() > 1)
+    {
+        if (level.size() % 2 == 1)
+            level.push_back(level.back());
+        const size_t pairs = level.size() / 2;
+        // in place, digest i is stored after pairs up to i were read
+        sha256_many(reinterpret_cast<const uint8_t*>(level.data()), 64, pairs, level.data());
+        level.resize(pairs);
+    }
+
+    cached_merkle_root = level.empty() ? sha256_digest{} : level[0];
+    merkle_root_cached = true;
+    return cached_merkle_root;
+}
+
+void Block::header_prefix(uint8_t out[64])
+{
+    const sha256_digest parent_hash = parent_block ? parent_block->hash() : sha256_digest{};
+    memcpy(out, parent_hash.data(), 32);
+    memcpy(out + 32, merkle_root().data(), 32);
+}
+
+void Block::header_suffix(const long long nonce, uint8_t out[16]) const
+{
+    put_bytes(out, creation_time());
+    put_bytes(out, nonce);
 }
 
-LeafNode::LeafNode( shared_ptr<Block> block, const long long length)
+const sha256_digest& Block::hash()
+{
+    if (hash_cached)
+        return cached_hash;
+
+    uint8_t header[80];
+    header_prefix(header);
+    header_suffix(nonce, header + 64);
+    cached_hash = sha256(header, sizeof(header));
+    hash_cached = true;
+    return cached_hash;
+}
+
+long long Block::short_hash()
+{
+    unsigned long long value = 0;
+    for (int i = 0; i < 8; i++)
+        value = (value << 8) | hash()[i];
+    return static_cast<long long>(value);
+}
+
+void Block::set_nonce(const long long nonce)
+{
+    this->nonce = nonce;
+    hash_cached = false;
+}
+
+void Block::restore_hash(const sha256_digest& hash)
+{
+    cached_hash = hash;
+    hash_cached = true;
+}
+
+void Block::reset_ticket()
+{
+    block_ticket = 0;
+}
+
+long long Block::get_ticket()
+{
+    return block_ticket;
+}
+
+void Block::set_ticket(const long long ticket)
+{
+    block_ticket = ticket;
+}
+
+// ledgers shared by honest nodes by block id, entries are removed when their ledger is freed
+static thread_local unordered_map<long long, Ledger*> shared_ledger_table;
+
+Ledger::Ledger(const long long block_id)
+{
+    this->block_id = block_id;
+    this->shared = false;
+}
+
+Ledger::~Ledger()
+{
+    if (!shared)
+        return;
+    // a ledger of an earlier simulation on this thread may outlive the table it was in
+    const auto it = shared_ledger_table.find(block_id);
+    if (it != shared_ledger_table.end() && it->second == this)
+        shared_ledger_table.erase(it);
+}
+
+object_ptr<Ledger> find_shared_ledger(const long long block_id)
+{
+    const auto it = shared_ledger_table.find(block_id);
+    return it == shared_ledger_table.end() ? nullptr : object_ptr_from(it->second);
+}
+
+void share_ledger(const object_ptr<Ledger>& ledger)
+{
+    ledger->shared = true;
+    shared_ledger_table[ledger->block_id] = ledger.get();
+}
+
+void clear_shared_ledgers()
+{
+    shared_ledger_table.clear();
+}
+
+size_t shared_ledger_count()
+{
+    return shared_ledger_table.size();
+}
+
+LeafNode::LeafNode( object_ptr<Block> block, const long long length)
 {
     this->block = std::move(block);
     this->length = length;
-    this->balance.resize(number_of_nodes, 0);
+    this->blocks_mined = 0;
+    this->fork_height = length;
+}
+
+bool CompareBlockPtrById::operator()(const object_ptr<Block>& a, const object_ptr<Block>& b) const
+{
+    return a->id < b->id;
 }
 
-bool CompareLeafNodePtr::operator()(const std::shared_ptr<LeafNode>& a, const std::shared_ptr<LeafNode>& b) const
+bool CompareLeafNodePtr::operator()(const object_ptr<LeafNode>& a, const object_ptr<LeafNode>& b) const
 {
     if (a->length == b->length) return a->block->id < b->block->id;
     else return a->length > b->length;
 }
 
-Timer::Timer(shared_ptr<Block> blk,bool is_running)
+void release_object_pools()
+{
+#ifndef SHARED_PTR_ALLOCATION
+    ObjectPool<Block>::local().release();
+    ObjectPool<Transaction>::local().release();
+    ObjectPool<LeafNode>::local().release();
+    ObjectPool<Ledger>::local().release();
+#endif
+}
+
+Timer::Timer(object_ptr<Block> blk,bool is_running)
 {
     this->blk = std::move(blk);
     this->is_running = is_running;
+    this->current_sender = -1;
 }
 
 ostream& operator<<(ostream& os, const Transaction& txn)
 {
-    if (txn.coinbase)
-        os << txn.id << ": " << txn.receiver << " mines " << txn.amount << " coins";
+    if (txn.coinbase())
+        os << txn.id << ": " << txn.receiver() << " mines " << txn.amount() << " coins";
     else
-        os << txn.id << ": " << txn.sender << " pays " << txn.receiver << " " << txn.amount << " coins";
+        os << txn.id << ": " << txn.sender() << " pays " << txn.receiver() << " " << txn.amount() << " coins";
     return os;
 }
 
 ostream& operator<<(ostream& os, const Block& block)
 {
     os << "Block id: " << block.id << " Txns: " << block.transactions.size() << endl;
-    for (const shared_ptr<Transaction>& txn : block.transactions)
+    for (const object_ptr<Transaction>& txn : block.transactions)
         os << *txn << endl;
     return os;
 }
@@ -66,11 +319,10 @@ ostream& operator<<(ostream& os, const LeafNode& leaf)
     os << "Leaf length: " << leaf.length << endl;
     os << "Block: " << *leaf.block;
     os << "Transactions: ";
-    for (const auto x : leaf.transaction_ids)
-        os << x << "\t";
+    leaf.ledger->transaction_ids.for_each([&os](const long long x) { os << x << "\t"; });
     os << endl;
     os << "Balance: ";
-    for (const auto x : leaf.balance)
+    for (const auto x : leaf.ledger->balance)
         os << x << "\t";
     os << endl;
     return os;
@@ -6,73 +6,167 @@
 #include <set>
 #include <memory>
 #include <queue>
+#include "Sha256.h"
+#include "Allocation.h"
+#include "IdSet.h"
+#include "ChainStore.h"
 
 using namespace std;
 
-extern int number_of_nodes;
-extern int percent_malicious_nodes;
+extern thread_local int number_of_nodes;
+extern thread_local int percent_malicious_nodes;
 
-class Transaction
+class Transaction : public pooled_object
 {
     // increasing variable to generate unique transaction ids
-    static long long transaction_ticket;
+    static thread_local long long transaction_ticket;
 
 public:
     long long id;
-    int receiver;
-    long long amount;
-    bool coinbase;
-    int sender;
+    uint32_t store_index; // in the chain store, which holds the fields below
 
     Transaction(int receiver, int amount, bool coinbase, int sender = -1);
+    ~Transaction();
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+    int receiver() const { return chain_store.transaction_receiver[store_index]; }
+    long long amount() const { return chain_store.transaction_amount[store_index]; }
+    bool coinbase() const { return chain_store.transaction_coinbase[store_index]; }
+    int sender() const { return chain_store.transaction_sender[store_index]; }
+    // restart ids from 0 for a new simulation on this thread
+    static void reset_ticket();
+    // id of the next transaction, saved and restored with snapshots
+    static long long get_ticket();
+    static void set_ticket(long long ticket);
     friend ostream& operator<<(ostream& os, const Transaction& txn);
 };
 
-class Block
+class Block : public pooled_object, public referable<Block>
 {
     // increasing variable to generate unique block ids
-    static long long block_ticket;
+    static thread_local long long block_ticket;
 
 public:
     long long id;
-    shared_ptr<Block> parent_block;
-    vector<shared_ptr<Transaction>> transactions;
-    long long creation_time;
-    bool is_private;
-    bool is_honest;
-
-    Block(long long creation_time, shared_ptr<Block> parent_block, bool is_private, bool is_honest);
+    object_ptr<Block> parent_block;
+    vector<object_ptr<Transaction>> transactions;
+    long long height; // genesis at height 1, equal to the length of a leaf ending at this block
+    // binary lifting index: jumps[k] is the ancestor 2^k blocks below, built from the parent's index on creation
+    // raw pointers are enough, a block owns all its ancestors through parent_block down to the first root cut from
+    // its parent, the jumps below that root are dropped together with the blocks there
+    vector<Block*> jumps;
+    long long nonce;
+    uint32_t store_index; // in the chain store, which holds the creation time and flags
+
+    Block(long long creation_time, object_ptr<Block> parent_block, bool is_private, bool is_honest);
+    ~Block();
+    Block(const Block&) = delete;
+    Block& operator=(const Block&) = delete;
+    long long creation_time() const { return chain_store.block_creation_time[store_index]; }
+    bool is_private() const { return chain_store.block_flags[store_index] & BLOCK_PRIVATE; }
+    bool is_honest() const { return chain_store.block_flags[store_index] & BLOCK_HONEST; }
+    // published by release_private
+    void make_public() { chain_store.block_flags[store_index] &= ~BLOCK_PRIVATE; }
+    // ancestor at the given height in O(log h), the block itself at its own height, nullptr above it, below 1 or
+    // below a root cut from its parent
+    const Block* ancestor(long long height) const;
+    // cuts a root of the nodes from its parent once no node needs the chain below: the hash is cached, the parent
+    // and the jumps are dropped, which frees the blocks below unless something else holds them
+    void cut_parent();
+    // drops the jumps landing below height, for the blocks above a cut root
+    void drop_jumps_below(long long height);
+    // SHA-256 of the 80 byte header: parent hash, Merkle root, creation time and nonce
+    // computed on first use, the transactions must not change afterwards
+    const sha256_digest& hash();
+    const sha256_digest& merkle_root();
+    // first 8 bytes of the hash, carried by hash announcements
+    long long short_hash();
+    // header bytes 0-63: parent hash and Merkle root, shared by all nonces
+    void header_prefix(uint8_t out[64]);
+    // header bytes 64-79: creation time and nonce
+    void header_suffix(long long nonce, uint8_t out[16]) const;
+    // drops the cached header hash, the Merkle root stays valid
+    void set_nonce(long long nonce);
+    // hash of a cut root restored from a snapshot without its parent, which cannot be recomputed
+    void restore_hash(const sha256_digest& hash);
+    // restart ids from 0 for a new simulation on this thread
+    static void reset_ticket();
+    // id of the next block, saved and restored with snapshots
+    static long long get_ticket();
+    static void set_ticket(long long ticket);
     friend ostream& operator<<(ostream& os, const Block& block);
+
+private:
+    sha256_digest cached_hash;
+    sha256_digest cached_merkle_root;
+    bool hash_cached;
+    bool merkle_root_cached;
+};
+
+// deepest block that is an ancestor of both a and b (or one of them), O(log h) through the jump index
+const Block* lowest_common_ancestor(const Block* a, const Block* b);
+// true if ancestor is blk or one of its ancestors
+bool is_ancestor(const Block* ancestor, const Block* blk);
+
+// Balances and transaction ids of the chain ending at a block, the same for every node with that block as a leaf.
+// With shared ledgers honest nodes share one ledger per block through the shared ledger table, other nodes keep their own copies.
+class Ledger : public pooled_object, public referable<Ledger>
+{
+public:
+    long long block_id; // tip of the chain
+    IdSet transaction_ids; // to verify if transaction already present in chain
+    vector<long long> balance; // balance of each peer in that chain for easy validation of transactions
+    bool shared; // in the shared ledger table
+
+    explicit Ledger(long long block_id);
+    ~Ledger();
 };
 
+// ledger of a block in the shared table of this thread, nullptr if no honest node has validated the block yet
+object_ptr<Ledger> find_shared_ledger(long long block_id);
+// adds ledger to the table, it stays there while a leaf holds it
+void share_ledger(const object_ptr<Ledger>& ledger);
+// empties the table for a new simulation on this thread
+void clear_shared_ledgers();
+size_t shared_ledger_count();
+
 // Leaf node of Block chain tree
-class LeafNode
+class LeafNode : public pooled_object
 {
 public:
-    shared_ptr<Block> block; // last block in that chain
+    object_ptr<Block> block; // last block in that chain
     long long length; // used to determine longest chain
-    set<long long> transaction_ids; // to verify if transaction already present in chain
-    vector<long long> balance; // balance of each peer in that chain for easy validation of transactions
+    object_ptr<Ledger> ledger; // balances and transaction ids of the chain
+    long long blocks_mined; // blocks in that chain mined by the node owning the leaf
+    long long fork_height; // height of the common ancestor with the owner's longest chain
 
-    LeafNode(shared_ptr<Block> block, long long length);
+    LeafNode(object_ptr<Block> block, long long length);
     friend ostream& operator<<(ostream& os, const LeafNode& leaf);
 
 };
 
 class Timer {
     public:
-    shared_ptr<Block> blk;
+    object_ptr<Block> blk;
     queue<int> available_senders;
     set<int> tried_senders;
     bool is_running;
     int current_sender;
 
-    Timer(shared_ptr<Block> blk, bool is_runninng);
+    Timer(object_ptr<Block> blk, bool is_runninng);
+};
+
+// orders block pointers by id so iteration does not depend on heap addresses
+struct CompareBlockPtrById {
+    bool operator()(const object_ptr<Block>& a, const object_ptr<Block>& b) const;
 };
 
 // comparator to sort  LeafNode pointers by length of leaf node
 struct CompareLeafNodePtr {
-    bool operator()(const std::shared_ptr<LeafNode>& a, const std::shared_ptr<LeafNode>& b) const;
+    bool operator()(const object_ptr<LeafNode>& a, const object_ptr<LeafNode>& b) const;
 };
 
+// returns the pool memory of this thread's blocks, transactions and leaves to malloc if none of them is alive
+void release_object_pools();
+
 #endif //BLOCKCHAIN_H
@@ -0,0 +1,220 @@
+#include "Branch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include "Strategy.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// result of one child as sent over its pipe
+struct branch_record
+{
+    int32_t ringmaster_node_id;
+    int32_t failed;
+    int64_t blocks_mined;
+    int64_t blocks_mined_in_longest_chain;
+    int64_t blocks_in_longest_chain;
+    int64_t number_of_forks;
+    int64_t longest_fork_length;
+    int64_t shortest_fork_length;
+    uint64_t average_fork_length;
+    double wall_time;
+    uint64_t accounted_bytes;
+    char error[128];
+};
+
+vector<SimulationConfig> read_branch_file(const string& filepath, const SimulationConfig& base,
+                                          const string& output_dir)
+{
+    ifstream file(filepath);
+    if (!file)
+        throw runtime_error("Unable to open branch file " + filepath);
+
+    vector<SimulationConfig> variants;
+    string line;
+    int line_number = 0;
+    while (getline(file, line))
+    {
+        line_number++;
+        const auto first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+            continue;
+
+        SimulationConfig variant = base;
+        variant.eclipse_attack = false;
+        variant.mitigation = false;
+        variant.selfish_mining = true;
+        variant.release_strategy = RELEASE_SELFISH;
+        istringstream fields(line);
+        string option;
+        while (fields >> option)
+        {
+            if (option == "--eclipse") variant.eclipse_attack = true;
+            else if (option == "--mitigation") variant.mitigation = true;
+            else if (option == "--selfish-mining") variant.selfish_mining = true;
+            else if (option == "--no-selfish-mining") variant.selfish_mining = false;
+            else if (option == "--stubborn") variant.release_strategy = RELEASE_LEAD_STUBBORN;
+            else if (option == "--seed" && fields >> variant.seed) continue;
+            else throw runtime_error("Unknown option " + option + " in branch line " + to_string(line_number));
+        }
+        variant.output_dir = output_dir + "/branch_" + to_string(variants.size());
+        variants.push_back(variant);
+    }
+    return variants;
+}
+
+#ifdef _WIN32
+
+vector<sweep_result> run_fork_branches(Simulator&, const vector<SimulationConfig>&, unsigned int)
+{
+    throw runtime_error("Forked branches need POSIX fork(), use --warmup and --restore instead");
+}
+
+#else
+
+// runs in the child, never returns
+[[noreturn]] static void run_child(Simulator& sim, const SimulationConfig& variant, const int write_fd)
+{
+    branch_record record{};
+    const auto start = chrono::steady_clock::now();
+    try
+    {
+        // stdout of the children would interleave, only the parent reports
+        if (const int null_fd = open("/dev/null", O_WRONLY); null_fd >= 0)
+        {
+            dup2(null_fd, STDOUT_FILENO);
+            close(null_fd);
+        }
+        sim.branch(variant);
+        sim.start();
+        record.accounted_bytes = sim.get_run_statistics().accounted_bytes;
+
+        const node_summary summary = sim.network.nodes[sim.network.ringmaster_node_id].summarize_chain();
+        record.ringmaster_node_id = sim.network.ringmaster_node_id;
+        record.blocks_mined = summary.blocks_mined;
+        record.blocks_mined_in_longest_chain = summary.blocks_mined_in_longest_chain;
+        record.blocks_in_longest_chain = summary.blocks_in_longest_chain;
+        record.number_of_forks = summary.number_of_forks;
+        record.longest_fork_length = summary.longest_fork_length;
+        record.shortest_fork_length = summary.shortest_fork_length;
+        record.average_fork_length = summary.average_fork_length;
+    }
+    catch (const exception& e)
+    {
+        record.failed = 1;
+        strncpy(record.error, e.what(), sizeof(record.error) - 1);
+    }
+    record.wall_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // smaller than PIPE_BUF, so the write is atomic and never blocks on an unread pipe
+    const ssize_t written = write(write_fd, &record, sizeof(record));
+    close(write_fd);
+    // skip destructors of the copied simulation, the parent still owns the shared state
+    _exit(written == sizeof(record) ? 0 : 1);
+}
+
+static void read_child(const int read_fd, const pid_t pid, sweep_result& result)
+{
+    branch_record record{};
+    size_t received = 0;
+    while (received < sizeof(record))
+    {
+        const ssize_t n = read(read_fd, reinterpret_cast<char*>(&record) + received, sizeof(record) - received);
+        if (n <= 0)
+            break;
+        received += n;
+    }
+    close(read_fd);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    if (received != sizeof(record))
+    {
+        result.error = "branch exited without a result, status " + to_string(status);
+        return;
+    }
+    result.wall_time = record.wall_time;
+    if (record.failed)
+    {
+        result.error = record.error;
+        return;
+    }
+    result.accounted_bytes = record.accounted_bytes;
+    result.ringmaster_node_id = record.ringmaster_node_id;
+    result.ringmaster.blocks_mined = record.blocks_mined;
+    result.ringmaster.blocks_mined_in_longest_chain = record.blocks_mined_in_longest_chain;
+    result.ringmaster.blocks_in_longest_chain = record.blocks_in_longest_chain;
+    result.ringmaster.number_of_forks = record.number_of_forks;
+    result.ringmaster.longest_fork_length = record.longest_fork_length;
+    result.ringmaster.shortest_fork_length = record.shortest_fork_length;
+    result.ringmaster.average_fork_length = record.average_fork_length;
+}
+
+vector<sweep_result> run_fork_branches(Simulator& sim, const vector<SimulationConfig>& variants,
+                                       unsigned int max_children)
+{
+    if (max_children == 0)
+        max_children = max(1u, thread::hardware_concurrency());
+
+    vector<sweep_result> results(variants.size());
+    vector<pair<pid_t, int>> running(variants.size(), {-1, -1}); // pid and read end of the pipe per variant
+    size_t next_to_collect = 0;
+
+    // buffered output would otherwise be written once by the parent and once by every child
+    sim.prepare_fork();
+    cout.flush();
+    cerr.flush();
+    fflush(nullptr);
+
+    for (size_t i = 0; i < variants.size(); i++)
+    {
+        results[i].config = variants[i];
+        // children are collected in order, which bounds how many run at once
+        if (i - next_to_collect >= max_children)
+        {
+            if (running[next_to_collect].first > 0)
+                read_child(running[next_to_collect].second, running[next_to_collect].first, results[next_to_collect]);
+            next_to_collect++;
+        }
+
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            results[i].error = "pipe failed";
+            continue;
+        }
+        const pid_t pid = fork();
+        if (pid < 0)
+        {
+            close(fds[0]);
+            close(fds[1]);
+            results[i].error = "fork failed";
+            continue;
+        }
+        if (pid == 0)
+        {
+            close(fds[0]);
+            // pipes of earlier siblings are not used by this child
+            for (size_t j = next_to_collect; j < i; j++)
+                if (running[j].second >= 0)
+                    close(running[j].second);
+            run_child(sim, variants[i], fds[1]);
+        }
+        close(fds[1]);
+        running[i] = {pid, fds[0]};
+        cout << " Forked branch " << i << " (pid " << pid << ") writing to " << variants[i].output_dir << endl;
+    }
+
+    for (; next_to_collect < variants.size(); next_to_collect++)
+        if (running[next_to_collect].first > 0)
+            read_child(running[next_to_collect].second, running[next_to_collect].first, results[next_to_collect]);
+    return results;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef BRANCH_H
+#define BRANCH_H
+
+#include "Sweep.h"
+
+// Reads one branch per line, blank lines and lines starting with # are skipped:
+// [--eclipse] [--mitigation] [--selfish-mining | --no-selfish-mining] [--stubborn] [--seed <seed>]
+// toggles not given are off, except selfish mining
+// each branch takes the parameters of base and writes its output to output_dir/branch_<k>
+vector<SimulationConfig> read_branch_file(const string& filepath, const SimulationConfig& base,
+                                          const string& output_dir);
+
+// Forks one child per variant from the current state of sim, at most max_children at a time (0 uses the
+// number of hardware threads). Children share the memory of the parent copy-on-write, run their variant
+// to the end and send a fixed size result record back over a pipe. sim is left unchanged.
+vector<sweep_result> run_fork_branches(Simulator& sim, const vector<SimulationConfig>& variants,
+                                       unsigned int max_children);
+
+#endif //BRANCH_H
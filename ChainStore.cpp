@@ -0,0 +1,183 @@
+#include "ChainStore.h"
+
+#include <stdexcept>
+#include "Blockchain.h"
+
+thread_local bool chain_store_destroyed = false;
+
+// freed rows below which compact leaves the store alone
+#define COMPACT_MIN_RELEASED 4096
+
+ChainStore::~ChainStore()
+{
+    chain_store_destroyed = true;
+}
+
+uint32_t ChainStore::add_transaction(Transaction& txn, const int receiver, const long long amount, const bool coinbase,
+                                     const int sender)
+{
+    if (transaction_id.size() >= NO_STORE_INDEX)
+        throw runtime_error("Chain store is full of transactions");
+
+    const auto index = static_cast<uint32_t>(transaction_id.size());
+    transaction_id.push_back(txn.id);
+    transaction_sender.push_back(sender);
+    transaction_receiver.push_back(receiver);
+    transaction_amount.push_back(amount);
+    transaction_coinbase.push_back(coinbase);
+    transaction_object.push_back(&txn);
+    return index;
+}
+
+uint32_t ChainStore::add_block(Block& blk, const long long creation_time, const uint8_t flags)
+{
+    if (block_id.size() >= NO_STORE_INDEX)
+        throw runtime_error("Chain store is full of blocks");
+
+    const auto index = static_cast<uint32_t>(block_id.size());
+    block_id.push_back(blk.id);
+    block_parent.push_back(blk.parent_block ? blk.parent_block->store_index : NO_STORE_INDEX);
+    block_creation_time.push_back(creation_time);
+    block_flags.push_back(flags);
+    block_transactions_begin.push_back(NO_STORE_INDEX);
+    block_transactions_count.push_back(0);
+    block_object.push_back(&blk);
+    return index;
+}
+
+void ChainStore::release(const Transaction& txn)
+{
+    if (txn.store_index < transaction_object.size() && transaction_object[txn.store_index] == &txn)
+    {
+        transaction_object[txn.store_index] = nullptr;
+        released_transactions++;
+    }
+}
+
+void ChainStore::release(const Block& blk)
+{
+    if (blk.store_index < block_object.size() && block_object[blk.store_index] == &blk)
+    {
+        block_object[blk.store_index] = nullptr;
+        released_blocks++;
+    }
+}
+
+void ChainStore::seal_single(const Block& blk)
+{
+    if (block_transactions.size() + blk.transactions.size() >= NO_STORE_INDEX)
+        throw runtime_error("Chain store is full of blocks");
+
+    const uint32_t b = blk.store_index;
+    block_transactions_begin[b] = static_cast<uint32_t>(block_transactions.size());
+    block_transactions_count[b] = static_cast<uint32_t>(blk.transactions.size());
+    for (const auto& txn : blk.transactions)
+        block_transactions.push_back(txn->store_index);
+
+    // a block restored from a snapshot is sealed again, its row is already archived
+    if (block_flags[b] & BLOCK_ARCHIVED)
+        return;
+    block_flags[b] |= BLOCK_ARCHIVED;
+    const bool genesis = blk.parent_block == nullptr;
+    archive_block_id.push_back(blk.id);
+    archive_parent_id.push_back(genesis ? -1 : blk.parent_block->id);
+    archive_creation_time.push_back(block_creation_time[b]);
+    archive_transaction_count.push_back(block_transactions_count[b]);
+    archive_miner.push_back(genesis ? -1 : miner(b));
+}
+
+uint32_t ChainStore::seal(const Block& blk)
+{
+    if (sealed(blk.store_index))
+        return blk.store_index;
+
+    // unsealed ancestors from blk upwards, sealed from the oldest so the ranges follow the chain
+    vector<const Block*> pending;
+    const Block* temp_block = &blk;
+    while (temp_block != nullptr && !sealed(temp_block->store_index))
+    {
+        pending.push_back(temp_block);
+        temp_block = temp_block->parent_block.get();
+    }
+
+    for (auto it = pending.rbegin(); it != pending.rend(); ++it)
+        seal_single(**it);
+    return blk.store_index;
+}
+
+bool ChainStore::compact()
+{
+    // a small store is not worth the copy
+    const auto sparse = [](const uint32_t released, const size_t rows)
+    {
+        return released >= COMPACT_MIN_RELEASED && released >= rows - released;
+    };
+    if (!sparse(released_transactions, transaction_id.size()) && !sparse(released_blocks, block_id.size()))
+        return false;
+
+    // live rows keep their order, so ids still increase with the index
+    vector<uint32_t> transaction_index(transaction_id.size(), NO_STORE_INDEX);
+    uint32_t kept = 0;
+    for (uint32_t t = 0; t < transaction_id.size(); t++)
+    {
+        if (transaction_object[t] == nullptr)
+            continue;
+        transaction_index[t] = kept;
+        transaction_id[kept] = transaction_id[t];
+        transaction_sender[kept] = transaction_sender[t];
+        transaction_receiver[kept] = transaction_receiver[t];
+        transaction_amount[kept] = transaction_amount[t];
+        transaction_coinbase[kept] = transaction_coinbase[t];
+        transaction_object[kept] = transaction_object[t];
+        transaction_object[kept]->store_index = kept;
+        kept++;
+    }
+    transaction_id.resize(kept);
+    transaction_sender.resize(kept);
+    transaction_receiver.resize(kept);
+    transaction_amount.resize(kept);
+    transaction_coinbase.resize(kept);
+    transaction_object.resize(kept);
+    released_transactions = 0;
+
+    // a parent precedes its children, so its new index is known when a child is moved
+    vector<uint32_t> block_index(block_id.size(), NO_STORE_INDEX);
+    vector<uint32_t> transactions;
+    kept = 0;
+    for (uint32_t b = 0; b < block_id.size(); b++)
+    {
+        if (block_object[b] == nullptr)
+            continue;
+        block_index[b] = kept;
+        block_id[kept] = block_id[b];
+        block_parent[kept] = block_parent[b] == NO_STORE_INDEX ? NO_STORE_INDEX : block_index[block_parent[b]];
+        block_creation_time[kept] = block_creation_time[b];
+        block_flags[kept] = block_flags[b];
+        // the transactions of a live block are alive, it holds them
+        const uint32_t begin = block_transactions_begin[b];
+        const uint32_t count = block_transactions_count[b];
+        block_transactions_begin[kept] = begin == NO_STORE_INDEX ? NO_STORE_INDEX : static_cast<uint32_t>(transactions.size());
+        block_transactions_count[kept] = count;
+        for (uint32_t i = 0; begin != NO_STORE_INDEX && i < count; i++)
+            transactions.push_back(transaction_index[block_transactions[begin + i]]);
+        block_object[kept] = block_object[b];
+        block_object[kept]->store_index = kept;
+        kept++;
+    }
+    block_id.resize(kept);
+    block_parent.resize(kept);
+    block_creation_time.resize(kept);
+    block_flags.resize(kept);
+    block_transactions_begin.resize(kept);
+    block_transactions_count.resize(kept);
+    block_object.resize(kept);
+    block_transactions = std::move(transactions);
+    released_blocks = 0;
+    return true;
+}
+
+void ChainStore::clear()
+{
+    *this = ChainStore();
+    chain_store_destroyed = false;
+}
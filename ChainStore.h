@@ -0,0 +1,118 @@
+#ifndef CHAINSTORE_H
+#define CHAINSTORE_H
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+class Block;
+class Transaction;
+
+// index of a block or transaction that is not in the chain store
+#define NO_STORE_INDEX 0xffffffffu
+
+// block flags
+#define BLOCK_PRIVATE 1
+#define BLOCK_HONEST 2
+#define BLOCK_ARCHIVED 4
+
+/*
+ * Struct-of-arrays columns of all blocks and transactions, referenced by 32 bit indices.
+ * The store owns the payload: a Transaction object only keeps its id and index, a Block its id, the object links
+ * (parent, transactions, jumps) and the hash state, while sender, receiver, amount, creation time and flags live here.
+ * Objects get their index on construction and clear their object slot when freed.
+ * A block is sealed the first time a node validates it: its transactions, fixed from then on, are appended as a
+ * contiguous range of block_transactions, and the unsealed ancestors are sealed first. Chain walks in validation and
+ * in the stats phase read these columns instead of following the objects.
+ * Sealing also archives the block as one row (id, parent id, creation time, transaction count, miner) that outlives
+ * the object, so the stats phase can list chains whose blocks finality has freed. Once finality cuts the nodes' roots
+ * from their parents, compact drops the rows of freed objects, so the columns grow with the live objects and only the
+ * archive with the run.
+ * The store is cleared when a simulator is installed on the thread.
+ */
+
+class ChainStore
+{
+public:
+    // transaction columns
+    vector<long long> transaction_id;
+    vector<int32_t> transaction_sender;
+    vector<int32_t> transaction_receiver;
+    vector<long long> transaction_amount;
+    vector<uint8_t> transaction_coinbase;
+
+    // block columns, the parent of genesis and of a root cut from its parent is NO_STORE_INDEX, the range of an
+    // unsealed block begins at NO_STORE_INDEX
+    vector<long long> block_id;
+    vector<uint32_t> block_parent;
+    vector<long long> block_creation_time;
+    vector<uint8_t> block_flags;
+    vector<uint32_t> block_transactions_begin;
+    vector<uint32_t> block_transactions_count;
+
+    // transaction indices of all sealed blocks, one range per block
+    vector<uint32_t> block_transactions;
+
+    // archive of every sealed block in sealing order, parent and miner -1 for genesis
+    vector<long long> archive_block_id;
+    vector<long long> archive_parent_id;
+    vector<long long> archive_creation_time;
+    vector<uint32_t> archive_transaction_count;
+    vector<int32_t> archive_miner;
+
+    ~ChainStore();
+
+    uint32_t add_transaction(Transaction& txn, int receiver, long long amount, bool coinbase, int sender);
+    uint32_t add_block(Block& blk, long long creation_time, uint8_t flags);
+    // called by the destructors, the index may belong to a store cleared since
+    void release(const Transaction& txn);
+    void release(const Block& blk);
+
+    // index of blk, seals it and its unsealed ancestors first
+    uint32_t seal(const Block& blk);
+    // drops the rows of freed objects once they are at least as many as the live ones and gives the live objects
+    // their new indices, false if the store was left as it is
+    bool compact();
+
+    uint32_t block_count() const { return static_cast<uint32_t>(block_id.size()); }
+    uint32_t transaction_count() const { return static_cast<uint32_t>(transaction_id.size()); }
+    // first transaction index of block b, followed by the rest of its range
+    const uint32_t* transactions_of(const uint32_t b) const { return block_transactions.data() + block_transactions_begin[b]; }
+    // receiver of the coinbase transaction
+    int32_t miner(const uint32_t b) const { return transaction_receiver[block_transactions[block_transactions_begin[b]]]; }
+    // live block at index b, nullptr once freed
+    Block* block(const uint32_t b) const { return block_object[b]; }
+
+    void clear();
+
+    // calls f with every column, for memory accounting
+    template <typename F>
+    void for_each_column(F&& f) const
+    {
+        f(transaction_id); f(transaction_sender); f(transaction_receiver); f(transaction_amount);
+        f(transaction_coinbase); f(transaction_object);
+        f(block_id); f(block_parent); f(block_creation_time); f(block_flags); f(block_transactions_begin);
+        f(block_transactions_count); f(block_object); f(block_transactions);
+        f(archive_block_id); f(archive_parent_id); f(archive_creation_time); f(archive_transaction_count);
+        f(archive_miner);
+    }
+
+private:
+    // live object of each index, nullptr once freed
+    vector<Block*> block_object;
+    vector<Transaction*> transaction_object;
+    // freed objects whose rows were not dropped yet
+    uint32_t released_blocks = 0;
+    uint32_t released_transactions = 0;
+
+    bool sealed(uint32_t b) const { return block_transactions_begin[b] != NO_STORE_INDEX; }
+    void seal_single(const Block& blk);
+};
+
+// store of the simulation on this thread
+extern thread_local ChainStore chain_store;
+// set when the store of this thread is destroyed, objects freed later by other thread-locals skip their release
+extern thread_local bool chain_store_destroyed;
+
+#endif //CHAINSTORE_H
@@ -12,7 +12,7 @@ create_transaction_object::create_transaction_object(const int creator_node_id)
 }
 
 receive_transaction_object::receive_transaction_object(const int sender_node_id, const int receiver_node_id,
-                                                       const shared_ptr<Transaction>& txn)
+                                                       const object_ptr<Transaction>& txn)
 {
     this->sender_node_id = sender_node_id;
     this->receiver_node_id = receiver_node_id;
@@ -20,51 +20,53 @@ receive_transaction_object::receive_transaction_object(const int sender_node_id,
 }
 
 receive_block_object::receive_block_object(const int sender_node_id, const int receiver_node_id,
-                                           const shared_ptr<Block>& blk)
+                                           const object_ptr<Block>& blk)
 {
     this->sender_node_id = sender_node_id;
     this->receiver_node_id = receiver_node_id;
     this->blk = blk;
 }
 
-block_mined_object::block_mined_object(const int miner_node_id, const shared_ptr<Block>& blk)
+block_mined_object::block_mined_object(const int miner_node_id, const object_ptr<Block>& blk)
 {
     this->miner_node_id = miner_node_id;
     this->blk = blk;
 }
 
-receive_hash_object::receive_hash_object(long long block_hash,int sender_node_id, int receiver_node_id, const shared_ptr<Block>& blk)
+receive_hash_object::receive_hash_object(long long block_hash,int sender_node_id, int receiver_node_id, const object_ptr<Block>& blk)
 {
     this->sender_node_id= sender_node_id;
     this->receiver_node_id = receiver_node_id;
-    this->block_hash = block_hash; // dummy
+    this->block_hash = block_hash;
     this->blk = blk;
 }
 
 get_block_request_object::get_block_request_object(int sender_node_id, int receiver_node_id,
-    const shared_ptr<Block>& blk)
+    const object_ptr<Block>& blk)
 {
     this->sender_node_id = sender_node_id;
     this->receiver_node_id = receiver_node_id;
     this->blk = blk;
 }
 
-timer_expired_object::timer_expired_object(int node_id, const shared_ptr<Block>& blk)
+timer_expired_object::timer_expired_object(int node_id, const object_ptr<Block>& blk)
 {
     this->node_id = node_id;
     this->blk = blk;
 }
 
-release_private_object::release_private_object(int node_id,int counter)
+release_private_object::release_private_object(int node_id,int counter,long long height)
 {
     this->node_id = node_id;
     this->counter = counter;
+    this->height = height;
 }
 
 ostream& operator<<(ostream& os, const release_private_object& obj)
 {
     os << " Release private chain event: "<<endl;
     os << " node_id: " << obj.node_id << endl;
+    os << " height: " << obj.height << endl;
     return os;
 }
 
@@ -132,3 +134,12 @@ ostream& operator<<(ostream& os, const Event& e)
     std::visit([&os](auto& obj) { os << obj << endl; }, e.object);
     return os;
 }
+
+const char* event_type_name(const int type)
+{
+    static const char* names[NUMBER_OF_EVENT_TYPES] = {
+        "CREATE_TRANSACTION", "RECEIVE_TRANSACTION", "RECEIVE_BLOCK", "BLOCK_MINED", "RECEIVE_HASH",
+        "GET_BLOCK_REQUEST", "TIMER_EXPIRED", "RELEASE_PRIVATE"
+    };
+    return type >= 0 && type < NUMBER_OF_EVENT_TYPES ? names[type] : "UNKNOWN";
+}
@@ -14,6 +14,7 @@
 #define GET_BLOCK_REQUEST 5
 #define TIMER_EXPIRED 6
 #define RELEASE_PRIVATE 7
+#define NUMBER_OF_EVENT_TYPES 8
 
 #include <variant>
 #include <queue>
@@ -31,9 +32,9 @@ struct receive_transaction_object
 {
     int sender_node_id;
     int receiver_node_id;
-    shared_ptr<Transaction> txn;
+    object_ptr<Transaction> txn;
 
-    receive_transaction_object(int sender_node_id, int receiver_node_id, const shared_ptr<Transaction>& txn);
+    receive_transaction_object(int sender_node_id, int receiver_node_id, const object_ptr<Transaction>& txn);
     friend ostream& operator<<(ostream& os, const receive_transaction_object& obj);
 };
 
@@ -41,16 +42,16 @@ struct receive_block_object
 {
     int sender_node_id;
     int receiver_node_id;
-    shared_ptr<Block> blk;
-    receive_block_object(int sender_node_id, int receiver_node_id, const shared_ptr<Block>& blk);
+    object_ptr<Block> blk;
+    receive_block_object(int sender_node_id, int receiver_node_id, const object_ptr<Block>& blk);
     friend ostream& operator<<(ostream& os, const receive_block_object& obj);
 };
 
 struct block_mined_object
 {
     int miner_node_id;
-    shared_ptr<Block> blk;
-    explicit block_mined_object(int miner_node_id, const shared_ptr<Block>& blk);
+    object_ptr<Block> blk;
+    explicit block_mined_object(int miner_node_id, const object_ptr<Block>& blk);
     friend ostream& operator<<(ostream& os, const block_mined_object& obj);
 };
 
@@ -58,9 +59,9 @@ struct receive_hash_object
 {
     int sender_node_id;
     int receiver_node_id;
-    long long block_hash;
-    shared_ptr<Block> blk;
-    receive_hash_object(long long block_hash,int sender_node_id, int receiver_node_id, const shared_ptr<Block>& blk);
+    long long block_hash; // first 8 bytes of the block header hash
+    object_ptr<Block> blk;
+    receive_hash_object(long long block_hash,int sender_node_id, int receiver_node_id, const object_ptr<Block>& blk);
     friend ostream& operator<<(ostream& os, const receive_hash_object& obj);
 
 };
@@ -69,8 +70,8 @@ struct get_block_request_object
 {
     int sender_node_id;
     int receiver_node_id;
-    shared_ptr<Block> blk;
-    get_block_request_object(int sender_node_id, int receiver_node_id, const shared_ptr<Block>& blk);
+    object_ptr<Block> blk;
+    get_block_request_object(int sender_node_id, int receiver_node_id, const object_ptr<Block>& blk);
     friend ostream& operator<<(ostream& os, const get_block_request_object& obj);
 
 };
@@ -78,9 +79,9 @@ struct get_block_request_object
 struct timer_expired_object
 {
     int node_id;
-    shared_ptr<Block> blk;
+    object_ptr<Block> blk;
 
-    timer_expired_object(int node_id, const shared_ptr<Block>& blk);
+    timer_expired_object(int node_id, const object_ptr<Block>& blk);
     friend ostream& operator<<(ostream& os, const timer_expired_object& obj);
 };
 
@@ -88,8 +89,9 @@ struct release_private_object
 {
     int node_id;
     int counter;
+    long long height; // withheld blocks up to this height are published, LLONG_MAX for all
 
-    release_private_object(int node_id,int counter);
+    release_private_object(int node_id,int counter,long long height);
     friend ostream& operator<<(ostream& os, const release_private_object& obj);
 };
 
@@ -113,4 +115,7 @@ public:
 
 typedef priority_queue<Event, vector<Event>, greater<>> EQ;
 
+// name of an event type as used in reports, e.g. "RECEIVE_BLOCK"
+const char* event_type_name(int type);
+
 #endif //EVENT_H
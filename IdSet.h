@@ -0,0 +1,94 @@
+#ifndef IDSET_H
+#define IDSET_H
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Set of non-negative ids as a bitmap from the word of its lowest member up to the largest member, for the dedup sets
+ * of transaction ids. Transaction ids are dense over a run and these sets hold a large share of them (every transaction
+ * of a chain, or every transaction sent over a link), so one bit per id replaces a tree node of about 48 bytes per
+ * member. trim drops the words below an id once no lower id can be queried again, which keeps the bitmap bounded by
+ * the ids still alive instead of every id of the run.
+ * Copies are a flat memcpy, iteration is in increasing id order like set<long long>.
+ */
+class IdSet
+{
+    vector<uint64_t> words;
+    size_t first_word = 0; // word of id 0 to 63 is words[0 - first_word]
+    size_t members = 0;
+
+public:
+    size_t count(const long long id) const
+    {
+        const size_t word = static_cast<size_t>(id) >> 6;
+        return word >= first_word && word - first_word < words.size() && (words[word - first_word] >> (id & 63) & 1)
+            ? 1 : 0;
+    }
+
+    void insert(const long long id)
+    {
+        const size_t word = static_cast<size_t>(id) >> 6;
+        if (words.empty())
+            first_word = word;
+        else if (word < first_word)
+        {
+            words.insert(words.begin(), first_word - word, 0);
+            first_word = word;
+        }
+        if (word - first_word >= words.size())
+            words.resize(word - first_word + 1, 0);
+        const uint64_t bit = uint64_t(1) << (id & 63);
+        members += (words[word - first_word] & bit) == 0;
+        words[word - first_word] |= bit;
+    }
+
+    void erase(const long long id)
+    {
+        const size_t word = static_cast<size_t>(id) >> 6;
+        if (word < first_word || word - first_word >= words.size())
+            return;
+        const uint64_t bit = uint64_t(1) << (id & 63);
+        members -= (words[word - first_word] & bit) != 0;
+        words[word - first_word] &= ~bit;
+    }
+
+    // drops the members below lowest along with their words
+    void trim(const long long lowest)
+    {
+        const size_t word = static_cast<size_t>(lowest) >> 6;
+        if (word <= first_word)
+            return;
+        const size_t dropped = min(word - first_word, words.size());
+        for (size_t i = 0; i < dropped; i++)
+            members -= __builtin_popcountll(words[i]);
+        words.erase(words.begin(), words.begin() + dropped);
+        first_word = word;
+        const uint64_t below = (uint64_t(1) << (lowest & 63)) - 1;
+        if (!words.empty())
+        {
+            members -= __builtin_popcountll(words[0] & below);
+            words[0] &= ~below;
+        }
+    }
+
+    size_t size() const { return members; }
+    bool empty() const { return members == 0; }
+    // bitmap words, for memory accounting
+    const vector<uint64_t>& bitmap() const { return words; }
+
+    // calls f with every member in increasing order
+    template <typename F>
+    void for_each(F&& f) const
+    {
+        for (size_t word = 0; word < words.size(); word++)
+            for (uint64_t bits = words[word]; bits != 0; bits &= bits - 1)
+                f(static_cast<long long>((word + first_word) << 6 | __builtin_ctzll(bits)));
+    }
+};
+
+#endif //IDSET_H
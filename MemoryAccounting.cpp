@@ -0,0 +1,333 @@
+#include "MemoryAccounting.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_set>
+#include "Snapshot.h"
+#include "ChainStore.h"
+
+const char* memory_subsystem_name(const int subsystem)
+{
+    static const char* names[MEMORY_SUBSYSTEMS] = {
+        "nodes", "leaves", "leaf_balances", "leaf_transaction_ids", "links", "link_sent_sets", "block_ids_in_tree",
+        "hashes_seen", "timers", "mempool", "local_storage", "chain_stats", "blocks", "transactions", "event_queue",
+        "chain_store"
+    };
+    return subsystem >= 0 && subsystem < MEMORY_SUBSYSTEMS ? names[subsystem] : "unknown";
+}
+
+const char* memory_class_name(const int node_class)
+{
+    static const char* names[MEMORY_CLASSES] = {"honest", "malicious", "ringmaster", "shared"};
+    return node_class >= 0 && node_class < MEMORY_CLASSES ? names[node_class] : "unknown";
+}
+
+int memory_class(const Node& node)
+{
+    if (node.ringmaster()) return MEMORY_RINGMASTER;
+    if (node.malicious()) return MEMORY_MALICIOUS;
+    return MEMORY_HONEST;
+}
+
+memory_breakdown::memory_breakdown()
+{
+    for (auto& row : bytes)
+        row.fill(0);
+    nodes.fill(0);
+}
+
+uint64_t memory_breakdown::subsystem_total(const int subsystem) const
+{
+    uint64_t total = 0;
+    for (const uint64_t value : bytes[subsystem])
+        total += value;
+    return total;
+}
+
+uint64_t memory_breakdown::class_total(const int node_class) const
+{
+    uint64_t total = 0;
+    for (const auto& row : bytes)
+        total += row[node_class];
+    return total;
+}
+
+uint64_t memory_breakdown::total() const
+{
+    uint64_t total = 0;
+    for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEMS; subsystem++)
+        total += subsystem_total(subsystem);
+    return total;
+}
+
+// chunk glibc malloc returns for a request of size bytes
+static uint64_t chunk(uint64_t size)
+{
+    size = (size + 8 + 15) & ~static_cast<uint64_t>(15);
+    return size < 32 ? 32 : size;
+}
+
+// block, transaction or leaf, a pool slot or a make_shared chunk depending on the allocation policy
+template <typename T>
+static uint64_t shared_object_bytes()
+{
+    return Allocation::object_bytes<T>();
+}
+
+// set or map with n elements of type Value
+template <typename Value>
+static uint64_t tree_bytes(const size_t n)
+{
+    return n * chunk(32 + sizeof(Value));
+}
+
+template <typename T>
+static uint64_t vector_bytes(const vector<T>& v)
+{
+    return v.capacity() > 0 ? chunk(v.capacity() * sizeof(T)) : 0;
+}
+
+// libstdc++ deque: 512 byte buffers and a map of buffer pointers, at least 8
+template <typename T>
+static uint64_t deque_bytes(const size_t n)
+{
+    const size_t per_buffer = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+    const size_t buffers = n / per_buffer + 1;
+    const size_t map_size = buffers + 2 > 8 ? buffers + 2 : 8;
+    return buffers * chunk(per_buffer * sizeof(T)) + chunk(map_size * sizeof(T*));
+}
+
+static void ledger_bytes(const Ledger& ledger, uint64_t& balances, uint64_t& transaction_ids)
+{
+    balances += vector_bytes(ledger.balance);
+    transaction_ids += vector_bytes(ledger.transaction_ids.bitmap());
+}
+
+// a shared ledger is counted once after all nodes, with the shared bytes
+static uint64_t leaf_bytes(const LeafNode& leaf, array<uint64_t, MEMORY_SUBSYSTEMS>& bytes,
+                           unordered_set<const Ledger*>& shared_ledgers)
+{
+    if (leaf.ledger->shared)
+    {
+        shared_ledgers.insert(leaf.ledger.get());
+        return shared_object_bytes<LeafNode>();
+    }
+    ledger_bytes(*leaf.ledger, bytes[MEMORY_LEAF_BALANCES], bytes[MEMORY_LEAF_TRANSACTION_IDS]);
+    return shared_object_bytes<LeafNode>() + shared_object_bytes<Ledger>();
+}
+
+static uint64_t link_sent_bytes(const Link& link)
+{
+    return vector_bytes(link.transactions_sent.bitmap()) + tree_bytes<long long>(link.hash_sent.size())
+        + tree_bytes<int>(link.release_private_sent.size());
+}
+
+// every block reachable from blk that was not visited yet
+static void visit_chain(const Block* blk, unordered_set<const Block*>& blocks)
+{
+    while (blk != nullptr && blocks.insert(blk).second)
+        blk = blk->parent_block.get();
+}
+
+memory_breakdown account_memory(const Network& network, const EQ& queue)
+{
+    memory_breakdown memory;
+    unordered_set<const Block*> blocks;
+    unordered_set<const Transaction*> transactions;
+    unordered_set<const Ledger*> shared_ledgers;
+
+    for (const auto& node : network.nodes)
+    {
+        const int node_class = memory_class(node);
+        array<uint64_t, MEMORY_SUBSYSTEMS> bytes{};
+        memory.nodes[node_class]++;
+
+        bytes[MEMORY_NODES] += sizeof(Node);
+        for (const RandomStream* stream : {&node.latency_rng, &node.mining_rng, &node.transaction_rng, &node.topology_rng})
+            bytes[MEMORY_NODES] += vector_bytes(stream->uniform_buffer()) + vector_bytes(stream->exponential_buffer());
+
+        bytes[MEMORY_LEAVES] += tree_bytes<object_ptr<LeafNode>>(node.leaves.size());
+        bool private_leaf_in_leaves = false;
+        for (const auto& leaf : node.leaves)
+        {
+            bytes[MEMORY_LEAVES] += leaf_bytes(*leaf, bytes, shared_ledgers);
+            private_leaf_in_leaves = private_leaf_in_leaves || leaf == node.private_leaf;
+            visit_chain(leaf->block.get(), blocks);
+        }
+        if (node.private_leaf && !private_leaf_in_leaves)
+        {
+            bytes[MEMORY_LEAVES] += leaf_bytes(*node.private_leaf, bytes, shared_ledgers);
+            visit_chain(node.private_leaf->block.get(), blocks);
+        }
+
+        bytes[MEMORY_LINKS] += vector_bytes(node.peers) + vector_bytes(node.malicious_peers);
+        for (const auto& link : node.peers)
+            bytes[MEMORY_LINK_SENT_SETS] += link_sent_bytes(link);
+        for (const auto& link : node.malicious_peers)
+            bytes[MEMORY_LINK_SENT_SETS] += link_sent_bytes(link);
+
+        bytes[MEMORY_BLOCK_IDS_IN_TREE] += tree_bytes<pair<const long long, long long>>(node.block_ids_in_tree.size());
+        bytes[MEMORY_HASHES_SEEN] += tree_bytes<long long>(node.hashes_seen.size());
+
+        bytes[MEMORY_TIMERS] += tree_bytes<pair<const long long, Timer>>(node.timers.size());
+        for (const auto& [block_id, timer] : node.timers)
+        {
+            bytes[MEMORY_TIMERS] += deque_bytes<int>(timer.available_senders.size())
+                + tree_bytes<int>(timer.tried_senders.size());
+            visit_chain(timer.blk.get(), blocks);
+        }
+
+        bytes[MEMORY_MEMPOOL] += deque_bytes<object_ptr<Transaction>>(node.mempool.size())
+            + tree_bytes<long long>(node.transactions_in_pool.size());
+        // the mempool queue cannot be iterated, its transactions are also referenced by events or blocks
+
+        bytes[MEMORY_LOCAL_STORAGE] += tree_bytes<object_ptr<Block>>(node.local_storage.size());
+        for (const auto& blk : node.local_storage)
+            visit_chain(blk.get(), blocks);
+
+        bytes[MEMORY_CHAIN_STATS] += vector_bytes(node.chain.longest_chain)
+            + deque_bytes<object_ptr<Block>>(node.withheld_blocks.size()) + vector_bytes(node.chain.pruned_fork_tips);
+        for (const auto& blk : node.withheld_blocks)
+            visit_chain(blk.get(), blocks);
+        visit_chain(node.withheld_fork_point.get(), blocks);
+        visit_chain(node.root.get(), blocks);
+        bytes[MEMORY_LEAVES] += shared_object_bytes<Ledger>();
+        ledger_bytes(*node.root_ledger, bytes[MEMORY_LEAF_BALANCES], bytes[MEMORY_LEAF_TRANSACTION_IDS]);
+
+        for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEMS; subsystem++)
+            memory.bytes[subsystem][node_class] += bytes[subsystem];
+    }
+    memory.bytes[MEMORY_NODES][MEMORY_SHARED] += (network.nodes.capacity() - network.nodes.size()) * sizeof(Node);
+    for (const Ledger* ledger : shared_ledgers)
+    {
+        memory.bytes[MEMORY_LEAVES][MEMORY_SHARED] += shared_object_bytes<Ledger>();
+        ledger_bytes(*ledger, memory.bytes[MEMORY_LEAF_BALANCES][MEMORY_SHARED],
+                     memory.bytes[MEMORY_LEAF_TRANSACTION_IDS][MEMORY_SHARED]);
+    }
+
+    const vector<Event>& events = event_heap(queue);
+    memory.bytes[MEMORY_EVENT_QUEUE][MEMORY_SHARED] += vector_bytes(events);
+    chain_store.for_each_column([&memory](const auto& column)
+    {
+        memory.bytes[MEMORY_CHAIN_STORE][MEMORY_SHARED] += vector_bytes(column);
+    });
+    for (const auto& e : events)
+    {
+        visit(
+            [&](const auto& obj)
+            {
+                using T = decay_t<decltype(obj)>;
+                if constexpr (is_same_v<T, receive_transaction_object>)
+                    transactions.insert(obj.txn.get());
+                else if constexpr (!is_same_v<T, create_transaction_object> && !is_same_v<T, release_private_object>)
+                    visit_chain(obj.blk.get(), blocks);
+            },
+            e.object);
+    }
+
+    for (const Block* blk : blocks)
+    {
+        memory.bytes[MEMORY_BLOCKS][MEMORY_SHARED] += shared_object_bytes<Block>() + vector_bytes(blk->transactions)
+            + vector_bytes(blk->jumps);
+        for (const auto& txn : blk->transactions)
+            transactions.insert(txn.get());
+    }
+    memory.bytes[MEMORY_TRANSACTIONS][MEMORY_SHARED] += transactions.size() * shared_object_bytes<Transaction>();
+    return memory;
+}
+
+long long process_memory_kb(const string& field)
+{
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line))
+    {
+        if (line.compare(0, field.size() + 1, field + ":") != 0)
+            continue;
+        istringstream value(line.substr(field.size() + 1));
+        long long kb;
+        if (value >> kb)
+            return kb;
+    }
+    return -1;
+}
+
+void write_memory_sample_header(ostream& os)
+{
+    os << "time,rss_kb,accounted_bytes";
+    for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEMS; subsystem++)
+        os << "," << memory_subsystem_name(subsystem);
+    for (int node_class = 0; node_class < MEMORY_CLASSES; node_class++)
+        os << "," << memory_class_name(node_class);
+    os << endl;
+}
+
+void write_memory_sample(ostream& os, const long long time, const memory_breakdown& memory)
+{
+    os << time << "," << process_memory_kb("VmRSS") << "," << memory.total();
+    for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEMS; subsystem++)
+        os << "," << memory.subsystem_total(subsystem);
+    for (int node_class = 0; node_class < MEMORY_CLASSES; node_class++)
+        os << "," << memory.class_total(node_class);
+    os << "\n";
+}
+
+void write_memory_breakdown(ostream& os, const memory_breakdown& memory)
+{
+    os << "subsystem";
+    for (int node_class = 0; node_class < MEMORY_CLASSES; node_class++)
+        os << "," << memory_class_name(node_class);
+    os << ",total" << endl;
+    for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEMS; subsystem++)
+    {
+        os << memory_subsystem_name(subsystem);
+        for (int node_class = 0; node_class < MEMORY_CLASSES; node_class++)
+            os << "," << memory.bytes[subsystem][node_class];
+        os << "," << memory.subsystem_total(subsystem) << endl;
+    }
+    os << "total";
+    for (int node_class = 0; node_class < MEMORY_CLASSES; node_class++)
+        os << "," << memory.class_total(node_class);
+    os << "," << memory.total() << endl;
+    os << "node_count";
+    for (int node_class = 0; node_class < MEMORY_CLASSES; node_class++)
+        os << "," << memory.nodes[node_class];
+    os << "," << memory.nodes[MEMORY_HONEST] + memory.nodes[MEMORY_MALICIOUS] + memory.nodes[MEMORY_RINGMASTER]
+        << endl;
+    // of the whole process, in bytes in the total column
+    const long long rss_kb = process_memory_kb("VmRSS");
+    const long long peak_kb = process_memory_kb("VmHWM");
+    os << "process_rss,,,,," << (rss_kb < 0 ? -1 : rss_kb * 1024) << endl;
+    os << "process_peak_rss,,,,," << (peak_kb < 0 ? -1 : peak_kb * 1024) << endl;
+}
+
+void print_memory_summary(ostream& os, const memory_breakdown& memory)
+{
+    const double mb = 1024.0 * 1024.0;
+    os << " Memory accounted: " << fixed << setprecision(1) << static_cast<double>(memory.total()) / mb << " MB";
+    for (int node_class = 0; node_class < MEMORY_CLASSES; node_class++)
+        os << ", " << memory_class_name(node_class) << " " << static_cast<double>(memory.class_total(node_class)) / mb;
+    os << endl;
+
+    // three largest subsystems
+    array<int, MEMORY_SUBSYSTEMS> order;
+    for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEMS; subsystem++)
+        order[subsystem] = subsystem;
+    sort(order.begin(), order.end(), [&memory](const int a, const int b)
+    {
+        return memory.subsystem_total(a) > memory.subsystem_total(b);
+    });
+    os << "  largest:";
+    for (int i = 0; i < 3; i++)
+        os << " " << memory_subsystem_name(order[i]) << " " << static_cast<double>(memory.subsystem_total(order[i])) / mb
+            << " MB" << (i < 2 ? "," : "");
+    os << endl;
+
+    const long long rss_kb = process_memory_kb("VmRSS");
+    const long long peak_kb = process_memory_kb("VmHWM");
+    if (rss_kb >= 0 && peak_kb >= 0)
+        os << "  process RSS " << static_cast<double>(rss_kb) / 1024 << " MB, peak RSS " << static_cast<double>(peak_kb) / 1024
+            << " MB" << endl;
+    os << defaultfloat << setprecision(6);
+}
@@ -0,0 +1,73 @@
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include "Network.h"
+
+using namespace std;
+
+/*
+ * Heap usage of the simulation state by subsystem and node class, estimated by walking the structures.
+ * Every allocation is counted as the chunk glibc malloc hands out for it (8 byte header, 16 byte alignment),
+ * tree sets and maps as one 32 byte node header plus the value per element, deques by their 512 byte buffers
+ * and vectors by their capacity. Blocks, transactions and leaves count as one slot of their pool, or one make_shared
+ * chunk with the shared_ptr policy (Allocation.h); free pool slots are not counted. Blocks, transactions and the event
+ * queue are shared by all nodes and counted once, in the shared class.
+ */
+
+// node classes, a ringmaster is not counted as malicious
+#define MEMORY_HONEST 0
+#define MEMORY_MALICIOUS 1
+#define MEMORY_RINGMASTER 2
+#define MEMORY_SHARED 3
+#define MEMORY_CLASSES 4
+
+// subsystems
+#define MEMORY_NODES 0 // Node objects
+#define MEMORY_LEAVES 1 // LeafNode and Ledger objects and the leaf sets, root ledgers included
+#define MEMORY_LEAF_BALANCES 2 // balance vector of every leaf, shared ledgers once
+#define MEMORY_LEAF_TRANSACTION_IDS 3 // transaction id set of every leaf
+#define MEMORY_LINKS 4 // peer and overlay link vectors
+#define MEMORY_LINK_SENT_SETS 5 // sent transactions, hashes and releases of every link
+#define MEMORY_BLOCK_IDS_IN_TREE 6
+#define MEMORY_HASHES_SEEN 7
+#define MEMORY_TIMERS 8 // timer map with the senders of each timer
+#define MEMORY_MEMPOOL 9 // mempool queue and transactions_in_pool
+#define MEMORY_LOCAL_STORAGE 10 // blocks waiting for their parent
+#define MEMORY_CHAIN_STATS 11 // longest chain ids, the withheld segment and the pruned fork tips
+#define MEMORY_BLOCKS 12 // shared: block objects and their transaction vectors
+#define MEMORY_TRANSACTIONS 13 // shared: transaction objects
+#define MEMORY_EVENT_QUEUE 14 // shared: heap array of the event queue
+#define MEMORY_CHAIN_STORE 15 // shared: block and transaction columns and the block archive of the chain store
+#define MEMORY_SUBSYSTEMS 16
+
+const char* memory_subsystem_name(int subsystem);
+const char* memory_class_name(int node_class);
+int memory_class(const Node& node);
+
+struct memory_breakdown
+{
+    array<array<uint64_t, MEMORY_CLASSES>, MEMORY_SUBSYSTEMS> bytes;
+    array<long long, MEMORY_CLASSES> nodes; // number of nodes in each class
+
+    memory_breakdown();
+    uint64_t subsystem_total(int subsystem) const;
+    uint64_t class_total(int node_class) const;
+    uint64_t total() const;
+};
+
+memory_breakdown account_memory(const Network& network, const EQ& queue);
+
+// a field of /proc/self/status in kB, e.g. "VmRSS" or "VmHWM" (peak), -1 where unavailable
+long long process_memory_kb(const string& field);
+
+// time series rows: simulation time, process RSS, accounted total, every subsystem and every class
+void write_memory_sample_header(ostream& os);
+void write_memory_sample(ostream& os, long long time, const memory_breakdown& memory);
+// subsystem x class table with totals, followed by the current and peak RSS of the process
+void write_memory_breakdown(ostream& os, const memory_breakdown& memory);
+void print_memory_summary(ostream& os, const memory_breakdown& memory);
+
+#endif //MEMORYACCOUNTING_H
@@ -1,8 +1,27 @@
 #include "Network.h"
 
 #include "Simulator.h"
+#include "ProofOfWork.h"
+#include "Profiler.h"
+#include "Strategy.h"
+#include "ChainStore.h"
+#include "Propagation.h"
+#include "Probes.h"
 
-int Node::node_ticket = 0;
+thread_local int Node::node_ticket = 0;
+
+// network of the simulation running on this thread
+static thread_local Network* active_network = nullptr;
+
+void node_columns::resize(const size_t n)
+{
+    fast.resize(n, false);
+    malicious.resize(n, false);
+    ringmaster.resize(n, false);
+    currently_mining.resize(n, false);
+    hashing_power.resize(n, 0);
+    strategy.resize(n, STRATEGY_HONEST);
+}
 
 Link::Link(const int peer, const int propagation_delay, const long long link_speed)
 {
@@ -15,30 +34,48 @@ Link::Link(const int peer, const int propagation_delay, const long long link_spe
 Node::Node()
 {
     id = node_ticket++;
-    fast = false;
-    malicious = false;
-    ringmaster = false;
-    currently_mining = false;
+    latency_rng = RandomStream(global_seed, id, RNG_LINK_LATENCY);
+    mining_rng = RandomStream(global_seed, id, RNG_MINING_TIME);
+    transaction_rng = RandomStream(global_seed, id, RNG_TRANSACTION);
+    topology_rng = RandomStream(global_seed, id, RNG_TOPOLOGY);
+    columns = nullptr;
 
     peers.reserve(6);
     malicious_peers.reserve(6);
 
-    genesis = nullptr;
+    root = nullptr;
+    root_ledger = nullptr;
+    root_blocks_mined = 0;
     private_leaf = nullptr;
+    withheld_fork_point = nullptr;
+    withheld_partially_released = false;
+
+    finalized_height = 0;
+    block_watermark = 0;
 
     transactions_received = 0;
     blocks_received = 0;
 }
 
+void Node::reset_ticket()
+{
+    node_ticket = 0;
+}
+
 void Node::create_transaction()
 {
+    NodeMethodScope scope(NODE_CREATE_TRANSACTION);
     // randomly choose amount and receiver
-    int receiver = uniform_distribution(0, number_of_nodes - 1);
-    const int amount = uniform_distribution(transaction_amount_min, transaction_amount_max);
+    int receiver = uniform_distribution(transaction_rng, 0, number_of_nodes - 1);
+    const int amount = uniform_distribution(transaction_rng, transaction_amount_min, transaction_amount_max);
 
-    const auto t = make_shared<Transaction>(receiver,amount,false,id);
-    mempool.push(t);
-    transactions_in_pool.insert(t->id);
+    const auto t = make_object<Transaction>(receiver,amount,false,id);
+    // nodes without hashing power never mine, they keep no mempool
+    if (hashing_power() != 0)
+    {
+        mempool.push(t);
+        transactions_in_pool.insert(t->id);
+    }
 
     l.log<<"Time "<< simulation_time << ": Node "<<id<<" created Transaction " << *t <<endl;
     // send to all peers
@@ -46,14 +83,14 @@ void Node::create_transaction()
         send_transaction_to_link(t,x);
 
     // if free start mining
-    if ( !currently_mining) mine_block();
+    if ( !currently_mining()) mine_block();
 }
 
-void Node::send_transaction_to_link(const shared_ptr<Transaction>& txn, Link& link) const
+void Node::send_transaction_to_link(const object_ptr<Transaction>& txn, Link& link)
 {
     // Compute link latency
     const long long latency = link.propagation_delay + transaction_size/link.link_speed + \
-    exponential_distribution(static_cast<double>(queuing_delay_constant)/static_cast<double>(link.link_speed));
+    exponential_distribution(latency_rng, static_cast<double>(queuing_delay_constant)/static_cast<double>(link.link_speed));
 
     // send transaction by creating receive transaction event for recipient
     link.transactions_sent.insert(txn->id);
@@ -63,9 +100,12 @@ void Node::send_transaction_to_link(const shared_ptr<Transaction>& txn, Link& li
 
 void Node::receive_transaction(const receive_transaction_object& obj)
 {
+    NodeMethodScope scope(NODE_RECEIVE_TRANSACTION);
     transactions_received++;
     // add transaction to the mempool if not present
-    if (transactions_in_pool.count(obj.txn->id)==0)
+    if (hashing_power() == 0)
+        l.log << "Time "<< simulation_time <<": Node " << id << " received transaction "<<obj.txn->id<<" from " << obj.sender_node_id<<endl;
+    else if (transactions_in_pool.count(obj.txn->id)==0)
     {
         transactions_in_pool.insert(obj.txn->id);
         mempool.push(obj.txn);
@@ -73,9 +113,9 @@ void Node::receive_transaction(const receive_transaction_object& obj)
     }
 
     // if free start mining
-    if (!currently_mining) mine_block();
+    if (!currently_mining()) mine_block();
 
-    if (malicious)
+    if (malicious())
     {
         for (Link& x : malicious_peers)
         {
@@ -97,17 +137,21 @@ void Node::receive_transaction(const receive_transaction_object& obj)
     }
 }
 
-void Node::send_get_to_link(const shared_ptr<Block>& blk, Link &link) const
+void Node::send_get_to_link(const object_ptr<Block>& blk, Link &link)
 {
     get_block_request_object gobj(id,link.peer,blk);
     const long long latency = link.propagation_delay + get_message_size/link.link_speed + \
-    exponential_distribution(static_cast<double>(queuing_delay_constant)/static_cast<double>(link.link_speed));
+    exponential_distribution(latency_rng, static_cast<double>(queuing_delay_constant)/static_cast<double>(link.link_speed));
     event_queue.emplace(simulation_time + latency,GET_BLOCK_REQUEST,gobj);
 }
 
 void Node::receive_hash(const receive_hash_object &obj)
 {
-    if (block_ids_in_tree.count(obj.blk->id) == 1)
+    NodeMethodScope scope(NODE_RECEIVE_HASH);
+    if (knows_block(obj.blk->id))
+        return;
+    // announcements that do not match the block header are ignored
+    if (obj.block_hash != compute_hash(obj.blk))
         return;
 
     if (hashes_seen.count(obj.blk->id) == 0)
@@ -117,7 +161,7 @@ void Node::receive_hash(const receive_hash_object &obj)
         Link to_send_link(1,1,1);
         Network& network = Network::getInstance();
         // if attacker overlay exists send through that
-        if (malicious && network.nodes[obj.sender_node_id].malicious)
+        if (malicious() && network.columns.malicious[obj.sender_node_id])
         {
             for (const auto& link: malicious_peers)
                 if (link.peer == obj.sender_node_id)
@@ -166,8 +210,10 @@ void Node::receive_hash(const receive_hash_object &obj)
 
 void Node::timer_expired(const timer_expired_object& obj)
 {
+    NodeMethodScope scope(NODE_TIMER_EXPIRED);
     auto it = timers.find(obj.blk->id);
     if (it == timers.end()) return;
+    SIM_PROBE4(timer_expire, id, obj.blk->id, simulation_time, it->second.current_sender); // detail: peer that failed
     if (it->second.available_senders.empty())
     {
         it->second.is_running = false;
@@ -182,12 +228,14 @@ void Node::timer_expired(const timer_expired_object& obj)
         {
             link.failed++;
             to_punish_link = link;
+            SIM_PROBE4(peer_punish, id, obj.blk->id, simulation_time, link.peer);
             break;
         }
     }
 
     if (to_punish_link.failed > 3 && mitigation)
     {
+        SIM_PROBE4(peer_drop, id, obj.blk->id, simulation_time, it->second.current_sender);
         // Remove the link from peers if failed count exceeds 10.
         peers.erase(
             std::remove_if(peers.begin(), peers.end(), [&](const auto& link) {
@@ -198,11 +246,11 @@ void Node::timer_expired(const timer_expired_object& obj)
 
         // Add random peer
         Network& network = Network::getInstance();
-        int new_node = choose_neighbours_values(network.honest_node_ids,1 , {id})[0];
+        int new_node = choose_neighbours_values(topology_rng, network.honest_node_ids,1 , {id})[0];
 
-        int link_speed = network.nodes[id].fast && network.nodes[new_node].fast ? 100 * 1000 : 5 * 1000; // bits per millisecond
+        int link_speed = network.columns.fast[id] && network.columns.fast[new_node] ? 100 * 1000 : 5 * 1000; // bits per millisecond
 
-        int propagation_delay = uniform_distribution(propagation_delay_min,propagation_delay_max);
+        int propagation_delay = uniform_distribution(topology_rng, propagation_delay_min,propagation_delay_max);
         network.nodes[id].peers.emplace_back(new_node, propagation_delay, link_speed);
         network.nodes[new_node].peers.emplace_back(id, propagation_delay, link_speed);
     }
@@ -223,7 +271,7 @@ void Node::timer_expired(const timer_expired_object& obj)
     Link to_send_link(1,1,1);
     Network& network = Network::getInstance();
     // if attacker overlay exists send through that
-    if (malicious && network.nodes[next_sender].malicious)
+    if (malicious() && network.columns.malicious[next_sender])
     {
         for (const auto& link: malicious_peers)
             if (link.peer ==next_sender)
@@ -246,8 +294,18 @@ void Node::timer_expired(const timer_expired_object& obj)
 
 void Node::receive_block(const receive_block_object& obj)
 {
-    // check if block already present
-    if (block_ids_in_tree.count(obj.blk->id) == 1)
+    dispatch_strategy(strategy(), [&](auto policy) { receive_block_as<decltype(policy)>(obj); });
+}
+
+template <typename Strategy>
+void Node::receive_block_as(const receive_block_object& obj)
+{
+    NodeMethodScope scope(NODE_RECEIVE_BLOCK);
+    // check if block already present, or final or dead
+    if (knows_block(obj.blk->id))
+        return;
+    // siblings of final blocks are on dead forks, like every block that does not descend from the root
+    if (obj.blk->parent_block->id < block_watermark || !is_ancestor(root.get(), obj.blk.get()))
         return;
 
     blocks_received++;
@@ -262,7 +320,7 @@ void Node::receive_block(const receive_block_object& obj)
     }
 
     // if validated and added to the longest chain, re-start mining on longest chain
-    if (validate_and_add_block(obj.blk))
+    if (validate_and_add_block_as<Strategy>(obj.blk))
     {
         l.log << "Time "<< simulation_time <<": Node " << id << " block  "<<obj.blk->id<< " extended longest chain" << endl;
 
@@ -271,61 +329,93 @@ void Node::receive_block(const receive_block_object& obj)
         if (it != timers.end()) timers.erase(it);
 
 
-        if (!malicious)
+        if (!Strategy::attacker(*this))
         {
-            mine_block();
+            mine_block_as<Strategy>();
             return;
         }
 
-        if (selfish_mining && ringmaster && obj.blk->is_private)
+        if (Strategy::mines_privately(*this) && obj.blk->is_private())
         {
-            mine_block();
+            mine_block_as<Strategy>();
             return;
         }
 
-        if (selfish_mining && ringmaster && !obj.blk->is_private)
+        if (Strategy::mines_privately(*this) && !obj.blk->is_private())
         {
             long long global_length = (*leaves.begin())->length;
             long long private_length = private_leaf==nullptr? 0 : private_leaf->length;
 
-            printf("Global : %lld Private %lld Generated by %d  block id : %lld parend id: %lld \n",global_length,private_length,(*obj.blk->transactions.begin())->receiver, obj.blk->id,obj.blk->parent_block->id);
+            *console << "Global : " << global_length << " Private " << private_length << " Generated by "
+                << (*obj.blk->transactions.begin())->receiver() << "  block id : " << obj.blk->id << " parend id: "
+                << obj.blk->parent_block->id << " \n";
 
-            if (global_length == private_length -1 || global_length == private_length)
+            const long long release_height = Strategy::release_height(global_length, private_length);
+            if (release_height == LLONG_MAX)
             {
                 global_send_private_counter++;
                 long long private_leaf_id = private_leaf == nullptr? -1 : private_leaf->block->id;
                 release_private(global_send_private_counter);
-                printf("released private chain, private_leaf: %lld  honest_block: %lld \n", private_leaf_id, obj.blk->id);
+                *console << "released private chain, private_leaf: " << private_leaf_id << "  honest_block: "
+                    << obj.blk->id << " \n";
                 // mine_block();
             }
+            // publish the withheld blocks up to the honest tip and keep the rest
+            else if (release_height >= 0 && private_leaf != nullptr &&
+                     !withheld_blocks.empty() && withheld_blocks.front()->height <= release_height)
+            {
+                global_send_private_counter++;
+                release_private(global_send_private_counter, release_height);
+                l.log << "Time " << simulation_time << ": Node " << id << " released private chain up to height "
+                    << release_height << " after honest block " << obj.blk->id << endl;
+            }
         }
     }
 
+    // a block stored before it was received again with its parent may have become a root without one since
     for (auto it = local_storage.begin(); it != local_storage.end(); ++it) {
-        if ((*it)->parent_block->id == obj.blk->id) {
+        if ((*it)->parent_block != nullptr && (*it)->parent_block->id == obj.blk->id) {
             l.log<< "Time "<< simulation_time <<": Node " << id << " retreived block "<<(*it)->id<<" from storage"<<endl;
             receive_block_object robj(obj.sender_node_id,obj.receiver_node_id,*it);
-            receive_block(robj);
-            local_storage.erase(it);  // Erases the shared_ptr from the set.
+            // erased first, pruning while the block is added may change the storage
+            local_storage.erase(it);
+            receive_block_as<Strategy>(robj);
             break;
         }
     }
 }
 
-bool Node::validate_and_add_block(shared_ptr<Block> blk)
+bool Node::validate_and_add_block(object_ptr<Block> blk)
+{
+    bool extended = false;
+    dispatch_strategy(strategy(), [&](auto policy) { extended = validate_and_add_block_as<decltype(policy)>(blk); });
+    return extended;
+}
+
+template <typename Strategy>
+bool Node::validate_and_add_block_as(object_ptr<Block> blk)
 {
-    vector<long long > temp_balance;
-    set<long long > temp_transaction_ids;
+    NodeMethodScope scope(NODE_VALIDATE_AND_ADD_BLOCK);
+    const ChainStore& store = chain_store;
     long long temp_length =1;
+    long long temp_blocks_mined = 0;
     const auto it = find_if(leaves.begin(),leaves.end(),\
-            [&blk](const shared_ptr<LeafNode>& leaf){return blk->parent_block->id == leaf->block->id;});
+            [&blk](const object_ptr<LeafNode>& leaf){return blk->parent_block->id == leaf->block->id;});
 
+    // the ledger of a block another honest node already validated is valid for every node
+    object_ptr<Ledger> ledger = shares_ledgers() ? find_shared_ledger(blk->id) : nullptr;
+    const bool validated = ledger != nullptr;
+    if (!validated)
+        ledger = make_object<Ledger>(blk->id);
+    vector<long long>& temp_balance = ledger->balance;
+    IdSet& temp_transaction_ids = ledger->transaction_ids;
 
-    if (selfish_mining && malicious && private_leaf != nullptr && blk->is_private )
+    if (Strategy::withholds(*this) && private_leaf != nullptr && blk->is_private() )
     {
-        temp_balance = private_leaf->balance;
-        temp_transaction_ids = private_leaf->transaction_ids;
+        temp_balance = private_leaf->ledger->balance;
+        temp_transaction_ids = private_leaf->ledger->transaction_ids;
         temp_length = private_leaf->length+1;
+        temp_blocks_mined = private_leaf->blocks_mined;
     }
     else
     {
@@ -333,77 +423,110 @@ bool Node::validate_and_add_block(shared_ptr<Block> blk)
         // if parent not a leaf
         if (it == leaves.end())
         {
-            temp_balance.resize(number_of_nodes,0);
-
-            // traverse the chain till genesis and get balance and transaction ids
-            auto temp_ptr = blk->parent_block;
-            while (temp_ptr)
+            // traverse the chain till the root through the store columns and get balance and transaction ids,
+            // the chain up to the root is summed up in its ledger
+            if (!validated)
+            {
+                temp_balance = root_ledger->balance;
+                temp_transaction_ids = root_ledger->transaction_ids;
+            }
+            temp_length += root->height;
+            temp_blocks_mined = root_blocks_mined;
+            const uint32_t root_index = root->store_index;
+            uint32_t temp_block = chain_store.seal(*blk->parent_block);
+            while (temp_block != root_index)
             {
-                for (const auto& txn: temp_ptr->transactions)
+                if (temp_block == NO_STORE_INDEX)
+                    throw runtime_error("Block does not descend from the root of its node");
+                const uint32_t parent = store.block_parent[temp_block];
+                if (store.miner(temp_block) == id)
+                    temp_blocks_mined++;
+                const uint32_t* txns = store.transactions_of(temp_block);
+                for (uint32_t i = 0; !validated && i < store.block_transactions_count[temp_block]; i++)
                 {
-                    temp_transaction_ids.insert(txn->id);
+                    const uint32_t t = txns[i];
+                    temp_transaction_ids.insert(store.transaction_id[t]);
 
-                    if (txn->coinbase) temp_balance[txn->receiver]+=txn->amount;
+                    if (store.transaction_coinbase[t]) temp_balance[store.transaction_receiver[t]]+=store.transaction_amount[t];
                     else
                     {
-                        temp_balance[txn->sender]-=txn->amount;
-                        temp_balance[txn->receiver]+=txn->amount;
+                        temp_balance[store.transaction_sender[t]]-=store.transaction_amount[t];
+                        temp_balance[store.transaction_receiver[t]]+=store.transaction_amount[t];
                     }
                 }
-                temp_ptr = temp_ptr->parent_block;
+                temp_block = parent;
                 temp_length++;
             }
         }
         // if parent is a leaf get it from leaf node
         else
         {
-            temp_balance = (*it)->balance;
-            temp_transaction_ids = (*it)->transaction_ids;
+            if (!validated)
+            {
+                temp_balance = (*it)->ledger->balance;
+                temp_transaction_ids = (*it)->ledger->transaction_ids;
+            }
             temp_length = (*it)->length+1;
+            temp_blocks_mined = (*it)->blocks_mined;
         }
     }
 
     // validate the block
-    for (const auto& txn: blk->transactions)
+    const uint32_t block_index = chain_store.seal(*blk);
+    const uint32_t* txns = store.transactions_of(block_index);
+    for (uint32_t i = 0; !validated && i < store.block_transactions_count[block_index]; i++)
     {
-        temp_transaction_ids.insert(txn->id);
-        if (txn->coinbase) temp_balance[txn->receiver]+=txn->amount;
+        const uint32_t t = txns[i];
+        temp_transaction_ids.insert(store.transaction_id[t]);
+        if (store.transaction_coinbase[t]) temp_balance[store.transaction_receiver[t]]+=store.transaction_amount[t];
         else
         {
-            temp_balance[txn->sender]-= txn->amount;
+            temp_balance[store.transaction_sender[t]]-= store.transaction_amount[t];
             // if balance -ve invalid transaction, abort
-            if ( temp_balance[txn->sender] < 0 )
+            if ( temp_balance[store.transaction_sender[t]] < 0 )
             {
                 l.log << "Time "<< simulation_time <<": Node " << id << " validation fail block  "<<blk->id<<endl;
+                SIM_PROBE3(block_reject, id, blk->id, simulation_time);
                 return false;
             }
-            temp_balance[txn->receiver]+= txn->amount;
+            temp_balance[store.transaction_receiver[t]]+= store.transaction_amount[t];
         }
     }
+    if (shares_ledgers() && !validated)
+        share_ledger(ledger);
 
     // if validated broadcast block and insert into tree.
     broadcast_hash(blk);
 
-    if (malicious || !blk->is_private)
-        block_ids_in_tree.insert({blk->id,simulation_time});
+    if (Strategy::attacker(*this) || !blk->is_private())
+    {
+        if (block_ids_in_tree.insert({blk->id,simulation_time}).second && !malicious())
+            propagation.block_reached(blk->id, simulation_time);
+    }
 
     l.log << "Time "<< simulation_time <<": Node " << id << " successfully validated block  "<<blk->id<<endl;
+    SIM_PROBE3(block_accept, id, blk->id, simulation_time);
 
     // Create leaf node
-    const auto temp_leaf = make_shared<LeafNode>(blk,temp_length);
-    temp_leaf->balance= std::move(temp_balance);
-    temp_leaf->transaction_ids = std::move(temp_transaction_ids);
+    const auto temp_leaf = make_object<LeafNode>(blk,temp_length);
+    temp_leaf->ledger = std::move(ledger);
+    const bool mined_by_node = blk->transactions[0]->receiver() == id;
+    temp_leaf->blocks_mined = temp_blocks_mined + mined_by_node;
 
 
-    if ( selfish_mining && malicious && blk->is_private)
+    if (Strategy::withholds(*this) && blk->is_private())
     {
 
         private_leaf = temp_leaf;
+        withhold_block(blk);
+        chain.private_blocks_mined += mined_by_node;
 
         long long global_length = (*leaves.begin())->length;
         long long private_length = private_leaf==nullptr? 0 : private_leaf->length;
 
-        printf("Global : %lld Private %lld Generated by %d  block id : %lld parent id: %lld \n",global_length,private_length,(*blk->transactions.begin())->receiver,blk->id,blk->parent_block->id);
+        *console << "Global : " << global_length << " Private " << private_length << " Generated by "
+            << (*blk->transactions.begin())->receiver() << "  block id : " << blk->id << " parent id: "
+            << blk->parent_block->id << " \n";
         return true;
 
     }
@@ -411,31 +534,39 @@ bool Node::validate_and_add_block(shared_ptr<Block> blk)
     else
     {
         // return true if longest changes after inserting
-        const long long previous_longest = (*leaves.begin())->block->id;
+        const object_ptr<LeafNode> previous_longest = *leaves.begin();
+        long long parent_fork_height = -1;
         if (it != leaves.end())
+        {
+            parent_fork_height = (*it)->fork_height;
             leaves.erase(it);
+        }
         leaves.insert(temp_leaf);
-        const long long current_longest = (*leaves.begin())->block->id;
+        chain.blocks_mined += mined_by_node;
+        update_chain_stats(temp_leaf, previous_longest, parent_fork_height);
+        const bool extended = previous_longest != *leaves.begin();
+        prune_finalized();
 
-        return (previous_longest != current_longest);
+        return extended;
     }
 }
 
-void Node::broadcast_hash(const shared_ptr<Block>& blk)
+void Node::broadcast_hash(const object_ptr<Block>& blk)
 {
-    if (malicious)
+    NodeMethodScope scope(NODE_BROADCAST_HASH);
+    const long long hash_value = compute_hash(blk);
+    if (malicious())
     {
-        for (auto link : malicious_peers)
+        for (auto& link : malicious_peers)
         {
             // send hash if not already sent to the peer
             if (link.hash_sent.count(blk->id) == 0)
             {
                 link.hash_sent.insert(blk->id);
                 const long long latency = link.propagation_delay + hash_size/link.link_speed + \
-                exponential_distribution(static_cast<double>(queuing_delay_constant)/static_cast<double>(link.link_speed));
+                exponential_distribution(latency_rng, static_cast<double>(queuing_delay_constant)/static_cast<double>(link.link_speed));
 
                 // create receive hash event for that node at current time + latency
-                long long hash_value = compute_hash(blk);
                 receive_hash_object obj(hash_value,id,link.peer,blk);
                 Event e(simulation_time + latency,RECEIVE_HASH,obj);
                 event_queue.push(e);
@@ -443,20 +574,18 @@ void Node::broadcast_hash(const shared_ptr<Block>& blk)
         }
     }
 
-    if (!blk->is_private)
+    if (!blk->is_private())
     {
-        for (auto link : peers)
+        for (auto& link : peers)
         {
             // send hash if not already sent to the peer
             if (link.hash_sent.count(blk->id) == 0)
             {
                 link.hash_sent.insert(blk->id);
                 const long long latency = link.propagation_delay + hash_size/link.link_speed + \
-                exponential_distribution(static_cast<double>(queuing_delay_constant)/static_cast<double>(link.link_speed));
+                exponential_distribution(latency_rng, static_cast<double>(queuing_delay_constant)/static_cast<double>(link.link_speed));
 
                 // create receive hash event for that node at current time + latency
-                long long hash_value = compute_hash(blk);
-                // cout<<"hash value :"<<hash_value <<"Block id :"<<blk->id<<endl;
                 receive_hash_object obj(hash_value,id,link.peer,blk);
                 Event e(simulation_time + latency,RECEIVE_HASH,obj);
                 event_queue.push(e);
@@ -467,23 +596,30 @@ void Node::broadcast_hash(const shared_ptr<Block>& blk)
 
 void Node::mine_block()
 {
-    currently_mining = true;
-    if (mempool.empty() || hashing_power == 0)
+    dispatch_strategy(strategy(), [&](auto policy) { mine_block_as<decltype(policy)>(); });
+}
+
+template <typename Strategy>
+void Node::mine_block_as()
+{
+    NodeMethodScope scope(NODE_MINE_BLOCK);
+    set_currently_mining(true);
+    if (mempool.empty() || hashing_power() == 0)
     {
-        currently_mining = false;
+        set_currently_mining(false);
         return;
     }
     // create the new block with coinbase transaction
-    shared_ptr<LeafNode> longest_leaf = *leaves.begin();
+    object_ptr<LeafNode> longest_leaf = *leaves.begin();
 
-    if (selfish_mining && ringmaster && private_leaf!= nullptr)
+    if (Strategy::mines_privately(*this) && private_leaf!= nullptr)
     {
         longest_leaf = private_leaf;
     }
 
-    auto blk = make_shared<Block>(simulation_time,longest_leaf->block,ringmaster,!ringmaster);
-    blk->transactions.push_back(make_shared<Transaction>(id,mining_reward,true));
-    vector<long long > temp_balance = longest_leaf->balance;
+    auto blk = make_object<Block>(simulation_time,longest_leaf->block,ringmaster(),!ringmaster());
+    blk->transactions.push_back(make_object<Transaction>(id,mining_reward,true));
+    vector<long long > temp_balance = longest_leaf->ledger->balance;
 
     // populate block with valid transactions from mempool
     blk->transactions.reserve(min(static_cast<int>(mempool.size()),1000));
@@ -492,74 +628,108 @@ void Node::mine_block()
         auto txn = mempool.front(); mempool.pop();
         transactions_in_pool.erase(txn->id);
 
-        if (longest_leaf->transaction_ids.count(txn->id) == 0)
+        if (longest_leaf->ledger->transaction_ids.count(txn->id) == 0)
         {
-            if (txn->coinbase) temp_balance[txn->receiver]+=txn->amount;
+            if (txn->coinbase()) temp_balance[txn->receiver()]+=txn->amount();
             else
             {
-                if ( temp_balance[txn->sender] - txn->amount < 0 )
+                if ( temp_balance[txn->sender()] - txn->amount() < 0 )
                     continue;
 
-                temp_balance[txn->sender]-= txn->amount;
-                temp_balance[txn->receiver]+= txn->amount;
+                temp_balance[txn->sender()]-= txn->amount();
+                temp_balance[txn->receiver()]+= txn->amount();
             }
         blk->transactions.push_back(txn);
         }
     }
     if (blk->transactions.size() <=1)
     {
-            currently_mining = false;
+            set_currently_mining(false);
             return;
     }
 
     l.log << "Time " << simulation_time << ": Node " << id << " started mining "<<blk->id<<endl;
+    const double hashing_fraction = static_cast<double>(hashing_power())/static_cast<double>(number_of_nodes);
+    // the nonce search of the proof of work mode queues BLOCK_MINED once this block is the first one found
+    if (active_proof_of_work != nullptr)
+    {
+        // the node stops hashing the block it mined before, its transactions go back to the mempool
+        if (const object_ptr<Block> previous = active_proof_of_work->start(id, blk, hashing_fraction, simulation_time);
+            previous != nullptr)
+            return_to_mempool(*previous);
+        SIM_PROBE4(mining_start, id, blk->id, simulation_time, -1);
+        return;
+    }
     // compute mining time and create event at that time
-    const double hashing_fraction = static_cast<double>(hashing_power)/static_cast<double>(number_of_nodes);
-    const long long mining_time = exponential_distribution(static_cast<double>(block_inter_arrival_time)/hashing_fraction);
+    const long long mining_time = exponential_distribution(mining_rng, static_cast<double>(block_inter_arrival_time)/hashing_fraction);
     block_mined_object obj(id,blk);
     event_queue.emplace(simulation_time + mining_time,BLOCK_MINED, obj);
+    SIM_PROBE4(mining_start, id, blk->id, simulation_time, simulation_time + mining_time); // detail: completion time
+}
+
+void Node::complete_mining(const object_ptr<Block>& blk)
+{
+    dispatch_strategy(strategy(), [&](auto policy) { complete_mining_as<decltype(policy)>(blk); });
 }
 
-void Node::complete_mining(const shared_ptr<Block>&  blk)
+template <typename Strategy>
+void Node::complete_mining_as(const object_ptr<Block>& blk)
 {
-    shared_ptr<LeafNode> longest_leaf = *leaves.begin();
+    NodeMethodScope scope(NODE_COMPLETE_MINING);
+    object_ptr<LeafNode> longest_leaf = *leaves.begin();
 
-    if (selfish_mining && ringmaster && private_leaf!= nullptr || blk->parent_block->id == longest_leaf->block->id)
+    if (Strategy::mines_privately(*this) && private_leaf!= nullptr || blk->parent_block->id == longest_leaf->block->id)
     {
+        SIM_PROBE4(mining_complete, id, blk->id, simulation_time, 1); // detail: 1 added to the tree, 0 stale
         // validation always succeeds
-        validate_and_add_block(blk);
+        propagation.block_mined(blk->id, blk->is_honest(), simulation_time);
+        validate_and_add_block_as<Strategy>(blk);
         l.log << "Time " << simulation_time << ": Node " << id << " successfully mined "<<blk->id<<endl;
         // start mining next block
-        mine_block();
+        mine_block_as<Strategy>();
     }
     // if failed return transactions to the mempool
     else
     {
         l.log << "Time " << simulation_time << ": Node " << id << " mining event ignored "<<blk->id<<endl;
-        for (const auto& txn: blk->transactions)
+        SIM_PROBE4(mining_complete, id, blk->id, simulation_time, 0);
+        return_to_mempool(*blk);
+        mine_block_as<Strategy>();
+    }
+}
+
+void Node::return_to_mempool(const Block& blk)
+{
+    for (const auto& txn: blk.transactions)
+    {
+        if (transactions_in_pool.count(txn->id) == 0 && !txn->coinbase())
         {
-            if (transactions_in_pool.count(txn->id) == 0 && !txn->coinbase)
-            {
-                mempool.push(txn);
-                transactions_in_pool.insert(txn->id);
-            }
+            mempool.push(txn);
+            transactions_in_pool.insert(txn->id);
         }
-        mine_block();
     }
 }
 
-void Node::send_block(const get_block_request_object &obj){
+void Node::send_block(const get_block_request_object& obj)
+{
+    dispatch_strategy(strategy(), [&](auto policy) { send_block_as<decltype(policy)>(obj); });
+}
+
+template <typename Strategy>
+void Node::send_block_as(const get_block_request_object& obj)
+{
+    NodeMethodScope scope(NODE_SEND_BLOCK);
 
     Network& network = Network::getInstance();
 
-    if (eclipse_attack && malicious && !network.nodes[obj.sender_node_id].malicious && obj.blk->is_honest)
+    if (Strategy::eclipses(*this) && !network.columns.malicious[obj.sender_node_id] && obj.blk->is_honest())
         return;
 
     const long long size = (transaction_size) * static_cast<long long>(obj.blk->transactions.size());
 
     Link to_send_link(1,1,1);
     // if attacker overlay exists send through that
-    if (malicious && network.nodes[obj.sender_node_id].malicious)
+    if (malicious() && network.columns.malicious[obj.sender_node_id])
     {
         for (const auto& link: malicious_peers)
             if (link.peer == obj.sender_node_id)
@@ -578,7 +748,7 @@ void Node::send_block(const get_block_request_object &obj){
             }
     }
         const long long latency = to_send_link.propagation_delay + size/to_send_link.link_speed + \
-        exponential_distribution(static_cast<double>(queuing_delay_constant)/static_cast<double>(to_send_link.link_speed));
+        exponential_distribution(latency_rng, static_cast<double>(queuing_delay_constant)/static_cast<double>(to_send_link.link_speed));
 
         // create receive block event for that node at current time + latency
         receive_block_object robj(id,to_send_link.peer,obj.blk);
@@ -586,68 +756,346 @@ void Node::send_block(const get_block_request_object &obj){
         event_queue.push(e);
 }
 
-long long Node::compute_hash(shared_ptr<Block> blk)
+long long Node::compute_hash(const object_ptr<Block>& blk)
 {
-    //TODO: Compute actual hash and return
-    // stringstream ss;
-    // ss << blk->id << "-" 
-    //    << (blk->parent_block ? blk->parent_block->id : 0) << "-"
-    //    << blk->creation_time << "-"
-    //    << blk->is_private << "-"
-    //    << blk->is_honest;
-    
-    // string hash_str = md5(ss.str());
-    
-    // long long hash_val = 0;
-    // for (size_t i = 0; i < 16 && i < hash_str.size(); i++) {
-    //     hash_val = (hash_val << 4) | (hash_str[i] % 16);
-    // }
-   
-    // return hash_val;
-    return blk->id;
+    // the header hash is computed once per block and cached
+    return blk->short_hash();
 }
 
-void Node::release_private_helper(shared_ptr<Block> blk)
+void Node::withhold_block(const object_ptr<Block>& blk)
 {
-    if ( blk == nullptr)
-        return;
-    release_private_helper(blk->parent_block);
+    // a block that does not extend the segment replaces its tail
+    while (!withheld_blocks.empty() && withheld_blocks.back() != blk->parent_block)
+        withheld_blocks.pop_back();
 
-    blk->is_private = false;
-    broadcast_hash(blk);
+    if (withheld_blocks.empty())
+    {
+        // new segment, it starts after the last public ancestor
+        const object_ptr<Block> previous_fork_point = withheld_fork_point;
+        withheld_fork_point = blk->parent_block;
+        while (withheld_fork_point->is_private())
+        {
+            withheld_blocks.push_front(withheld_fork_point);
+            withheld_fork_point = withheld_fork_point->parent_block;
+        }
+        if (withheld_fork_point != previous_fork_point)
+            withheld_partially_released = false;
+    }
+    withheld_blocks.push_back(blk);
 }
 
-void Node::release_private(int counter)
+void Node::release_private(int counter, const long long height)
 {
+    NodeMethodScope scope(NODE_RELEASE_PRIVATE);
     if (private_leaf == nullptr)
         return;
 
-    for (auto link : malicious_peers)
+    for (auto& link : malicious_peers)
     {
-        // send hash if not already sent to the peer
+        // send release if not already sent to the peer
         if (link.release_private_sent.count(counter) == 0)
         {
             link.release_private_sent.insert(counter);
 
             const long long latency = link.propagation_delay + get_message_size/link.link_speed + \
-            exponential_distribution(static_cast<double>(queuing_delay_constant)/static_cast<double>(link.link_speed));
+            exponential_distribution(latency_rng, static_cast<double>(queuing_delay_constant)/static_cast<double>(link.link_speed));
 
-            // create receive hash event for that node at current time + latency
-            release_private_object obj(link.peer,counter);
+            // create release private event for that node at current time + latency
+            release_private_object obj(link.peer,counter,height);
             Event e(simulation_time + latency,RELEASE_PRIVATE,obj);
             event_queue.push(e);
         }
     }
-    release_private_helper(private_leaf->block);
-    leaves.insert(private_leaf);
-    private_leaf = nullptr;
+
+    // number of withheld blocks to publish
+    size_t released = 0;
+    while (released < withheld_blocks.size() && withheld_blocks[released]->height <= height)
+        released++;
+    const bool all = released == withheld_blocks.size();
+    if (released == 0 && !all)
+        return;
+
+    // leaf of the published part, the private leaf with the blocks still withheld rolled back
+    object_ptr<LeafNode> leaf = private_leaf;
+    long long mined_released = 0;
+    if (!all)
+    {
+        leaf = make_object<LeafNode>(withheld_blocks[released - 1],
+                                     private_leaf->length - static_cast<long long>(withheld_blocks.size() - released));
+        leaf->ledger = make_object<Ledger>(withheld_blocks[released - 1]->id);
+        Ledger& ledger = *leaf->ledger;
+        ledger.balance = private_leaf->ledger->balance;
+        ledger.transaction_ids = private_leaf->ledger->transaction_ids;
+        leaf->blocks_mined = private_leaf->blocks_mined;
+        for (size_t i = released; i < withheld_blocks.size(); i++)
+        {
+            for (const auto& txn : withheld_blocks[i]->transactions)
+            {
+                ledger.transaction_ids.erase(txn->id);
+                if (!txn->coinbase())
+                    ledger.balance[txn->sender()] += txn->amount();
+                ledger.balance[txn->receiver()] -= txn->amount();
+            }
+            if (withheld_blocks[i]->transactions[0]->receiver() == id)
+                leaf->blocks_mined--;
+        }
+    }
+
+    // oldest first, so peers can request each block after its parent
+    for (size_t i = 0; i < released; i++)
+    {
+        const object_ptr<Block>& blk = withheld_blocks[i];
+        blk->make_public();
+        broadcast_hash(blk);
+        if (blk->transactions[0]->receiver() == id)
+            mined_released++;
+    }
+
+    // the leaf of an earlier partial release is extended by this one
+    long long parent_fork_height = -1;
+    if (withheld_partially_released)
+    {
+        const auto it = find_if(leaves.begin(), leaves.end(),
+                                [this](const object_ptr<LeafNode>& other) { return other->block == withheld_fork_point; });
+        if (it != leaves.end())
+        {
+            parent_fork_height = (*it)->fork_height;
+            leaves.erase(it);
+        }
+    }
+
+    const object_ptr<LeafNode> previous_longest = *leaves.begin();
+    leaves.insert(leaf);
+    if (all)
+        mined_released = chain.private_blocks_mined;
+    chain.blocks_mined += mined_released;
+    chain.private_blocks_mined -= mined_released;
+    update_chain_stats(leaf, previous_longest, parent_fork_height);
+
+    if (all)
+    {
+        private_leaf = nullptr;
+        withheld_fork_point = nullptr;
+        withheld_blocks.clear();
+        withheld_partially_released = false;
+    }
+    else
+    {
+        withheld_fork_point = withheld_blocks[released - 1];
+        withheld_blocks.erase(withheld_blocks.begin(), withheld_blocks.begin() + static_cast<long>(released));
+        withheld_partially_released = true;
+    }
+    prune_finalized();
+}
+
+void Node::update_chain_stats(const object_ptr<LeafNode>& leaf, const object_ptr<LeafNode>& previous_longest,
+                              const long long parent_fork_height)
+{
+    const object_ptr<LeafNode>& longest = *leaves.begin();
+    vector<long long>& longest_chain = chain.longest_chain;
+
+    // common case: longest chain extended by one block
+    if (longest == leaf && leaf->block->parent_block == previous_longest->block)
+    {
+        longest_chain.push_back(leaf->block->id);
+        leaf->fork_height = leaf->length;
+        return;
+    }
+
+    // new fork or extended fork, the longest chain and fork points of other leaves are unchanged
+    if (longest == previous_longest)
+    {
+        leaf->fork_height = parent_fork_height != -1 ? parent_fork_height : fork_height(leaf->block.get());
+        return;
+    }
+
+    // reorganisation: rewrite the longest chain from the new tip down to the common ancestor, which is at or above
+    // the root since every leaf descends from it
+    const long long offset = chain.longest_chain_offset;
+    const long long previous_length = static_cast<long long>(longest_chain.size()) + offset;
+    longest_chain.resize(longest->length - offset, -1);
+    const Block* temp_block = longest->block.get();
+    while (longest_chain[temp_block->height - 1 - offset] != temp_block->id)
+    {
+        longest_chain[temp_block->height - 1 - offset] = temp_block->id;
+        temp_block = temp_block->parent_block.get();
+    }
+
+    // blocks of the previous longest chain above the common ancestor were abandoned, none if it was only extended
+    const long long common_height = temp_block->height;
+    if (const long long depth = previous_length - common_height; depth > 0)
+    {
+        chain.reorganisations++;
+        chain.deepest_reorganisation = max(chain.deepest_reorganisation, depth);
+    }
+
+    // only leaves forking at or above the common ancestor can have a different fork point now
+    for (const auto& other : leaves)
+        if (other->fork_height >= common_height)
+            other->fork_height = fork_height(other->block.get());
 }
 
+long long Node::fork_height(const Block* blk) const
+{
+    return lowest_common_ancestor(blk, (*leaves.begin())->block.get())->height;
+}
+
+long long Node::first_seen_time(const long long block_id) const
+{
+    if (const auto seen = block_ids_in_tree.find(block_id); seen != block_ids_in_tree.end())
+        return seen->second;
+    return block_id < block_watermark ? -1 : 0;
+}
+
+void Node::prune_finalized()
+{
+    const object_ptr<LeafNode> longest = *leaves.begin();
+    if (finality_depth == 0 || longest->length - finality_depth <= finalized_height)
+        return;
+    finalized_height = longest->length - finality_depth;
+    const long long previous_watermark = block_watermark;
+    block_watermark = chain.longest_chain[finalized_height - 1 - chain.longest_chain_offset];
+
+    // forks joining the longest chain below the final block can no longer win, their summary is kept
+    for (auto leaf = next(leaves.begin()); leaf != leaves.end();)
+    {
+        if ((*leaf)->fork_height >= finalized_height || *leaf == private_leaf)
+        {
+            ++leaf;
+            continue;
+        }
+        const long long fork_length = (*leaf)->length - (*leaf)->fork_height;
+        if (chain.pruned_forks == 0 || fork_length < chain.pruned_shortest_fork)
+            chain.pruned_shortest_fork = fork_length;
+        chain.pruned_longest_fork = max(chain.pruned_longest_fork, fork_length);
+        chain.pruned_fork_length += fork_length;
+        chain.pruned_forks++;
+        chain.pruned_fork_tips.push_back({(*leaf)->block->id, (*leaf)->block->height, fork_length});
+        leaf = leaves.erase(leaf);
+    }
+
+    // block ids increase along a chain, so every block below the watermark is final or on a dead fork
+    if (!malicious())
+        propagation.node_finalized(block_ids_in_tree, previous_watermark, block_watermark);
+    block_ids_in_tree.erase(block_ids_in_tree.begin(), block_ids_in_tree.lower_bound(block_watermark));
+    hashes_seen.erase(hashes_seen.begin(), hashes_seen.lower_bound(block_watermark));
+    timers.erase(timers.begin(), timers.lower_bound(block_watermark));
+    for (vector<Link>* links : {&peers, &malicious_peers})
+        for (Link& link : *links)
+            link.hash_sent.erase(link.hash_sent.begin(), link.hash_sent.lower_bound(block_watermark));
+    while (!local_storage.empty() && (*local_storage.begin())->id < block_watermark)
+        local_storage.erase(local_storage.begin());
+
+    // the tree is re-rooted at the final block, or at the fork point of the private chain that may still be released
+    const Block* new_root = longest->block->ancestor(finalized_height);
+    if (private_leaf != nullptr)
+        new_root = lowest_common_ancestor(new_root, private_leaf->block.get());
+    if (new_root == root.get())
+        return;
+
+    // the transactions and own blocks between the two roots are added to the root ledger
+    vector<uint32_t> final_blocks;
+    for (uint32_t b = chain_store.seal(*new_root); b != root->store_index; b = chain_store.block_parent[b])
+        final_blocks.push_back(b);
+    for (auto b = final_blocks.rbegin(); b != final_blocks.rend(); ++b)
+    {
+        const uint32_t* txns = chain_store.transactions_of(*b);
+        for (uint32_t i = 0; i < chain_store.block_transactions_count[*b]; i++)
+        {
+            const uint32_t t = txns[i];
+            root_ledger->transaction_ids.insert(chain_store.transaction_id[t]);
+            if (!chain_store.transaction_coinbase[t])
+                root_ledger->balance[chain_store.transaction_sender[t]] -= chain_store.transaction_amount[t];
+            root_ledger->balance[chain_store.transaction_receiver[t]] += chain_store.transaction_amount[t];
+        }
+        if (chain_store.miner(*b) == id)
+            root_blocks_mined++;
+    }
+    root_ledger->block_id = new_root->id;
+
+    const object_ptr<Block> previous = root;
+    root = object_ptr_from(const_cast<Block*>(new_root));
+    chain.longest_chain.erase(chain.longest_chain.begin(),
+                              chain.longest_chain.begin() + (root->height - 1 - chain.longest_chain_offset));
+    chain.longest_chain_offset = root->height - 1;
+    Network::getInstance().node_rerooted(previous, root);
+}
+
+node_summary Node::summarize_chain() const
+{
+    node_summary summary;
+    const object_ptr<LeafNode>& longest = *leaves.begin();
+    summary.blocks_mined = chain.blocks_mined;
+    summary.blocks_mined_in_longest_chain = longest->blocks_mined;
+    summary.blocks_in_longest_chain = longest->length;
+
+    // every other leaf is a fork branching off the longest chain at its fork height
+    long long total_fork_length = 0;
+    for (auto leaf = next(leaves.begin()); leaf != leaves.end(); ++leaf)
+    {
+        const long long fork_length = (*leaf)->length - (*leaf)->fork_height;
+        if (summary.number_of_forks == 0 || fork_length < summary.shortest_fork_length)
+            summary.shortest_fork_length = fork_length;
+        summary.longest_fork_length = max(summary.longest_fork_length, fork_length);
+        total_fork_length += fork_length;
+        summary.number_of_forks++;
+    }
+    if (chain.pruned_forks != 0)
+    {
+        if (summary.number_of_forks == 0 || chain.pruned_shortest_fork < summary.shortest_fork_length)
+            summary.shortest_fork_length = chain.pruned_shortest_fork;
+        summary.longest_fork_length = max(summary.longest_fork_length, chain.pruned_longest_fork);
+        total_fork_length += chain.pruned_fork_length;
+        summary.number_of_forks += chain.pruned_forks;
+    }
+    if (summary.number_of_forks != 0)
+        summary.average_fork_length = total_fork_length / summary.number_of_forks;
+    summary.reorganisations = chain.reorganisations;
+    summary.deepest_reorganisation = chain.deepest_reorganisation;
+    return summary;
+}
+
+
+chain_stats::chain_stats()
+{
+    blocks_mined = 0;
+    private_blocks_mined = 0;
+    longest_chain_offset = 0;
+    pruned_forks = 0;
+    pruned_fork_length = 0;
+    pruned_longest_fork = 0;
+    pruned_shortest_fork = 0;
+    reorganisations = 0;
+    deepest_reorganisation = 0;
+}
+
+node_summary::node_summary()
+{
+    blocks_mined = 0;
+    blocks_mined_in_longest_chain = 0;
+    blocks_in_longest_chain = 0;
+    number_of_forks = 0;
+    longest_fork_length = 0;
+    shortest_fork_length = 0;
+    average_fork_length = 0;
+    reorganisations = 0;
+    deepest_reorganisation = 0;
+}
+
+double node_summary::fraction_mined_in_longest_chain() const
+{
+    return static_cast<double>(blocks_mined_in_longest_chain) / static_cast<double>(blocks_in_longest_chain);
+}
+
+double node_summary::fraction_mined_not_in_longest_chain() const
+{
+    if (blocks_mined == 0) return 0;
+    return static_cast<double>(blocks_mined - blocks_mined_in_longest_chain) / static_cast<double>(blocks_mined);
+}
 
 Network& Network::getInstance()
 {
-    static Network instance;
-    return instance;
+    return *active_network;
 }
 
 void Network::build_network(vector<int> &node_ids,const string& networkType){
@@ -680,6 +1128,7 @@ void Network::build_network(vector<int> &node_ids,const string& networkType){
 
                 // choose new neighbors
                 vector<int> temp = choose_neighbours_values(
+                    topology_rng,
                     node_ids,
                     min_peers - static_cast<int>(mal[node_idx].size()),
                     excluded
@@ -718,59 +1167,66 @@ void Network::build_network(vector<int> &node_ids,const string& networkType){
             if (i < x)
             {
 
-                int link_speed = nodes[i].fast && nodes[x].fast ? 100 * 1000 : 5 * 1000; // bits per millisecond
+                int link_speed = columns.fast[i] && columns.fast[x] ? 100 * 1000 : 5 * 1000; // bits per millisecond
 
                 if (networkType == "common"){
-                    int propagation_delay = uniform_distribution(propagation_delay_min,propagation_delay_max);
+                    int propagation_delay = uniform_distribution(topology_rng, propagation_delay_min,propagation_delay_max);
                     nodes[i].peers.emplace_back(x, propagation_delay, link_speed);
                     nodes[x].peers.emplace_back(i, propagation_delay, link_speed);
                 }
                 else{
-                    int propagation_delay = uniform_distribution(propagation_delay_malicious_min,propagation_delay_malicious_max); // 1ms to 10ms
+                    int propagation_delay = uniform_distribution(topology_rng, propagation_delay_malicious_min,propagation_delay_malicious_max); // 1ms to 10ms
                     nodes[i].malicious_peers.emplace_back(x, propagation_delay, link_speed);
                     nodes[x].malicious_peers.emplace_back(i, propagation_delay, link_speed);
                 }
             }
         }
     }
-    cout<<"Network built for "<<networkType<<endl;
+    *console<<"Network built for "<<networkType<<endl;
 
 }
 
 
 Network::Network()
 {
+    active_network = this;
+    topology_rng = RandomStream(global_seed, RNG_NO_NODE, RNG_TOPOLOGY);
+
     // Node id equal to its index in vector
+    Node::reset_ticket();
     nodes.resize(number_of_nodes);
+    columns.resize(number_of_nodes);
+    for (auto& node : nodes)
+        node.columns = &columns;
     vector<int> all_node_ids;
     for (int i=0; i<number_of_nodes; i++){
         all_node_ids.push_back(i);
     }
 
     //   create honest and malicious nodes ids and their nodes_ptr instances
-    malicious_node_ids = choose_percent(number_of_nodes, static_cast<double>(percent_malicious_nodes) / static_cast<double>(100));
+    malicious_node_ids = choose_percent(topology_rng, number_of_nodes, static_cast<double>(percent_malicious_nodes) / static_cast<double>(100));
     bool assigned_ringmaster = false;
     for(int i=0; i<number_of_nodes; i++){
         if (find(malicious_node_ids.begin(), malicious_node_ids.end(), i) != malicious_node_ids.end()){
             if (assigned_ringmaster){
-                nodes[i].malicious = true;
-                nodes[i].hashing_power = 0;
-                nodes[i].fast = true;
+                columns.malicious[i] = true;
+                columns.hashing_power[i] = 0;
+                columns.fast[i] = true;
             }
             else{
-                nodes[i].malicious = true;
-                nodes[i].ringmaster = true;
-                nodes[i].fast = true;
-                nodes[i].hashing_power =static_cast<long long> (malicious_node_ids.size());
+                columns.malicious[i] = true;
+                columns.ringmaster[i] = true;
+                columns.fast[i] = true;
+                columns.hashing_power[i] =static_cast<long long> (malicious_node_ids.size());
 
                 assigned_ringmaster = true;
-                cout<<"Ringmaster id: " << nodes[i].id<<endl;
+                *console<<"Ringmaster id: " << nodes[i].id<<endl;
                 ringmaster_node_id = nodes[i].id;
             }
         }
         else{
             honest_node_ids.push_back(i);
-            nodes[i].hashing_power = 1;
+            columns.hashing_power[i] = 1;
         }
 
     }
@@ -778,11 +1234,89 @@ Network::Network()
 
     build_network(all_node_ids, "common");
     build_network(malicious_node_ids, "malicious");
+    assign_strategies();
 
     //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 }
 
+void Network::assign_strategies()
+{
+    for (auto& node : nodes)
+        columns.strategy[node.id] = strategy_kind(node);
+}
+
+void Network::index_node_roots()
+{
+    node_roots.clear();
+    for (const auto& node : nodes)
+        node_roots[node.root]++;
+    cut_roots();
+}
+
+void Network::node_rerooted(const object_ptr<Block>& previous, const object_ptr<Block>& root)
+{
+    const auto it = node_roots.find(previous);
+    if (--it->second == 0)
+        node_roots.erase(it);
+    node_roots[root]++;
+    cut_roots();
+}
+
+void Network::cut_roots()
+{
+    bool cut = false;
+    for (const auto& [root, count] : node_roots)
+    {
+        if (root->parent_block == nullptr)
+            continue;
+        // another node still walks the chain below this root
+        bool needed = false;
+        for (const auto& [other, other_count] : node_roots)
+            if (other->height < root->height && is_ancestor(other.get(), root.get()))
+                needed = true;
+        if (needed)
+            continue;
+
+        // no jump of a block above the root may lead below it once the blocks there are freed
+        for (uint32_t b = 0; b < chain_store.block_count(); b++)
+            if (Block* blk = chain_store.block(b); blk != nullptr && blk->height > root->height &&
+                                                   is_ancestor(root.get(), blk))
+                blk->drop_jumps_below(root->height);
+        root->cut_parent();
+        cut = true;
+    }
+
+    if (cut && chain_store.compact() && chain_store.transaction_count() != 0)
+        trim_transaction_ids(chain_store.transaction_id[0]);
+}
+
+void Network::trim_transaction_ids(const long long lowest)
+{
+    for (auto& node : nodes)
+    {
+        node.root_ledger->transaction_ids.trim(lowest);
+        for (const auto& leaf : node.leaves)
+            leaf->ledger->transaction_ids.trim(lowest);
+        if (node.private_leaf != nullptr)
+            node.private_leaf->ledger->transaction_ids.trim(lowest);
+        for (vector<Link>* links : {&node.peers, &node.malicious_peers})
+            for (Link& link : *links)
+                link.transactions_sent.trim(lowest);
+    }
+}
+
+Network::Network(unbuilt)
+{
+    active_network = this;
+    Node::reset_ticket();
+    nodes.resize(number_of_nodes);
+    columns.resize(number_of_nodes);
+    for (auto& node : nodes)
+        node.columns = &columns;
+    ringmaster_node_id = -1;
+}
+
 // Logger::Logger()
 // {
 //     if (fs::path dir = output_dir +"/Log"; !fs::exists(dir))
@@ -830,6 +1364,8 @@ Logger::~Logger()
 void Logger::setOutputDir(const std::string& dir)
 {
     output_dir = dir;
+    if (log.is_open())
+        log.close();
 
     // Create the directory if it doesn't already exist
     if (fs::path log_dir = output_dir + "/Log"; !fs::exists(log_dir))
@@ -5,6 +5,8 @@
 #include <set>
 #include <map>
 #include <queue>
+#include <deque>
+#include <climits>
 #include "Blockchain.h"
 #include "Event.h"
 #include <filesystem>
@@ -16,32 +18,38 @@
 
 
 
-typedef variant<shared_ptr<Transaction>, shared_ptr<Block>> MO;
+typedef variant<object_ptr<Transaction>, object_ptr<Block>> MO;
 
 using namespace std;
 namespace fs = filesystem;
 
-extern int transaction_amount_min;
-extern int transaction_amount_max;
-extern int queuing_delay_constant;
-extern int propagation_delay_min;
-extern int propagation_delay_max;;
-extern int propagation_delay_malicious_min;
-extern int propagation_delay_malicious_max;
-extern long long simulation_time;
-extern int block_inter_arrival_time;
-extern int timer_timeout_time;
-extern int transaction_size;
-extern int hash_size;
-extern int get_message_size;
-extern int mining_reward;
-extern EQ event_queue;
-extern bool eclipse_attack;
-extern bool selfish_mining;
-extern int maximum_retries;
-extern int global_send_private_counter;
-extern string output_dir;
-extern bool mitigation;
+extern thread_local int transaction_amount_min;
+extern thread_local int transaction_amount_max;
+extern thread_local int queuing_delay_constant;
+extern thread_local int propagation_delay_min;
+extern thread_local int propagation_delay_max;
+extern thread_local int propagation_delay_malicious_min;
+extern thread_local int propagation_delay_malicious_max;
+extern thread_local long long simulation_time;
+extern thread_local int block_inter_arrival_time;
+extern thread_local int timer_timeout_time;
+extern thread_local int transaction_size;
+extern thread_local int hash_size;
+extern thread_local int get_message_size;
+extern thread_local int mining_reward;
+extern thread_local EQ event_queue;
+extern thread_local bool eclipse_attack;
+extern thread_local bool selfish_mining;
+extern thread_local int maximum_retries;
+extern thread_local int global_send_private_counter;
+class ProofOfWork;
+extern thread_local ProofOfWork* active_proof_of_work; // nullptr unless mining uses a real nonce search
+extern thread_local string output_dir;
+extern thread_local bool mitigation;
+extern thread_local int release_strategy;
+extern thread_local bool branching_strategies;
+extern thread_local bool shared_ledgers; // honest nodes share the ledgers of validated blocks
+extern thread_local long long finality_depth; // blocks below the tip after which a block is final, 0 never prunes
 
 // Link between two nodes
 class Link
@@ -53,100 +61,236 @@ public:
   long long failed;
 
   // keeps track of transactions and blocks sent to avoid loops
-  set<long long> transactions_sent;
-  set<long long> blocks_sent;
-  set<long long> get_message_sent;
+  IdSet transactions_sent;
   set<long long> hash_sent;
   set<int> release_private_sent;
 
   Link(int peer, int propagation_delay, long long link_speed);
 };
 
+// chain statistics of a single node as reported in its stats file
+struct node_summary
+{
+  long long blocks_mined;
+  long long blocks_mined_in_longest_chain;
+  long long blocks_in_longest_chain;
+  long long number_of_forks;
+  long long longest_fork_length;
+  long long shortest_fork_length;
+  unsigned long long average_fork_length;
+  long long reorganisations; // switches to a longest chain that abandoned blocks of the previous one
+  long long deepest_reorganisation; // most blocks abandoned by one switch
+
+  node_summary();
+  double fraction_mined_in_longest_chain() const;
+  double fraction_mined_not_in_longest_chain() const;
+};
+
+// a fork pruned behind the finality depth
+struct pruned_fork
+{
+  long long tip_id;
+  long long tip_height;
+  long long length; // blocks above the longest chain
+};
+
+// chain statistics of a node, updated in O(1) amortized per accepted block
+struct chain_stats
+{
+  long long blocks_mined; // own blocks reachable from the leaves
+  long long private_blocks_mined; // own blocks withheld in the private chain
+  // block id at each height of the longest chain from the root of the node, height h at h - 1 - longest_chain_offset
+  vector<long long> longest_chain;
+  long long longest_chain_offset; // heights below the root of the node
+
+  // forks pruned behind the finality depth, kept for the summary
+  long long pruned_forks;
+  long long pruned_fork_length; // sum over the pruned forks
+  long long pruned_longest_fork;
+  long long pruned_shortest_fork;
+  vector<pruned_fork> pruned_fork_tips; // tip and length of every pruned fork, not its blocks
+
+  // reorganisations of the longest chain, depth is the number of blocks above the common ancestor that left it
+  long long reorganisations;
+  long long deepest_reorganisation;
+
+  chain_stats();
+};
+
+// hot per-node state in struct-of-arrays columns indexed by node id, the large Node objects keep the containers,
+// so role, speed and mining checks on random nodes read a byte or two instead of a cache line of a Node
+struct node_columns
+{
+  vector<uint8_t> fast;
+  vector<uint8_t> malicious;
+  vector<uint8_t> ringmaster;
+  vector<uint8_t> currently_mining;
+  vector<long long> hashing_power;
+  vector<int> strategy; // kind of mining strategy bound by Network::assign_strategies, see Strategy.h
+
+  void resize(size_t n);
+};
+
 class Node
 {
 private:
   // to generate unique node ids (equal to index in node vector)
-  static int node_ticket;
+  static thread_local int node_ticket;
 
 public:
   // Node attributes
   int id;
-  bool fast;
-  bool malicious;
-  bool ringmaster;
-  bool currently_mining;
-  queue<shared_ptr<Transaction>> mempool;
+  node_columns* columns; // hot state of this node is at index id
+  queue<object_ptr<Transaction>> mempool;
   set <long long> transactions_in_pool;
-  long long hashing_power{};
 
   // Links
   vector<Link> peers; // stores links to all its peers
   vector<Link> malicious_peers; // empty for honest
 
-  set<shared_ptr<Block>> local_storage;
+  set<object_ptr<Block>,CompareBlockPtrById> local_storage; // blocks received before their parent
   // Blockchain
-  shared_ptr<Block> genesis; // genesis block pointer
-  set<shared_ptr<LeafNode>,CompareLeafNodePtr> leaves; // stores information about all leaf nodes of blockchain tree
+  // root of the tree: genesis until finality moves it to the final block, or to the fork point of a private chain
+  // below it, blocks that do not descend from it are ignored
+  object_ptr<Block> root;
+  object_ptr<Ledger> root_ledger; // balances and transaction ids of the chain ending at the root
+  long long root_blocks_mined; // own blocks in that chain, genesis not counted
+  set<object_ptr<LeafNode>,CompareLeafNodePtr> leaves; // stores information about all leaf nodes of blockchain tree
   map<long long, long long> block_ids_in_tree; // stores received blocks <block id, time first seen>
-  shared_ptr<LeafNode> private_leaf; // for ringmaster
+  object_ptr<LeafNode> private_leaf; // for ringmaster
+  // unpublished part of the private chain: the public block it builds on and the withheld blocks in order
+  object_ptr<Block> withheld_fork_point;
+  deque<object_ptr<Block>> withheld_blocks;
+  bool withheld_partially_released; // withheld_fork_point was published by a partial release and has a leaf
+
+  // Random streams of this node, keyed by (seed, node id, purpose)
+  RandomStream latency_rng;
+  RandomStream mining_rng;
+  RandomStream transaction_rng;
+  RandomStream topology_rng; // replacement peers under mitigation
+
+  // Finality: blocks below block_watermark are final or on dead forks, they are known without being kept in the
+  // dedup sets and their first seen times are dropped
+  long long finalized_height;
+  long long block_watermark; // id of the longest chain block at finalized_height
 
   // Statistics
   long long transactions_received;
   long long blocks_received;
+  chain_stats chain;
 
   // Timers
   map <long long, Timer> timers; // block id and timer object
   set <long long> hashes_seen; // stores block id
 
   Node();
+  bool fast() const { return columns->fast[id]; }
+  bool malicious() const { return columns->malicious[id]; }
+  bool ringmaster() const { return columns->ringmaster[id]; }
+  bool currently_mining() const { return columns->currently_mining[id]; }
+  long long hashing_power() const { return columns->hashing_power[id]; }
+  int strategy() const { return columns->strategy[id]; }
+  // honest node with shared ledgers, takes the shared ledger of a block instead of validating it again
+  bool shares_ledgers() const { return shared_ledgers && !malicious(); }
+  void set_currently_mining(bool mining) { columns->currently_mining[id] = mining; }
+  // restart ids from 0 for a new network on this thread
+  static void reset_ticket();
   // creates a random transaction and broadcasts it to its peers
   void create_transaction();
   //  receive a transaction from peer
   void receive_transaction(const receive_transaction_object &obj);
   // send transaction and get requests to particular link
-  void send_transaction_to_link(const shared_ptr<Transaction>& txn, Link &link) const;
-  void send_get_to_link(const shared_ptr<Block>& blk, Link &link) const;
+  void send_transaction_to_link(const object_ptr<Transaction>& txn, Link &link);
+  void send_get_to_link(const object_ptr<Block>& blk, Link &link);
   // receive hash from peer
   void receive_hash(const receive_hash_object& obj);
   void timer_expired(const timer_expired_object &obj);
   // Prepare block and start mining
   void mine_block();
   // add mined block to tree if longest not changed
-  void complete_mining(const shared_ptr<Block>& blk);
+  void complete_mining(const object_ptr<Block>& blk);
+  // puts the transactions of a block that will not be mined back into the mempool
+  void return_to_mempool(const Block& blk);
   // true: block added to the longest chain
   // false: validation failed or block added to some forked branch
-  bool validate_and_add_block(shared_ptr<Block> blk);
-  void broadcast_hash(const shared_ptr<Block>& blk);
+  bool validate_and_add_block(object_ptr<Block> blk);
+  void broadcast_hash(const object_ptr<Block>& blk);
   // receive a block from peer
   void receive_block(const receive_block_object &obj);
   // send block to requester
   void send_block(const get_block_request_object &obj);
-  long long compute_hash(shared_ptr<Block> blk);
-  void release_private(int counter);
-  void release_private_helper(shared_ptr<Block> blk);
+  long long compute_hash(const object_ptr<Block>& blk);
+  // publishes the withheld blocks up to height, all of them by default, and tells the malicious peers to do the same
+  // already public ancestors are not touched
+  void release_private(int counter, long long height = LLONG_MAX);
+  // appends a private block that became the private tip to the withheld segment
+  void withhold_block(const object_ptr<Block>& blk);
+
+  // handlers with the checks of a strategy policy, the public handlers dispatch on strategy
+  template <typename Strategy> void receive_block_as(const receive_block_object& obj);
+  template <typename Strategy> bool validate_and_add_block_as(object_ptr<Block> blk);
+  template <typename Strategy> void mine_block_as();
+  template <typename Strategy> void complete_mining_as(const object_ptr<Block>& blk);
+  template <typename Strategy> void send_block_as(const get_block_request_object& obj);
+
+  // updates the streaming chain stats after leaf was inserted into leaves
+  // parent_fork_height is the fork height of the leaf it replaced, -1 if none
+  void update_chain_stats(const object_ptr<LeafNode>& leaf, const object_ptr<LeafNode>& previous_longest,
+                          long long parent_fork_height);
+  // height of the common ancestor of blk and the longest chain
+  long long fork_height(const Block* blk) const;
+  // final stats of the node without traversing its tree
+  node_summary summarize_chain() const;
+  // block received or below the watermark
+  bool knows_block(long long block_id) const { return block_id < block_watermark || block_ids_in_tree.count(block_id) != 0; }
+  // time the block was first seen, -1 once it is behind the watermark, 0 if unknown
+  long long first_seen_time(long long block_id) const;
+  // once the longest chain grew finality_depth blocks above the last finalized height, drops the forks that branch
+  // off below the new finalized height and the dedup entries of blocks below the watermark and moves the root up
+  void prune_finalized();
 };
 
 
 
 class Network
 {
-private:
-  Network();
-
 public:
   vector<Node> nodes;
+  node_columns columns; // hot state of nodes, the nodes point here
   vector<int> malicious_node_ids; // indexes of subset of nodes which are only malicious
   vector<int> honest_node_ids;
   int ringmaster_node_id;
+  RandomStream topology_rng; // node roles and the overlay graphs
+
+  // roots of the nodes with the number of nodes at each, a root is cut from its parent once none of the others is
+  // below it on its chain, the blocks below are then freed and only listed from the chain store archive
+  map<object_ptr<Block>, int, CompareBlockPtrById> node_roots;
 
 
-  // Static method to access the singleton instance.
+  // builds the network of number_of_nodes nodes and makes it the active network of this thread
+  Network();
+  // number_of_nodes nodes without roles or links, filled in by restoring a snapshot
+  struct unbuilt {};
+  explicit Network(unbuilt);
+  // network of the simulation running on this thread
   static Network& getInstance();
   // Delete copy constructor and assignment operator to prevent copies.
   Network(const Network&) = delete;
   Network& operator=(const Network&) = delete;
 
   void build_network(vector<int> &node_ids,const string& networkType);
+  // binds every node to the strategy policy of its role under the current attack toggles
+  void assign_strategies();
+  // indexes the roots of the nodes, after genesis or a restore
+  void index_node_roots();
+  // a node moved its root up from previous to root
+  void node_rerooted(const object_ptr<Block>& previous, const object_ptr<Block>& root);
+
+private:
+  // cuts every root with no other root below it on its chain from its parent
+  void cut_roots();
+  // forgets the ids of freed transactions in every id set
+  void trim_transaction_ids(long long lowest);
 };
 
 class Logger
@@ -161,6 +305,6 @@ public:
   void setOutputDir(const std::string& dir); 
 };
 
-extern Logger l;
+extern thread_local Logger l;
 
 #endif //NETWORK_H
@@ -0,0 +1,140 @@
+#include "PerfCounters.h"
+
+#include <cerrno>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+perf_counts::perf_counts()
+{
+    values.fill(0);
+}
+
+const char* perf_counter_name(const int counter)
+{
+    static const char* names[NUMBER_OF_PERF_COUNTERS] = {"cycles", "instructions", "llc_misses", "branch_misses"};
+    return counter >= 0 && counter < NUMBER_OF_PERF_COUNTERS ? names[counter] : "unknown";
+}
+
+#ifdef __linux__
+
+// group read with PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+struct perf_group_read
+{
+    uint64_t nr;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    uint64_t values[NUMBER_OF_PERF_COUNTERS];
+};
+
+PerfCounterGroup::PerfCounterGroup()
+{
+    static const uint64_t configs[NUMBER_OF_PERF_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    leader = -1;
+    opened = 0;
+    fds.fill(-1);
+    slot.fill(-1);
+
+    for (int counter = 0; counter < NUMBER_OF_PERF_COUNTERS; counter++)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[counter];
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = leader == -1; // the leader starts the whole group
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd == -1)
+        {
+            if (!error.empty()) error += ", ";
+            error += string(perf_counter_name(counter)) + ": " + strerror(errno);
+            continue;
+        }
+        if (leader == -1)
+            leader = fd;
+        fds[counter] = fd;
+        slot[counter] = opened++;
+    }
+
+    if (leader != -1)
+    {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+PerfCounterGroup::~PerfCounterGroup()
+{
+    for (const int fd : fds)
+        if (fd != -1)
+            close(fd);
+}
+
+void PerfCounterGroup::read(perf_counts& counts) const
+{
+    if (leader == -1)
+        return;
+    perf_group_read group;
+    if (::read(leader, &group, sizeof(group)) <= 0)
+        return;
+    for (int counter = 0; counter < NUMBER_OF_PERF_COUNTERS; counter++)
+        if (slot[counter] != -1)
+            counts.values[counter] = group.values[slot[counter]];
+}
+
+double PerfCounterGroup::running_fraction() const
+{
+    perf_group_read group;
+    if (leader == -1 || ::read(leader, &group, sizeof(group)) <= 0 || group.time_enabled == 0)
+        return 0;
+    return static_cast<double>(group.time_running) / static_cast<double>(group.time_enabled);
+}
+
+#else
+
+PerfCounterGroup::PerfCounterGroup()
+{
+    leader = -1;
+    opened = 0;
+    fds.fill(-1);
+    slot.fill(-1);
+    error = "perf_event_open is only available on Linux";
+}
+
+PerfCounterGroup::~PerfCounterGroup() = default;
+
+void PerfCounterGroup::read(perf_counts&) const
+{
+}
+
+double PerfCounterGroup::running_fraction() const
+{
+    return 0;
+}
+
+#endif
+
+bool PerfCounterGroup::available() const
+{
+    return opened > 0;
+}
+
+bool PerfCounterGroup::has(const int counter) const
+{
+    return slot[counter] != -1;
+}
+
+const string& PerfCounterGroup::unavailable_reason() const
+{
+    return error;
+}
@@ -0,0 +1,58 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// hardware counters read by the event loop profiler
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_LLC_MISSES 2
+#define PERF_BRANCH_MISSES 3
+#define NUMBER_OF_PERF_COUNTERS 4
+
+struct perf_counts
+{
+    array<uint64_t, NUMBER_OF_PERF_COUNTERS> values;
+
+    perf_counts();
+    void add_difference(const perf_counts& end, const perf_counts& start)
+    {
+        for (int i = 0; i < NUMBER_OF_PERF_COUNTERS; i++)
+            values[i] += end.values[i] - start.values[i];
+    }
+};
+
+const char* perf_counter_name(int counter);
+
+// Cycles, instructions, last level cache misses and branch misses of the calling thread in user space, opened as
+// one perf_event_open group so a read returns all of them for the same interval. Counters the kernel refuses
+// (no PMU in virtual machines, perf_event_paranoid, seccomp in containers) are left out, and if none can be
+// opened the group is unavailable and reads leave the counts unchanged.
+class PerfCounterGroup
+{
+    int leader;
+    array<int, NUMBER_OF_PERF_COUNTERS> fds;
+    array<int, NUMBER_OF_PERF_COUNTERS> slot; // position of the counter in a group read, -1 if not opened
+    int opened;
+    string error;
+
+public:
+    PerfCounterGroup();
+    ~PerfCounterGroup();
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    bool available() const;
+    bool has(int counter) const;
+    // why counters are missing, empty if all of them were opened
+    const string& unavailable_reason() const;
+    void read(perf_counts& counts) const;
+    // fraction of the enabled time the group was counting, below 1 when the kernel multiplexed it
+    double running_fraction() const;
+};
+
+#endif //PERFCOUNTERS_H
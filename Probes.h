@@ -0,0 +1,63 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+/*
+ * Statically defined tracepoints (USDT) of provider p2psim on the hot paths, for attaching bpftrace or perf to a
+ * running simulation, e.g. bpftrace -e 'usdt:./main:p2psim:block_reject { printf("%d %d\n", arg0, arg1); }'.
+ * Every probe carries node id, block id (-1 if none) and simulation time, some a fourth detail argument.
+ * A probe site is a single nop plus an ELF note describing where its arguments live, so an unattached probe costs
+ * the nop and at most a load of its arguments. Built with SIMULATOR_PROBES (CMake option, on by default): through
+ * <sys/sdt.h> where installed, otherwise with the same note layout emitted here on x86-64 GCC/Clang; without it or
+ * on other targets the probes compile to nothing.
+ */
+
+#if defined(SIMULATOR_PROBES) && defined(__has_include)
+// arguments in registers or immediates only, the clock is thread-local and tracers cannot read %fs relative operands
+#define STAP_SDT_ARG_CONSTRAINT nr
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SIM_PROBE3(name, node, block, time) DTRACE_PROBE3(p2psim, name, static_cast<long long>(node), \
+    static_cast<long long>(block), static_cast<long long>(time))
+#define SIM_PROBE4(name, node, block, time, detail) DTRACE_PROBE4(p2psim, name, static_cast<long long>(node), \
+    static_cast<long long>(block), static_cast<long long>(time), static_cast<long long>(detail))
+#elif defined(__x86_64__) && defined(__ELF__) && defined(__GNUC__)
+// stapsdt note version 3 as written by sys/sdt.h: probe address, base address, semaphore (none), provider, name
+// and the argument locations as "size@operand", negative sizes for signed values
+#define SIM_PROBE_NOTE(name, arguments, ...) \
+    __asm__ __volatile__("990: nop\n" \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+        ".balign 4\n" \
+        ".4byte 992f-991f, 994f-993f, 3\n" \
+        "991: .asciz \"stapsdt\"\n" \
+        "992: .balign 4\n" \
+        "993: .8byte 990b\n" \
+        ".8byte _.stapsdt.base\n" \
+        ".8byte 0\n" \
+        ".asciz \"p2psim\"\n" \
+        ".asciz \"" #name "\"\n" \
+        ".asciz \"" arguments "\"\n" \
+        "994: .balign 4\n" \
+        ".popsection\n" \
+        ".ifndef _.stapsdt.base\n" \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+        ".weak _.stapsdt.base\n" \
+        ".hidden _.stapsdt.base\n" \
+        "_.stapsdt.base: .space 1\n" \
+        ".size _.stapsdt.base, 1\n" \
+        ".popsection\n" \
+        ".endif\n" \
+        :: __VA_ARGS__)
+#define SIM_PROBE3(name, node, block, time) SIM_PROBE_NOTE(name, "-8@%0 -8@%1 -8@%2", \
+    "nr"(static_cast<long long>(node)), "nr"(static_cast<long long>(block)), "nr"(static_cast<long long>(time)))
+#define SIM_PROBE4(name, node, block, time, detail) SIM_PROBE_NOTE(name, "-8@%0 -8@%1 -8@%2 -8@%3", \
+    "nr"(static_cast<long long>(node)), "nr"(static_cast<long long>(block)), "nr"(static_cast<long long>(time)), \
+    "nr"(static_cast<long long>(detail)))
+#endif
+#endif
+
+#ifndef SIM_PROBE3
+#define SIM_PROBE3(name, node, block, time) do {} while (0)
+#define SIM_PROBE4(name, node, block, time, detail) do {} while (0)
+#endif
+
+#endif //PROBES_H
@@ -0,0 +1,340 @@
+#include "Profiler.h"
+
+#include <climits>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+const char* node_method_name(const int method)
+{
+    static const char* names[NUMBER_OF_NODE_METHODS] = {
+        "create_transaction", "receive_transaction", "receive_hash", "timer_expired", "receive_block",
+        "validate_and_add_block", "broadcast_hash", "mine_block", "complete_mining", "send_block", "release_private"
+    };
+    return method >= 0 && method < NUMBER_OF_NODE_METHODS ? names[method] : "unknown";
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    counts.fill(0);
+    total_count = 0;
+    sum = 0;
+    min_value = UINT64_MAX;
+    max_value = 0;
+}
+
+uint64_t LatencyHistogram::bucket_low(const int bucket)
+{
+    if (bucket < HISTOGRAM_SUB_BUCKETS)
+        return bucket;
+    const int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    return static_cast<uint64_t>(HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+}
+
+uint64_t LatencyHistogram::bucket_high(const int bucket)
+{
+    if (bucket < HISTOGRAM_SUB_BUCKETS)
+        return bucket;
+    const int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    return bucket_low(bucket) + (1ULL << shift) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(const double p) const
+{
+    if (total_count == 0)
+        return 0;
+    // rank of the value at p, at least the first one
+    auto rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total_count) + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        seen += counts[bucket];
+        if (seen >= rank)
+            return bucket_high(bucket) < max_value ? bucket_high(bucket) : max_value;
+    }
+    return max_value;
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    return total_count;
+}
+
+uint64_t LatencyHistogram::total() const
+{
+    return sum;
+}
+
+uint64_t LatencyHistogram::min() const
+{
+    return total_count > 0 ? min_value : 0;
+}
+
+uint64_t LatencyHistogram::max() const
+{
+    return max_value;
+}
+
+double LatencyHistogram::mean() const
+{
+    return total_count > 0 ? static_cast<double>(sum) / static_cast<double>(total_count) : 0;
+}
+
+uint64_t LatencyHistogram::bucket_count(const int bucket) const
+{
+    return counts[bucket];
+}
+
+EventProfiler::EventProfiler(const long long sample_interval, const long long start_time, const bool hardware_counters)
+{
+    if (hardware_counters)
+        counters = make_unique<PerfCounterGroup>();
+    this->sample_interval = sample_interval;
+    next_sample_time = start_time;
+    events = 0;
+    wall_seconds = 0;
+    resumed = chrono::steady_clock::now();
+}
+
+void EventProfiler::resume()
+{
+    resumed = chrono::steady_clock::now();
+}
+
+void EventProfiler::pause()
+{
+    wall_seconds = loop_seconds();
+}
+
+double EventProfiler::loop_seconds() const
+{
+    return wall_seconds + chrono::duration<double>(chrono::steady_clock::now() - resumed).count();
+}
+
+void EventProfiler::sample(const long long time, const size_t depth)
+{
+    samples.push_back({time, depth, loop_seconds(), events});
+}
+
+bool EventProfiler::counting() const
+{
+    return counters && counters->available();
+}
+
+// counter totals, empty fields for counters that are not read
+void EventProfiler::write_counters_csv(ostream& os, const perf_counts& counts) const
+{
+    for (int counter = 0; counter < NUMBER_OF_PERF_COUNTERS; counter++)
+    {
+        os << ",";
+        if (counting() && counters->has(counter))
+            os << counts.values[counter];
+    }
+    os << ",";
+    if (counting() && counters->has(PERF_CYCLES) && counters->has(PERF_INSTRUCTIONS) && counts.values[PERF_CYCLES] > 0)
+        os << static_cast<double>(counts.values[PERF_INSTRUCTIONS]) / static_cast<double>(counts.values[PERF_CYCLES]);
+}
+
+void EventProfiler::write_counters_json(ostream& os, const perf_counts& counts) const
+{
+    if (!counting())
+        return;
+    os << ", \"counters\": {";
+    bool first = true;
+    for (int counter = 0; counter < NUMBER_OF_PERF_COUNTERS; counter++)
+    {
+        if (!counters->has(counter))
+            continue;
+        os << (first ? "" : ", ") << "\"" << perf_counter_name(counter) << "\": " << counts.values[counter];
+        first = false;
+    }
+    os << "}";
+}
+
+// events per second between consecutive samples
+static double events_per_second(const queue_depth_sample& previous, const queue_depth_sample& current)
+{
+    const double seconds = current.wall_seconds - previous.wall_seconds;
+    return seconds > 0 ? static_cast<double>(current.events - previous.events) / seconds : 0;
+}
+
+static const double percentiles[] = {50, 90, 99, 99.9};
+static const char* percentile_names[] = {"p50", "p90", "p99", "p999"};
+
+// name,count,total_ns,mean_ns,min_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns
+static void write_latency_csv(ostream& os, const char* name, const LatencyHistogram& h)
+{
+    os << name << "," << h.count() << "," << h.total() << "," << h.mean() << "," << h.min();
+    for (const double p : percentiles)
+        os << "," << h.percentile(p);
+    os << "," << h.max();
+}
+
+static void write_latency_json(ostream& os, const char* name, const LatencyHistogram& h)
+{
+    os << "    {\"name\": \"" << name << "\", \"count\": " << h.count() << ", \"total_ns\": " << h.total()
+        << ", \"mean_ns\": " << h.mean() << ", \"min_ns\": " << h.min() << ", \"max_ns\": " << h.max();
+    for (size_t i = 0; i < size(percentiles); i++)
+        os << ", \"" << percentile_names[i] << "_ns\": " << h.percentile(percentiles[i]);
+    // non-empty buckets as [lowest ns, highest ns, count]
+    os << "," << endl << "     \"buckets\": [";
+    bool first = true;
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+        if (h.bucket_count(bucket) == 0)
+            continue;
+        os << (first ? "" : ", ") << "[" << LatencyHistogram::bucket_low(bucket) << ", "
+            << LatencyHistogram::bucket_high(bucket) << ", " << h.bucket_count(bucket) << "]";
+        first = false;
+    }
+    os << "]";
+}
+
+void EventProfiler::write_report(const string& dir) const
+{
+    ofstream events_csv(dir + "profile_events.csv");
+    ofstream methods_csv(dir + "profile_node_methods.csv");
+    ofstream depth(dir + "profile_queue_depth.csv");
+    ofstream json(dir + "profile.json");
+    if (!events_csv || !methods_csv || !depth || !json)
+    {
+        cerr << "An Error occurred while opening file!" << endl;
+        return;
+    }
+
+    const string counter_columns = ",cycles,instructions,llc_misses,branch_misses,ipc";
+    events_csv << "event_type,count,total_ns,mean_ns,min_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns" << counter_columns
+        << endl;
+    for (int type = 0; type < NUMBER_OF_EVENT_TYPES; type++)
+    {
+        write_latency_csv(events_csv, event_type_name(type), handler_times[type]);
+        write_counters_csv(events_csv, handler_counts[type]);
+        events_csv << endl;
+    }
+
+    methods_csv << "method,count,total_ns,mean_ns,min_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns" << counter_columns
+        << endl;
+    for (int method = 0; method < NUMBER_OF_NODE_METHODS; method++)
+    {
+        write_latency_csv(methods_csv, node_method_name(method), method_times[method]);
+        write_counters_csv(methods_csv, method_counts[method]);
+        methods_csv << endl;
+    }
+
+    depth << "simulation_time,queue_depth,wall_seconds,events,events_per_sec" << endl;
+    for (size_t i = 0; i < samples.size(); i++)
+        depth << samples[i].time << "," << samples[i].depth << "," << samples[i].wall_seconds << ","
+            << samples[i].events << "," << (i > 0 ? events_per_second(samples[i - 1], samples[i]) : 0) << endl;
+
+    json << "{" << endl;
+    json << "  \"events\": " << events << "," << endl;
+    json << "  \"wall_seconds\": " << wall_seconds << "," << endl;
+    json << "  \"events_per_sec\": " << (wall_seconds > 0 ? static_cast<double>(events) / wall_seconds : 0) << ","
+        << endl;
+    json << "  \"histogram_sub_buckets\": " << HISTOGRAM_SUB_BUCKETS << "," << endl;
+    json << "  \"hardware_counters\": {\"requested\": " << (counters ? "true" : "false") << ", \"available\": "
+        << (counting() ? "true" : "false");
+    if (counters)
+    {
+        json << ", \"running_fraction\": " << counters->running_fraction() << ", \"missing\": \"";
+        for (const char c : counters->unavailable_reason())
+            json << (c == '"' || c == '\\' ? "\\" : "") << c;
+        json << "\"";
+    }
+    json << "}," << endl;
+
+    json << "  \"event_types\": [" << endl;
+    for (int type = 0; type < NUMBER_OF_EVENT_TYPES; type++)
+    {
+        write_latency_json(json, event_type_name(type), handler_times[type]);
+        write_counters_json(json, handler_counts[type]);
+        json << "}" << (type + 1 < NUMBER_OF_EVENT_TYPES ? "," : "") << endl;
+    }
+    json << "  ]," << endl;
+    json << "  \"node_methods\": [" << endl;
+    for (int method = 0; method < NUMBER_OF_NODE_METHODS; method++)
+    {
+        write_latency_json(json, node_method_name(method), method_times[method]);
+        write_counters_json(json, method_counts[method]);
+        json << "}" << (method + 1 < NUMBER_OF_NODE_METHODS ? "," : "") << endl;
+    }
+    json << "  ]," << endl;
+    json << "  \"queue_depth\": [" << endl;
+    for (size_t i = 0; i < samples.size(); i++)
+        json << "    {\"simulation_time\": " << samples[i].time << ", \"depth\": " << samples[i].depth
+            << ", \"wall_seconds\": " << samples[i].wall_seconds << ", \"events\": " << samples[i].events
+            << ", \"events_per_sec\": " << (i > 0 ? events_per_second(samples[i - 1], samples[i]) : 0) << "}"
+            << (i + 1 < samples.size() ? "," : "") << endl;
+    json << "  ]" << endl;
+    json << "}" << endl;
+}
+
+// one table row of print_summary, share is of the summed totals of the table
+static void print_latency_row(ostream& os, const char* name, const LatencyHistogram& h, const uint64_t table_total)
+{
+    os << "  " << left << setw(24) << name << right << setw(10) << h.count() << setw(12) << fixed << setprecision(2)
+        << h.mean() / 1000 << setw(12) << static_cast<double>(h.percentile(99)) / 1000 << setw(12)
+        << static_cast<double>(h.max()) / 1000 << setw(9)
+        << (table_total > 0 ? 100.0 * static_cast<double>(h.total()) / static_cast<double>(table_total) : 0) << "%"
+        << defaultfloat << setprecision(6) << endl;
+}
+
+// per call averages of the counters and instructions per cycle
+static void print_counters_row(ostream& os, const char* name, const uint64_t calls, const perf_counts& counts,
+                               const PerfCounterGroup& counters)
+{
+    os << "  " << left << setw(24) << name << right << fixed << setprecision(0);
+    for (int counter = 0; counter < NUMBER_OF_PERF_COUNTERS; counter++)
+    {
+        if (counters.has(counter) && calls > 0)
+            os << setw(15) << static_cast<double>(counts.values[counter]) / static_cast<double>(calls);
+        else
+            os << setw(15) << "-";
+    }
+    if (counters.has(PERF_CYCLES) && counters.has(PERF_INSTRUCTIONS) && counts.values[PERF_CYCLES] > 0)
+        os << setw(8) << setprecision(2)
+            << static_cast<double>(counts.values[PERF_INSTRUCTIONS]) / static_cast<double>(counts.values[PERF_CYCLES]);
+    else
+        os << setw(8) << "-";
+    os << defaultfloat << setprecision(6) << endl;
+}
+
+void EventProfiler::print_summary(ostream& os) const
+{
+    os << " Event loop profile: " << events << " events in " << wall_seconds << " s ("
+        << (wall_seconds > 0 ? static_cast<double>(events) / wall_seconds : 0) << " events/s)" << endl;
+    uint64_t handler_total = 0;
+    for (const auto& h : handler_times)
+        handler_total += h.total();
+    os << "  " << left << setw(24) << "event type" << right << setw(10) << "count" << setw(12) << "mean us"
+        << setw(12) << "p99 us" << setw(12) << "max us" << setw(10) << "share" << endl;
+    for (int type = 0; type < NUMBER_OF_EVENT_TYPES; type++)
+        print_latency_row(os, event_type_name(type), handler_times[type], handler_total);
+    // methods nest, so their shares are of the handler time
+    os << "  " << left << setw(24) << "node method" << right << setw(10) << "count" << setw(12) << "mean us"
+        << setw(12) << "p99 us" << setw(12) << "max us" << setw(10) << "share" << endl;
+    for (int method = 0; method < NUMBER_OF_NODE_METHODS; method++)
+        print_latency_row(os, node_method_name(method), method_times[method], handler_total);
+
+    if (!counters)
+        return;
+    if (!counting())
+    {
+        os << " Hardware counters unavailable (" << counters->unavailable_reason() << ")" << endl;
+        return;
+    }
+    if (!counters->unavailable_reason().empty())
+        os << " Some hardware counters unavailable (" << counters->unavailable_reason() << ")" << endl;
+    os << " Hardware counters per call (user space, counting " << fixed << setprecision(1)
+        << 100 * counters->running_fraction() << "% of the time)" << defaultfloat << setprecision(6) << endl;
+    os << "  " << left << setw(24) << "event type / method" << right;
+    for (int counter = 0; counter < NUMBER_OF_PERF_COUNTERS; counter++)
+        os << setw(15) << perf_counter_name(counter);
+    os << setw(8) << "ipc" << endl;
+    for (int type = 0; type < NUMBER_OF_EVENT_TYPES; type++)
+        print_counters_row(os, event_type_name(type), handler_times[type].count(), handler_counts[type], *counters);
+    for (int method = 0; method < NUMBER_OF_NODE_METHODS; method++)
+        print_counters_row(os, node_method_name(method), method_times[method].count(), method_counts[method],
+                           *counters);
+}
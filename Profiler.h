@@ -0,0 +1,200 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Event.h"
+#include "PerfCounters.h"
+
+using namespace std;
+
+// Node methods timed by NodeMethodScope
+#define NODE_CREATE_TRANSACTION 0
+#define NODE_RECEIVE_TRANSACTION 1
+#define NODE_RECEIVE_HASH 2
+#define NODE_TIMER_EXPIRED 3
+#define NODE_RECEIVE_BLOCK 4
+#define NODE_VALIDATE_AND_ADD_BLOCK 5
+#define NODE_BROADCAST_HASH 6
+#define NODE_MINE_BLOCK 7
+#define NODE_COMPLETE_MINING 8
+#define NODE_SEND_BLOCK 9
+#define NODE_RELEASE_PRIVATE 10
+#define NUMBER_OF_NODE_METHODS 11
+
+const char* node_method_name(int method);
+
+// log-bucketed latency histogram in nanoseconds: values below 16 are exact, every power of two above is split
+// into 16 sub-buckets, so any recorded value is known within 6.25%
+#define HISTOGRAM_SUB_BUCKET_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_MAX_EXPONENT 48 // values from 2^48 ns (about 3 days) fall into the last bucket
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_EXPONENT - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+class LatencyHistogram
+{
+    array<uint64_t, HISTOGRAM_BUCKETS> counts;
+    uint64_t total_count;
+    uint64_t sum;
+    uint64_t min_value;
+    uint64_t max_value;
+
+public:
+    LatencyHistogram();
+
+    static int bucket_of(uint64_t value)
+    {
+        if (value < HISTOGRAM_SUB_BUCKETS)
+            return static_cast<int>(value);
+        if (value >= 1ULL << HISTOGRAM_MAX_EXPONENT)
+            value = (1ULL << HISTOGRAM_MAX_EXPONENT) - 1;
+        const int exponent = 63 - __builtin_clzll(value);
+        const int shift = exponent - HISTOGRAM_SUB_BUCKET_BITS;
+        return (shift + 1) * HISTOGRAM_SUB_BUCKETS + static_cast<int>((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+    }
+    // smallest and largest value of a bucket
+    static uint64_t bucket_low(int bucket);
+    static uint64_t bucket_high(int bucket);
+
+    void record(uint64_t value)
+    {
+        counts[bucket_of(value)]++;
+        total_count++;
+        sum += value;
+        if (value < min_value) min_value = value;
+        if (value > max_value) max_value = value;
+    }
+
+    // largest value of the bucket holding the given percentile (0 to 100), capped at the maximum
+    uint64_t percentile(double p) const;
+    uint64_t count() const;
+    uint64_t total() const;
+    uint64_t min() const;
+    uint64_t max() const;
+    double mean() const;
+    uint64_t bucket_count(int bucket) const;
+};
+
+// event queue depth and loop throughput at a simulation time
+struct queue_depth_sample
+{
+    long long time;
+    size_t depth;
+    double wall_seconds; // event loop time so far
+    long long events; // events dispatched so far
+};
+
+// Dispatch counts and handler wall times per event type, and the event queue depth over simulation time.
+// Only exists when SimulationConfig::profile is set, run_until then times every handler. With hardware counters
+// it also attributes cycles, instructions, LLC misses and branch misses to every event type, and Node methods
+// wrapped in a NodeMethodScope get their own times and counters, inclusive of the methods they call.
+class EventProfiler
+{
+    array<LatencyHistogram, NUMBER_OF_EVENT_TYPES> handler_times;
+    array<perf_counts, NUMBER_OF_EVENT_TYPES> handler_counts;
+    array<LatencyHistogram, NUMBER_OF_NODE_METHODS> method_times;
+    array<perf_counts, NUMBER_OF_NODE_METHODS> method_counts;
+    unique_ptr<PerfCounterGroup> counters; // only if hardware counters were requested
+    vector<queue_depth_sample> samples;
+    long long sample_interval;
+    long long next_sample_time;
+    long long events;
+    double wall_seconds; // event loop time of completed run_until calls
+    chrono::steady_clock::time_point resumed;
+
+    double loop_seconds() const;
+    void sample(long long time, size_t depth);
+    void write_counters_csv(ostream& os, const perf_counts& counts) const;
+    void write_counters_json(ostream& os, const perf_counts& counts) const;
+
+public:
+    // samples the queue depth every sample_interval ms of simulation time after start_time, hardware_counters
+    // opens the counters of the calling thread
+    EventProfiler(long long sample_interval, long long start_time, bool hardware_counters);
+
+    // start and end of a run_until call, only the time in between is event loop time
+    void resume();
+    void pause();
+
+    // called with every event before it is dispatched, depth excludes the event
+    void before_event(const long long time, const size_t depth)
+    {
+        while (time >= next_sample_time)
+        {
+            sample(next_sample_time, depth);
+            next_sample_time += sample_interval;
+        }
+    }
+
+    // current hardware counter values, unchanged without counters
+    void read_counters(perf_counts& counts) const
+    {
+        if (counters)
+            counters->read(counts);
+    }
+
+    void record(const int type, const chrono::steady_clock::duration handler_time, const perf_counts& start,
+                const perf_counts& end)
+    {
+        handler_times[type].record(chrono::duration_cast<chrono::nanoseconds>(handler_time).count());
+        handler_counts[type].add_difference(end, start);
+        events++;
+    }
+
+    void record_method(const int method, const chrono::steady_clock::duration time, const perf_counts& start,
+                       const perf_counts& end)
+    {
+        method_times[method].record(chrono::duration_cast<chrono::nanoseconds>(time).count());
+        method_counts[method].add_difference(end, start);
+    }
+
+    // true if at least one hardware counter is read
+    bool counting() const;
+    // profile.json with the histograms, counters and queue samples, profile_events.csv and
+    // profile_node_methods.csv with one row per event type or method, and profile_queue_depth.csv, all in dir
+    void write_report(const string& dir) const;
+    void print_summary(ostream& os) const;
+};
+
+// profiler of the simulation running on this thread, nullptr unless profiling
+extern thread_local EventProfiler* active_profiler;
+
+// times the enclosing Node method while this thread is profiled
+class NodeMethodScope
+{
+    EventProfiler* profiler;
+    int method;
+    perf_counts start_counts;
+    chrono::steady_clock::time_point start_time;
+
+public:
+    explicit NodeMethodScope(const int method) : profiler(active_profiler), method(method)
+    {
+        if (profiler)
+        {
+            profiler->read_counters(start_counts);
+            start_time = chrono::steady_clock::now();
+        }
+    }
+
+    ~NodeMethodScope()
+    {
+        if (profiler)
+        {
+            const auto time = chrono::steady_clock::now() - start_time;
+            perf_counts end_counts;
+            profiler->read_counters(end_counts);
+            profiler->record_method(method, time, start_counts, end_counts);
+        }
+    }
+
+    NodeMethodScope(const NodeMethodScope&) = delete;
+    NodeMethodScope& operator=(const NodeMethodScope&) = delete;
+};
+
+#endif //PROFILER_H
@@ -0,0 +1,374 @@
+#include "ProofOfWork.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+
+NonceSearchPool::NonceSearchPool(unsigned int num_threads)
+{
+    if (num_threads == 0)
+        num_threads = max(1u, thread::hardware_concurrency());
+
+    num_workers = num_threads;
+    for (unsigned int i = 0; i < num_workers; i++)
+        queues.push_back(make_unique<worker_queue>());
+    round = 0;
+    stopping = false;
+    jobs = nullptr;
+    target = 0;
+    best_nonces_size = 0;
+    pending_chunks = 0;
+    hashes = 0;
+}
+
+NonceSearchPool::~NonceSearchPool()
+{
+    stop_helpers();
+}
+
+unsigned int NonceSearchPool::size() const
+{
+    return num_workers;
+}
+
+void NonceSearchPool::start_helpers()
+{
+    stopping = false;
+    // worker 0 is the thread calling search
+    for (unsigned int i = 1; i < num_workers; i++)
+        helpers.emplace_back(&NonceSearchPool::helper_loop, this, i, round);
+}
+
+void NonceSearchPool::stop_helpers()
+{
+    {
+        lock_guard<mutex> lock(state_mutex);
+        stopping = true;
+    }
+    round_started.notify_all();
+    for (auto& helper : helpers)
+        helper.join();
+    helpers.clear();
+}
+
+void NonceSearchPool::helper_loop(const unsigned int index, unsigned long long seen_round)
+{
+    while (true)
+    {
+        {
+            unique_lock<mutex> lock(state_mutex);
+            round_started.wait(lock, [this, seen_round] { return stopping || round != seen_round; });
+            if (stopping)
+                return;
+            seen_round = round;
+        }
+        run_chunks(index);
+    }
+}
+
+bool NonceSearchPool::next_chunk(const unsigned int index, nonce_chunk& chunk)
+{
+    {
+        worker_queue& own = *queues[index];
+        lock_guard<mutex> lock(own.queue_mutex);
+        if (!own.chunks.empty())
+        {
+            chunk = own.chunks.front();
+            own.chunks.pop_front();
+            return true;
+        }
+    }
+    // steal the highest nonces of another worker, they are the most likely to be skipped
+    for (unsigned int k = 1; k < num_workers; k++)
+    {
+        worker_queue& victim = *queues[(index + k) % num_workers];
+        lock_guard<mutex> lock(victim.queue_mutex);
+        if (!victim.chunks.empty())
+        {
+            chunk = victim.chunks.back();
+            victim.chunks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void NonceSearchPool::run_chunks(const unsigned int index)
+{
+    nonce_chunk chunk{};
+    while (next_chunk(index, chunk))
+    {
+        search_chunk(chunk);
+        if (pending_chunks.fetch_sub(1) == 1)
+        {
+            lock_guard<mutex> lock(state_mutex);
+            round_done.notify_all();
+        }
+    }
+}
+
+void NonceSearchPool::search_chunk(const nonce_chunk& chunk)
+{
+    const nonce_search_job& job = (*jobs)[chunk.job];
+    atomic<long long>& best_nonce = best_nonces[chunk.job];
+    uint8_t suffixes[POW_BATCH * 16];
+    sha256_digest digests[POW_BATCH];
+    for (long long batch = chunk.first; batch < chunk.end; batch += POW_BATCH)
+    {
+        // nonces above the best one found by any worker cannot win
+        if (batch > best_nonce.load(memory_order_relaxed))
+            return;
+
+        // rounds between close events give each node a few nonces, so the last batch of a range is short
+        const int count = static_cast<int>(min(static_cast<long long>(POW_BATCH), chunk.end - batch));
+        for (int i = 0; i < count; i++)
+            job.blk->header_suffix(batch + i, suffixes + 16 * i);
+        sha256_many_after(job.prefix, suffixes, 16, count, digests);
+        hashes.fetch_add(count, memory_order_relaxed);
+
+        for (int i = 0; i < count; i++)
+        {
+            uint64_t leading = 0;
+            for (int j = 0; j < 8; j++)
+                leading = (leading << 8) | digests[i][j];
+            if (leading >= target)
+                continue;
+
+            const long long nonce = batch + i;
+            long long best = best_nonce.load();
+            while (nonce < best && !best_nonce.compare_exchange_weak(best, nonce))
+            {
+            }
+            return;
+        }
+    }
+}
+
+long long NonceSearchPool::search(vector<nonce_search_job>& round_jobs, const uint64_t hash_target)
+{
+    if (helpers.empty() && num_workers > 1)
+        start_helpers();
+
+    jobs = &round_jobs;
+    target = hash_target;
+    if (best_nonces_size < round_jobs.size())
+    {
+        best_nonces_size = round_jobs.size();
+        best_nonces = make_unique<atomic<long long>[]>(best_nonces_size);
+    }
+    hashes = 0;
+
+    // chunks of all jobs dealt round robin, lowest nonces first, so all workers start on the likeliest winners
+    vector<nonce_chunk> chunks;
+    for (size_t j = 0; j < round_jobs.size(); j++)
+    {
+        best_nonces[j] = LLONG_MAX;
+        for (long long first = round_jobs[j].first; first < round_jobs[j].end; first += POW_CHUNK)
+            chunks.push_back({j, first, min(first + POW_CHUNK, round_jobs[j].end)});
+    }
+    stable_sort(chunks.begin(), chunks.end(), [&round_jobs](const nonce_chunk& a, const nonce_chunk& b)
+    {
+        return a.first - round_jobs[a.job].first < b.first - round_jobs[b.job].first;
+    });
+    // rounds smaller than the pool run on the calling thread, waking the helpers would cost more than the hashes
+    const bool spread = chunks.size() >= num_workers;
+    pending_chunks = chunks.size();
+    for (size_t c = 0; c < chunks.size(); c++)
+    {
+        worker_queue& queue = *queues[spread ? c % num_workers : 0];
+        lock_guard<mutex> lock(queue.queue_mutex);
+        queue.chunks.push_back(chunks[c]);
+    }
+    if (spread)
+    {
+        {
+            lock_guard<mutex> lock(state_mutex);
+            round++;
+        }
+        round_started.notify_all();
+    }
+
+    run_chunks(0);
+    if (spread)
+    {
+        unique_lock<mutex> lock(state_mutex);
+        round_done.wait(lock, [this] { return pending_chunks.load() == 0; });
+    }
+
+    for (size_t j = 0; j < round_jobs.size(); j++)
+        round_jobs[j].found = best_nonces[j] == LLONG_MAX ? -1 : best_nonces[j].load();
+    return hashes;
+}
+
+ProofOfWork::ProofOfWork(const long long hashes_per_block, const long long block_inter_arrival_time,
+                         const unsigned int num_threads) : pool(num_threads)
+{
+    this->hashes_per_block = hashes_per_block;
+    this->block_inter_arrival_time = block_inter_arrival_time;
+    target = UINT64_MAX / static_cast<uint64_t>(hashes_per_block);
+    hashes = 0;
+    search_seconds = 0;
+    searched_until = 0;
+    blocks_found = 0;
+    exposure = 0;
+    scaled_time_sum = 0;
+    scaled_time_square_sum = 0;
+}
+
+long long ProofOfWork::completion_time(const mining_job& job, const long long nonce) const
+{
+    // the node computes hashes_per_block * hashing_fraction hashes per block_inter_arrival_time
+    return job.start_time + static_cast<long long>(static_cast<double>(nonce + 1) *
+        static_cast<double>(block_inter_arrival_time) /
+        (static_cast<double>(hashes_per_block) * job.hashing_fraction));
+}
+
+long long ProofOfWork::nonces_done_by(const mining_job& job, const long long time) const
+{
+    if (time < job.start_time)
+        return 0;
+    // estimate from the rate, then correct the rounding against completion_time
+    const double rate = static_cast<double>(hashes_per_block) * job.hashing_fraction /
+        static_cast<double>(block_inter_arrival_time);
+    long long count = max(0LL, static_cast<long long>(static_cast<double>(time - job.start_time + 1) * rate) - 1);
+    while (count > 0 && completion_time(job, count - 1) > time)
+        count--;
+    while (completion_time(job, count) <= time)
+        count++;
+    return count;
+}
+
+object_ptr<Block> ProofOfWork::start(const int node_id, const object_ptr<Block>& blk, const double hashing_fraction,
+                                     const long long start_time)
+{
+    object_ptr<Block> previous;
+    if (const auto it = jobs.find(node_id); it != jobs.end())
+        previous = it->second.blk;
+
+    mining_job& job = jobs[node_id];
+    job.blk = blk;
+    job.start_time = start_time;
+    job.hashing_fraction = hashing_fraction;
+    job.searched = 0;
+    job.found = -1;
+    resume(job);
+    return previous;
+}
+
+void ProofOfWork::resume(mining_job& job) const
+{
+    uint8_t prefix[64];
+    job.blk->header_prefix(prefix);
+    job.prefix = sha256_prefix(prefix);
+}
+
+bool ProofOfWork::idle() const
+{
+    return jobs.empty();
+}
+
+void ProofOfWork::advance(const long long until, EQ& queue)
+{
+    if (jobs.empty())
+    {
+        searched_until = until;
+        return;
+    }
+    const auto search_start = chrono::steady_clock::now();
+    double total_fraction = 0;
+    for (const auto& [node_id, job] : jobs)
+        total_fraction += job.hashing_fraction;
+    // a round searches the slice of simulated time in which the network computes one window of chunks
+    const double round_hashes = static_cast<double>(pool.size()) * POW_CHUNKS_PER_WORKER * POW_CHUNK;
+    const long long slice = max(1LL, static_cast<long long>(round_hashes * static_cast<double>(block_inter_arrival_time)
+                                    / (static_cast<double>(hashes_per_block) * max(total_fraction, 1e-9))));
+
+    vector<nonce_search_job> round_jobs;
+    vector<mining_job*> round_owners;
+    while (!jobs.empty())
+    {
+        const long long slice_end = until - searched_until > slice ? searched_until + slice : until;
+        round_jobs.clear();
+        round_owners.clear();
+        for (auto& [node_id, job] : jobs)
+        {
+            if (job.found >= 0)
+                continue;
+            const long long end = nonces_done_by(job, slice_end);
+            if (end > job.searched)
+            {
+                round_jobs.push_back({job.blk.get(), job.prefix, job.searched, end, -1});
+                round_owners.push_back(&job);
+            }
+        }
+        hashes += pool.search(round_jobs, target);
+        for (size_t j = 0; j < round_jobs.size(); j++)
+        {
+            round_owners[j]->searched = round_jobs[j].end;
+            round_owners[j]->found = round_jobs[j].found;
+        }
+
+        // every node has searched up to slice_end, the earliest valid nonce in time mines its block
+        auto winner = jobs.end();
+        long long winner_time = LLONG_MAX;
+        for (auto it = jobs.begin(); it != jobs.end(); ++it)
+        {
+            if (it->second.found < 0)
+                continue;
+            const long long time = completion_time(it->second, it->second.found);
+            if (time <= slice_end && time < winner_time)
+            {
+                winner = it;
+                winner_time = time;
+            }
+        }
+        if (winner != jobs.end())
+        {
+            mining_job& job = winner->second;
+            job.blk->set_nonce(job.found);
+            // the time to a block is exponential in the hashing done by all mining nodes
+            const double scaled_time = exposure + total_fraction * static_cast<double>(winner_time - searched_until);
+            exposure = 0;
+            blocks_found++;
+            scaled_time_sum += scaled_time;
+            scaled_time_square_sum += scaled_time * scaled_time;
+            queue.emplace(winner_time, BLOCK_MINED, block_mined_object(winner->first, job.blk));
+            jobs.erase(winner);
+            searched_until = winner_time;
+            break;
+        }
+        exposure += total_fraction * static_cast<double>(slice_end - searched_until);
+        searched_until = slice_end;
+        if (slice_end >= until)
+            break;
+    }
+    search_seconds += chrono::duration<double>(chrono::steady_clock::now() - search_start).count();
+}
+
+void ProofOfWork::stop_helpers()
+{
+    pool.stop_helpers();
+}
+
+void ProofOfWork::print_statistics(ostream& os) const
+{
+    if (blocks_found == 0)
+    {
+        os << " Proof of work: no blocks mined" << endl;
+        return;
+    }
+    const double n = static_cast<double>(blocks_found);
+    const double mean = scaled_time_sum / n;
+    const double variance = max(0.0, scaled_time_square_sum / n - mean * mean);
+    const double per_core = search_seconds > 0
+                                ? static_cast<double>(hashes) / search_seconds / pool.size()
+                                : 0;
+    os << " Proof of work: " << blocks_found << " blocks found, " << hashes << " hashes in " << search_seconds
+        << " s, " << per_core / 1e6 << " Mhash/s per core (" << pool.size() << " workers, "
+        << sha256_kernel_name(sha256_kernel()) << ")" << endl;
+    // for an exponential delay the mean equals block_inter_arrival_time and the coefficient of variation is 1
+    os << " Mining time scaled to the whole network: mean " << mean << " ms (block_inter_arrival_time "
+        << block_inter_arrival_time << " ms), coefficient of variation " << sqrt(variance) / mean
+        << ", standard error of the mean " << sqrt(variance / n) << " ms" << endl;
+}
@@ -0,0 +1,140 @@
+#ifndef PROOFOFWORK_H
+#define PROOFOFWORK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include "Blockchain.h"
+#include "Event.h"
+
+using namespace std;
+
+#define POW_CHUNK 256 // nonces per task, the unit of work stealing
+#define POW_CHUNKS_PER_WORKER 8 // tasks per worker in each round, sets the simulated time searched per round
+#define POW_BATCH 64 // nonces hashed per call of the SHA-256 kernels
+
+// nonces [first, end) of a block being mined, workers only read its header suffix
+struct nonce_search_job
+{
+    const Block* blk;
+    sha256_midstate prefix; // of the header bytes shared by all nonces
+    long long first;
+    long long end;
+    long long found; // lowest valid nonce of the range, -1 if none
+};
+
+// Finds the lowest nonce whose header hash is below the target in the ranges of several blocks at once. A round
+// splits all ranges into chunks, every worker pops its own chunks from the front and steals from the back of the
+// others when it runs dry. Chunks above the best nonce found for their block are skipped, so the result does not
+// depend on the number of workers or their timing.
+class NonceSearchPool
+{
+    struct nonce_chunk
+    {
+        size_t job; // index into the jobs of the round
+        long long first;
+        long long end;
+    };
+
+    struct worker_queue
+    {
+        mutex queue_mutex;
+        deque<nonce_chunk> chunks;
+    };
+
+    unsigned int num_workers; // including the thread calling search
+    vector<unique_ptr<worker_queue>> queues;
+    vector<thread> helpers;
+    mutex state_mutex;
+    condition_variable round_started;
+    condition_variable round_done;
+    unsigned long long round;
+    bool stopping;
+
+    const vector<nonce_search_job>* jobs;
+    uint64_t target; // first 8 bytes of the hash, big endian, must be below target
+    unique_ptr<atomic<long long>[]> best_nonces; // per job of the round
+    size_t best_nonces_size;
+    atomic<size_t> pending_chunks;
+    atomic<long long> hashes;
+
+    void start_helpers();
+    void helper_loop(unsigned int index, unsigned long long seen_round);
+    bool next_chunk(unsigned int index, nonce_chunk& chunk);
+    void run_chunks(unsigned int index);
+    void search_chunk(const nonce_chunk& chunk);
+
+public:
+    // 0 threads uses the number of hardware threads
+    explicit NonceSearchPool(unsigned int num_threads = 0);
+    ~NonceSearchPool();
+    NonceSearchPool(const NonceSearchPool&) = delete;
+    NonceSearchPool& operator=(const NonceSearchPool&) = delete;
+
+    // one round over the ranges of all jobs, sets their found nonces and returns the hashes of all workers
+    long long search(vector<nonce_search_job>& round_jobs, uint64_t hash_target);
+    // joins the helper threads, they are started again by the next search (threads do not survive fork)
+    void stop_helpers();
+    unsigned int size() const;
+};
+
+// block some node is mining, its nonces are tried in order at the node's hash rate from start_time on
+struct mining_job
+{
+    object_ptr<Block> blk;
+    long long start_time;
+    double hashing_fraction;
+    sha256_midstate prefix;
+    long long searched; // nonces below have been hashed
+    long long found; // lowest valid nonce below searched, -1 if none
+};
+
+// Block discovery by nonce search. The target makes a hash succeed with probability 1/hashes_per_block, and a
+// node with hashing fraction f computes hashes_per_block * f hashes per block_inter_arrival_time, so mining
+// times follow the same exponential distribution as the delay model.
+// All mining nodes search at once: each round advances the simulated time by a slice, every node hashes the
+// nonces its share of the hash rate completes in the slice, and the first valid nonce in time mines its block.
+class ProofOfWork
+{
+    NonceSearchPool pool;
+    long long hashes_per_block;
+    long long block_inter_arrival_time;
+    uint64_t target;
+
+    // performance of the searches of this process
+    long long hashes;
+    double search_seconds;
+
+    long long nonces_done_by(const mining_job& job, long long time) const;
+    long long completion_time(const mining_job& job, long long nonce) const;
+
+public:
+    // state of the run, saved by snapshots
+    map<int, mining_job> jobs; // by node id
+    long long searched_until; // all jobs are searched up to this simulation time
+    long long blocks_found;
+    double exposure; // hashing fraction of the mining nodes times the time searched since the last block found
+    double scaled_time_sum; // exposure per block found, averages block_inter_arrival_time
+    double scaled_time_square_sum;
+
+    ProofOfWork(long long hashes_per_block, long long block_inter_arrival_time, unsigned int num_threads);
+
+    // node starts mining blk at start_time, returns the block it mined before, if any
+    object_ptr<Block> start(int node_id, const object_ptr<Block>& blk, double hashing_fraction, long long start_time);
+    // sets up the header midstate of a job read from a snapshot
+    void resume(mining_job& job) const;
+    // searches until the first block found at or before until and queues its BLOCK_MINED event, without
+    // jobs or a block found it only moves searched_until to until
+    void advance(long long until, EQ& queue);
+    bool idle() const;
+    void stop_helpers();
+    void print_statistics(ostream& os) const;
+};
+
+#endif //PROOFOFWORK_H
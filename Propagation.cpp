@@ -0,0 +1,140 @@
+#include "Propagation.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "Network.h"
+
+thread_local PropagationTracker propagation;
+
+static const char* const coverage_names[PROPAGATION_COVERAGES] = {"50", "90", "100"};
+static const char* const class_names[PROPAGATION_CLASSES] = {"honest", "ringmaster"};
+static const char* const mode_names[PROPAGATION_MODES] = {"none", "mitigation", "eclipse", "eclipse+mitigation"};
+
+void propagation_histogram::add(const long long latency)
+{
+    const int bucket = 63 - __builtin_clzll(static_cast<unsigned long long>(latency) + 1);
+    buckets[min(bucket, PROPAGATION_BUCKETS - 1)]++;
+    blocks++;
+    total_latency += latency;
+    max_latency = max(max_latency, latency);
+}
+
+PropagationTracker::PropagationTracker()
+{
+    reset(0);
+}
+
+void PropagationTracker::reset(const int honest_nodes)
+{
+    this->honest_nodes = honest_nodes;
+    pending.clear();
+    for (int mode = 0; mode < PROPAGATION_MODES; mode++)
+        for (int miner_class = 0; miner_class < PROPAGATION_CLASSES; miner_class++)
+        {
+            blocks_mined[mode][miner_class] = 0;
+            for (auto& histogram : histograms[mode][miner_class])
+                histogram = propagation_histogram();
+        }
+}
+
+void PropagationTracker::block_mined(const long long block_id, const bool honest_miner, const long long time)
+{
+    if (honest_nodes == 0)
+        return;
+    const int mode = eclipse_attack * 2 + mitigation;
+    blocks_mined[mode][!honest_miner]++;
+    pending[block_id] = {time, 0, 0, mode, honest_miner};
+}
+
+void PropagationTracker::block_reached(const long long block_id, const long long time)
+{
+    const auto it = pending.find(block_id);
+    if (it == pending.end())
+        return;
+    propagation_pending& block = it->second;
+    block.honest_reached++;
+
+    // nodes needed for each coverage, rounded up; a node can complete more than one of them
+    const int needed[PROPAGATION_COVERAGES] = {(honest_nodes + 1) / 2, (9 * honest_nodes + 9) / 10, honest_nodes};
+    for (int coverage = 0; coverage < PROPAGATION_COVERAGES; coverage++)
+        if (block.honest_reached == needed[coverage])
+            histograms[block.mode][!block.honest_miner][coverage].add(time - block.mined_time);
+    if (block.honest_reached + block.honest_passed == honest_nodes)
+        pending.erase(it);
+}
+
+void PropagationTracker::node_finalized(const map<long long, long long>& accepted, const long long from,
+                                        const long long to)
+{
+    for (auto it = pending.lower_bound(from); it != pending.end() && it->first < to;)
+    {
+        propagation_pending& block = it->second;
+        if (accepted.count(it->first) == 0)
+            block.honest_passed++;
+        if (block.honest_reached + block.honest_passed == honest_nodes)
+            it = pending.erase(it);
+        else
+            ++it;
+    }
+}
+
+void PropagationTracker::finish()
+{
+    pending.clear();
+}
+
+void PropagationTracker::write_histograms(const string& filepath) const
+{
+    ofstream file(filepath);
+    if (!file)
+    {
+        cerr << "An Error occurred while opening file!" << endl;
+        return;
+    }
+    file << "mode,miner,coverage_percent,blocks_mined,blocks_reached,bucket_low_ms,bucket_high_ms,blocks" << "\n";
+    for (int mode = 0; mode < PROPAGATION_MODES; mode++)
+        for (int miner_class = 0; miner_class < PROPAGATION_CLASSES; miner_class++)
+        {
+            if (blocks_mined[mode][miner_class] == 0)
+                continue;
+            for (int coverage = 0; coverage < PROPAGATION_COVERAGES; coverage++)
+            {
+                const propagation_histogram& histogram = histograms[mode][miner_class][coverage];
+                for (int bucket = 0; bucket < PROPAGATION_BUCKETS; bucket++)
+                    if (histogram.buckets[bucket] != 0)
+                        file << mode_names[mode] << "," << class_names[miner_class] << "," << coverage_names[coverage]
+                            << "," << blocks_mined[mode][miner_class] << "," << histogram.blocks << ","
+                            << (1LL << bucket) - 1 << "," << (1LL << (bucket + 1)) - 1 << ","
+                            << histogram.buckets[bucket] << "\n";
+            }
+        }
+}
+
+void PropagationTracker::print_summary(ostream& os) const
+{
+    for (int mode = 0; mode < PROPAGATION_MODES; mode++)
+        for (int miner_class = 0; miner_class < PROPAGATION_CLASSES; miner_class++)
+        {
+            const long long mined = blocks_mined[mode][miner_class];
+            if (mined == 0)
+                continue;
+            os << " Propagation of " << mined << " " << class_names[miner_class] << " blocks (" << mode_names[mode]
+                << "):";
+            for (int coverage = 0; coverage < PROPAGATION_COVERAGES; coverage++)
+            {
+                const propagation_histogram& histogram = histograms[mode][miner_class][coverage];
+                os << " " << coverage_names[coverage] << "% ";
+                if (histogram.blocks == 0)
+                    os << "never";
+                else
+                    os << "mean " << fixed << setprecision(0)
+                        << static_cast<double>(histogram.total_latency) / static_cast<double>(histogram.blocks)
+                        << " ms max " << histogram.max_latency << " ms";
+                if (histogram.blocks != mined)
+                    os << " (" << mined - histogram.blocks << " not reached)";
+                os << (coverage + 1 < PROPAGATION_COVERAGES ? "," : "");
+            }
+            os << defaultfloat << setprecision(6) << endl;
+        }
+}
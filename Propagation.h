@@ -0,0 +1,73 @@
+#ifndef PROPAGATION_H
+#define PROPAGATION_H
+
+#include <array>
+#include <map>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+/*
+ * Online block propagation latency: the time from BLOCK_MINED until 50%, 90% and 100% of the honest nodes accepted a
+ * block, collected while the simulation runs instead of being reconstructed from the first seen times of the node
+ * files. Latencies go into log2 histograms split by the class of the miner and by the eclipse/mitigation mode at the
+ * time the block was mined, so branches and restored runs with other toggles keep their blocks apart.
+ */
+
+#define PROPAGATION_BUCKETS 40 // bucket b holds latencies in [2^b - 1, 2^(b+1) - 1) ms, the last one everything above
+#define PROPAGATION_COVERAGES 3 // 50%, 90% and 100% of the honest nodes
+#define PROPAGATION_CLASSES 2 // honest miner, ringmaster
+#define PROPAGATION_MODES 4 // eclipse * 2 + mitigation
+
+struct propagation_histogram
+{
+    array<long long, PROPAGATION_BUCKETS> buckets{};
+    long long blocks = 0; // blocks that reached the coverage
+    long long total_latency = 0;
+    long long max_latency = 0;
+
+    void add(long long latency);
+};
+
+// a mined block that some honest node has not accepted yet
+struct propagation_pending
+{
+    long long mined_time;
+    int honest_reached; // honest nodes that accepted the block
+    int honest_passed; // honest nodes that finalized past the block without accepting it
+    int mode;
+    bool honest_miner;
+};
+
+class PropagationTracker
+{
+public:
+    int honest_nodes;
+    map<long long, propagation_pending> pending; // by block id
+    long long blocks_mined[PROPAGATION_MODES][PROPAGATION_CLASSES];
+    propagation_histogram histograms[PROPAGATION_MODES][PROPAGATION_CLASSES][PROPAGATION_COVERAGES];
+
+    PropagationTracker();
+    // forgets all blocks, for a new simulation with honest_nodes honest nodes on this thread
+    void reset(int honest_nodes);
+    // the block was mined at time under the current attack toggles
+    void block_mined(long long block_id, bool honest_miner, long long time);
+    // an honest node accepted the block at time, blocks that were not mined are ignored
+    void block_reached(long long block_id, long long time);
+    // an honest node moved its finality watermark from from to to, blocks in between that it has not accepted can no
+    // longer reach it; a block is dropped once every honest node accepted it or passed it
+    void node_finalized(const map<long long, long long>& accepted, long long from, long long to);
+    // drops the blocks still spreading at the end of the run, they count as never reaching the coverages they missed
+    void finish();
+
+    // histogram rows of every mode and class that mined blocks
+    void write_histograms(const string& filepath) const;
+    // mean and maximum latency per coverage and the blocks that did not reach it
+    void print_summary(ostream& os) const;
+};
+
+// tracker of the simulation on this thread
+extern thread_local PropagationTracker propagation;
+
+#endif //PROPAGATION_H
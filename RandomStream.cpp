@@ -0,0 +1,201 @@
+#include "RandomStream.h"
+
+#include <cstring>
+
+// Philox4x32 round constants (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+static const uint32_t philox_m0 = 0xD2511F53;
+static const uint32_t philox_m1 = 0xCD9E8D57;
+static const uint32_t philox_w0 = 0x9E3779B9;
+static const uint32_t philox_w1 = 0xBB67AE85;
+
+// marks the counter sequence of the exponential variates
+static const uint32_t exponential_sequence = 0x80000000u;
+
+RandomStream::RandomStream() : RandomStream(0, RNG_NO_NODE, 0)
+{
+}
+
+RandomStream::RandomStream(const unsigned int seed, const uint32_t node, const uint32_t purpose)
+{
+    key[0] = seed;
+    key[1] = 0;
+    this->node = node;
+    this->purpose = purpose;
+    uniform_block = 0;
+    exponential_block = 0;
+    batch = batch_size(purpose);
+    uniform_position = batch;
+    exponential_position = batch;
+}
+
+RandomStream::RandomStream(const random_stream_state& state) : RandomStream(state.seed, state.node, state.purpose)
+{
+    // buffers hold the batch before the block counters, refill them from there
+    if (state.uniform_position < batch)
+    {
+        uniform_block = state.uniform_block - batch / 4;
+        refill_uniforms();
+    }
+    if (state.exponential_position < batch)
+    {
+        exponential_block = state.exponential_block - batch / 2;
+        refill_exponentials();
+    }
+    uniform_block = state.uniform_block;
+    exponential_block = state.exponential_block;
+    uniform_position = state.uniform_position;
+    exponential_position = state.exponential_position;
+}
+
+random_stream_state RandomStream::state() const
+{
+    return {key[0], node, purpose, uniform_position, exponential_position, uniform_block, exponential_block};
+}
+
+int RandomStream::batch_size(const uint32_t purpose)
+{
+    return purpose == RNG_TOPOLOGY || purpose == RNG_TRANSACTION ? RNG_COLD_BATCH : RNG_BATCH;
+}
+
+void RandomStream::philox(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+{
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; round++)
+    {
+        const uint64_t p0 = static_cast<uint64_t>(philox_m0) * c0;
+        const uint64_t p1 = static_cast<uint64_t>(philox_m1) * c2;
+        const uint32_t hi0 = static_cast<uint32_t>(p0 >> 32), lo0 = static_cast<uint32_t>(p0);
+        const uint32_t hi1 = static_cast<uint32_t>(p1 >> 32), lo1 = static_cast<uint32_t>(p1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += philox_w0;
+        k1 += philox_w1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+void RandomStream::philox_batch(const uint64_t first_block, const uint32_t counter2, const uint32_t counter3,
+                                const uint32_t key[2], uint32_t* out, const int blocks)
+{
+    // one lane per block, structure of arrays so every round is a vectorizable loop over the lanes
+    uint32_t c0[RNG_BATCH / 4], c1[RNG_BATCH / 4], c2[RNG_BATCH / 4], c3[RNG_BATCH / 4];
+    for (int start = 0; start < blocks; start += RNG_BATCH / 4)
+    {
+        const int lanes = blocks - start < RNG_BATCH / 4 ? blocks - start : RNG_BATCH / 4;
+        for (int i = 0; i < lanes; i++)
+        {
+            const uint64_t block = first_block + start + i;
+            c0[i] = static_cast<uint32_t>(block);
+            c1[i] = static_cast<uint32_t>(block >> 32);
+            c2[i] = counter2;
+            c3[i] = counter3;
+        }
+
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; round++)
+        {
+            for (int i = 0; i < lanes; i++)
+            {
+                const uint64_t p0 = static_cast<uint64_t>(philox_m0) * c0[i];
+                const uint64_t p1 = static_cast<uint64_t>(philox_m1) * c2[i];
+                const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[i] ^ k0;
+                const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[i] ^ k1;
+                c1[i] = static_cast<uint32_t>(p1);
+                c3[i] = static_cast<uint32_t>(p0);
+                c0[i] = n0;
+                c2[i] = n2;
+            }
+            k0 += philox_w0;
+            k1 += philox_w1;
+        }
+
+        for (int i = 0; i < lanes; i++)
+        {
+            uint32_t* block_out = out + 4 * (start + i);
+            block_out[0] = c0[i];
+            block_out[1] = c1[i];
+            block_out[2] = c2[i];
+            block_out[3] = c3[i];
+        }
+    }
+}
+
+// natural log of x > 0 built from integer and floating point arithmetic only, so loops over it vectorize
+// relative error below 1e-15
+static inline double log_positive(const double x)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    // mantissa reduced to [sqrt(1/2), sqrt(2)) by moving its top part one binade down,
+    // selected with integer arithmetic since floating point compares keep the loop from vectorizing
+    const uint64_t mantissa = bits & 0x000FFFFFFFFFFFFFull;
+    const uint64_t high = (0x6A09E667F3BCCull - mantissa) >> 63; // 1 if mantissa > sqrt(2)
+    const uint64_t m_bits = mantissa | ((0x3FFull - high) << 52);
+    double m;
+    memcpy(&m, &m_bits, sizeof(m));
+
+    // unbiased exponent converted exactly through the mantissa of 2^52 instead of an int to double conversion
+    const uint64_t exponent_bits = ((bits >> 52) + high) | 0x4330000000000000ull;
+    double exponent;
+    memcpy(&exponent, &exponent_bits, sizeof(exponent));
+    exponent -= 4503599627370496.0 + 1023.0;
+
+    // log(m) = 2 atanh(s) with s = (m - 1) / (m + 1), |s| < 0.172
+    const double s = (m - 1.0) / (m + 1.0);
+    const double s2 = s * s;
+    const double series = 1.0 + s2 * (1.0 / 3 + s2 * (1.0 / 5 + s2 * (1.0 / 7 + s2 * (1.0 / 9 + s2 * (1.0 / 11 +
+        s2 * (1.0 / 13 + s2 * (1.0 / 15 + s2 * (1.0 / 17))))))));
+    return exponent * 0.6931471805599453 + 2.0 * s * series;
+}
+
+void RandomStream::unit_exponentials(const uint32_t* words, double* out, const int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        // 52 random bits as the mantissa of d in [1, 2), 1 - u = 2 - d lies in (0, 1]
+        const uint64_t mantissa = (static_cast<uint64_t>(words[2 * i]) << 20) | (words[2 * i + 1] >> 12);
+        const uint64_t bits = (mantissa & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull;
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        out[i] = -log_positive(2.0 - d);
+    }
+}
+
+void RandomStream::refill_uniforms()
+{
+    uniforms.resize(batch);
+    philox_batch(uniform_block, node, purpose, key, uniforms.data(), batch / 4);
+    uniform_block += batch / 4;
+    uniform_position = 0;
+}
+
+void RandomStream::refill_exponentials()
+{
+    uint32_t words[2 * RNG_BATCH];
+    exponentials.resize(batch);
+    philox_batch(exponential_block, node, purpose | exponential_sequence, key, words, batch / 2);
+    exponential_block += batch / 2;
+    unit_exponentials(words, exponentials.data(), batch);
+    exponential_position = 0;
+}
+
+int RandomStream::uniform(const int min, const int max)
+{
+    // multiply-shift with rejection of the biased low products (Lemire)
+    const uint32_t range = static_cast<uint32_t>(static_cast<int64_t>(max) - min + 1);
+    uint64_t product = static_cast<uint64_t>(next_u32()) * range;
+    if (static_cast<uint32_t>(product) < range)
+    {
+        const uint32_t threshold = -range % range;
+        while (static_cast<uint32_t>(product) < threshold)
+            product = static_cast<uint64_t>(next_u32()) * range;
+    }
+    return static_cast<int>(min + static_cast<int64_t>(product >> 32));
+}
@@ -0,0 +1,97 @@
+#ifndef RANDOMSTREAM_H
+#define RANDOMSTREAM_H
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// purpose of a random stream, part of its key
+#define RNG_TOPOLOGY 0 // peer selection and link propagation delays
+#define RNG_LINK_LATENCY 1 // queuing delay of every message sent over a link
+#define RNG_MINING_TIME 2
+#define RNG_TRANSACTION 3 // receiver and amount of created transactions
+#define RNG_TRANSACTION_ARRIVAL 4 // creators and times of the initial transactions
+
+// node field of streams owned by the simulation instead of a node
+#define RNG_NO_NODE 0xffffffffu
+
+// values generated per refill of a stream buffer
+#define RNG_BATCH 64
+// per refill of the rarely drawn topology and transaction streams, one Philox block of uniforms
+#define RNG_COLD_BATCH 4
+
+// position of a stream, enough to recreate it including its buffered values
+struct random_stream_state
+{
+    uint32_t seed;
+    uint32_t node;
+    uint32_t purpose;
+    int32_t uniform_position;
+    int32_t exponential_position;
+    uint64_t uniform_block;
+    uint64_t exponential_block;
+};
+
+// Counter based generator (Philox4x32-10). The value of the i-th draw of a stream is a pure function of
+// (seed, node, purpose, i), so each stream is independent of how events of other streams interleave.
+// Uniform words and unit exponential variates are generated in batches from two disjoint counter sequences,
+// the hot paths only pop precomputed values. The batch depends on the purpose: RNG_BATCH for the hot streams,
+// RNG_COLD_BATCH for the cold ones, so the four streams of a node stay small. Buffers are allocated by the first
+// refill. The values of a stream do not depend on its batch.
+class RandomStream
+{
+    uint32_t key[2];
+    uint32_t node;
+    uint32_t purpose;
+    uint64_t uniform_block; // next Philox block of the uniform sequence
+    uint64_t exponential_block; // next Philox block of the exponential sequence
+    int batch; // values per refill, a multiple of 4
+    int uniform_position; // next unused value in uniforms
+    int exponential_position; // next unused value in exponentials
+    vector<uint32_t> uniforms;
+    vector<double> exponentials; // mean 1
+
+    void refill_uniforms();
+    void refill_exponentials();
+
+public:
+    RandomStream();
+    RandomStream(unsigned int seed, uint32_t node, uint32_t purpose);
+    // regenerates the buffers the stream had when state was taken
+    explicit RandomStream(const random_stream_state& state);
+    random_stream_state state() const;
+    // values per refill of streams with this purpose
+    static int batch_size(uint32_t purpose);
+    // buffers, for memory accounting
+    const vector<uint32_t>& uniform_buffer() const { return uniforms; }
+    const vector<double>& exponential_buffer() const { return exponentials; }
+
+    uint32_t next_u32()
+    {
+        if (uniform_position == batch)
+            refill_uniforms();
+        return uniforms[uniform_position++];
+    }
+
+    // min and max are inclusive
+    int uniform(int min, int max);
+
+    // returns discrete values of an exponential distribution
+    int exponential(const double mean)
+    {
+        if (exponential_position == batch)
+            refill_exponentials();
+        return static_cast<int>(mean * exponentials[exponential_position++]);
+    }
+
+    // single Philox4x32-10 block
+    static void philox(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]);
+    // blocks consecutive Philox blocks starting at first_block, the lanes are computed side by side
+    static void philox_batch(uint64_t first_block, uint32_t counter2, uint32_t counter3, const uint32_t key[2],
+                             uint32_t* out, int blocks);
+    // converts 2n random words into n variates -log(1 - u) with u uniform in [0, 1) on a 2^-52 grid
+    static void unit_exponentials(const uint32_t* words, double* out, int n);
+};
+
+#endif //RANDOMSTREAM_H
@@ -0,0 +1,125 @@
+#include "ResultsFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+results_column::results_column(string name, const char type, const size_t number_of_nodes)
+{
+    if (name.size() >= sizeof(results_column_descriptor::name))
+        throw invalid_argument("results column name too long: " + name);
+
+    this->name = std::move(name);
+    this->type = type;
+    if (type == 'i') int_values.resize(number_of_nodes, 0);
+    else real_values.resize(number_of_nodes, 0);
+}
+
+ResultsMembership::ResultsMembership(const uint64_t number_of_blocks)
+{
+    in_tree.resize((number_of_blocks + 63) / 64, 0);
+    in_longest.resize((number_of_blocks + 63) / 64, 0);
+}
+
+void ResultsMembership::add(const uint64_t row, const int64_t first_seen_time, const bool part_of_longest)
+{
+    in_tree[row / 64] |= 1ULL << (row % 64);
+    if (part_of_longest)
+        in_longest[row / 64] |= 1ULL << (row % 64);
+    first_seen.emplace_back(row, first_seen_time);
+}
+
+string ResultsMembership::bytes()
+{
+    // first seen times are stored in row order so they line up with the set bits of in_tree
+    sort(first_seen.begin(), first_seen.end());
+
+    string section;
+    section.reserve((in_tree.size() + in_longest.size() + first_seen.size()) * 8);
+    section.append(reinterpret_cast<const char*>(in_tree.data()), in_tree.size() * 8);
+    section.append(reinterpret_cast<const char*>(in_longest.data()), in_longest.size() * 8);
+    for (const auto& [row, time] : first_seen)
+        section.append(reinterpret_cast<const char*>(&time), 8);
+    return section;
+}
+
+ResultsFileWriter::ResultsFileWriter()
+{
+    number_of_nodes = 0;
+    number_of_blocks = 0;
+    block_table_offset = 0;
+}
+
+bool ResultsFileWriter::open(const string& filepath, const uint32_t number_of_nodes)
+{
+    this->number_of_nodes = number_of_nodes;
+    membership_index.clear();
+    membership_index.reserve(number_of_nodes);
+
+    file.open(filepath, ios::binary | ios::trunc);
+    if (!file)
+        return false;
+
+    // placeholder, rewritten with the final offsets by finish()
+    const results_file_header header{};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return true;
+}
+
+void ResultsFileWriter::write_block_table(const vector<results_block_record>& blocks)
+{
+    number_of_blocks = blocks.size();
+    block_table_offset = static_cast<uint64_t>(file.tellp());
+    file.write(reinterpret_cast<const char*>(blocks.data()),
+               static_cast<streamsize>(blocks.size() * sizeof(results_block_record)));
+}
+
+void ResultsFileWriter::append_membership(const string& section)
+{
+    membership_index.push_back({static_cast<uint64_t>(file.tellp()), section.size()});
+    file.write(section.data(), static_cast<streamsize>(section.size()));
+}
+
+void ResultsFileWriter::finish(const deque<results_column>& node_columns)
+{
+    if (membership_index.size() != number_of_nodes)
+        throw logic_error("results file finished with missing membership sections");
+
+    // node table
+    const auto node_table_offset = static_cast<uint64_t>(file.tellp());
+    const uint32_t column_count[2] = {static_cast<uint32_t>(node_columns.size()), 0};
+    file.write(reinterpret_cast<const char*>(column_count), sizeof(column_count));
+    for (const auto& column : node_columns)
+    {
+        results_column_descriptor descriptor{};
+        memcpy(descriptor.name, column.name.data(), column.name.size());
+        descriptor.type = column.type;
+        file.write(reinterpret_cast<const char*>(&descriptor), sizeof(descriptor));
+    }
+    for (const auto& column : node_columns)
+    {
+        if (column.type == 'i')
+            file.write(reinterpret_cast<const char*>(column.int_values.data()),
+                       static_cast<streamsize>(column.int_values.size() * 8));
+        else
+            file.write(reinterpret_cast<const char*>(column.real_values.data()),
+                       static_cast<streamsize>(column.real_values.size() * 8));
+    }
+
+    // index for random access to a single node
+    const auto membership_index_offset = static_cast<uint64_t>(file.tellp());
+    file.write(reinterpret_cast<const char*>(membership_index.data()),
+               static_cast<streamsize>(membership_index.size() * sizeof(results_index_entry)));
+
+    results_file_header header{};
+    memcpy(header.magic, "P2PRSLT", 8);
+    header.version = 1;
+    header.number_of_nodes = number_of_nodes;
+    header.number_of_blocks = number_of_blocks;
+    header.block_table_offset = block_table_offset;
+    header.node_table_offset = node_table_offset;
+    header.membership_index_offset = membership_index_offset;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+}
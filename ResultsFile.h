@@ -0,0 +1,109 @@
+#ifndef RESULTSFILE_H
+#define RESULTSFILE_H
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Consolidated results file (Output/results.bin), little-endian, all offsets in bytes from the file start.
+ *
+ * header                : results_file_header
+ * block table           : number_of_blocks x results_block_record, sorted by block id (row = position)
+ * membership sections   : one per node in node id order
+ *     in_tree bitmap    : ceil(number_of_blocks / 64) uint64 words, bit r set if node has block row r in its tree
+ *     in_longest bitmap : same layout, bit r set if block row r is part of the node's longest chain
+ *     first_seen        : int64 per set bit of in_tree, in row order
+ * node table            : uint32 number_of_columns, uint32 reserved, number_of_columns x results_column_descriptor,
+ *                         then each column as number_of_nodes values of int64 ('i') or float64 ('f')
+ * membership index      : number_of_nodes x results_index_entry pointing at the membership sections
+ */
+
+struct results_file_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t number_of_nodes;
+    uint64_t number_of_blocks;
+    uint64_t block_table_offset;
+    uint64_t node_table_offset;
+    uint64_t membership_index_offset;
+};
+
+struct results_block_record
+{
+    int64_t block_id;
+    int64_t parent_block_id;
+    int64_t creation_time;
+    int64_t num_transactions;
+    int32_t miner; // -1 for genesis
+    int32_t reserved;
+};
+
+struct results_column_descriptor
+{
+    char name[32];
+    char type; // 'i': int64, 'f': float64
+    char reserved[7];
+};
+
+struct results_index_entry
+{
+    uint64_t offset;
+    uint64_t length;
+};
+
+static_assert(sizeof(results_file_header) == 48, "results file header must be packed");
+static_assert(sizeof(results_block_record) == 40, "results block record must be packed");
+static_assert(sizeof(results_column_descriptor) == 40, "results column descriptor must be packed");
+static_assert(sizeof(results_index_entry) == 16, "results index entry must be packed");
+
+// one per-node summary column of the node table
+struct results_column
+{
+    string name;
+    char type;
+    vector<int64_t> int_values;
+    vector<double> real_values;
+
+    results_column(string name, char type, size_t number_of_nodes);
+};
+
+// membership bitmaps and first seen times of a single node
+class ResultsMembership
+{
+    vector<uint64_t> in_tree;
+    vector<uint64_t> in_longest;
+    vector<pair<uint64_t, int64_t>> first_seen; // <row, time>
+
+public:
+    explicit ResultsMembership(uint64_t number_of_blocks);
+    void add(uint64_t row, int64_t first_seen_time, bool part_of_longest);
+    // serialized section as stored in the file
+    string bytes();
+};
+
+// writes the file front to back; sections are appended as they become available
+class ResultsFileWriter
+{
+    ofstream file;
+    uint32_t number_of_nodes;
+    uint64_t number_of_blocks;
+    uint64_t block_table_offset;
+    vector<results_index_entry> membership_index;
+
+public:
+    ResultsFileWriter();
+    bool open(const string& filepath, uint32_t number_of_nodes);
+    void write_block_table(const vector<results_block_record>& blocks);
+    // membership sections must be appended in node id order
+    void append_membership(const string& section);
+    // columns in a deque, so references to added columns stay valid while more are added
+    void finish(const deque<results_column>& node_columns);
+};
+
+#endif //RESULTSFILE_H
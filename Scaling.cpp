@@ -0,0 +1,179 @@
+#include "Scaling.h"
+
+#include <chrono>
+#include <sstream>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+scaling_result::scaling_result()
+{
+    repeat = 0;
+    startup_time = 0;
+    simulation_time = 0;
+    stats_time = 0;
+    events = 0;
+    events_per_sec = 0;
+    peak_rss_kb = -1;
+    peak_rss_reset = false;
+    output_bytes = 0;
+}
+
+vector<SimulationConfig> read_scaling_grid(const string& filepath, const SimulationConfig& base, const string& output_dir)
+{
+    ifstream file(filepath);
+    if (!file)
+        throw runtime_error("Unable to open scaling grid " + filepath);
+
+    // every parameter starts with the single value of base
+    map<string, vector<long long>> grid = {
+        {"nodes", {base.number_of_nodes}},
+        {"malicious", {base.percent_malicious_nodes}},
+        {"transaction_interval", {base.mean_transaction_inter_arrival_time}},
+        {"block_interval", {base.block_inter_arrival_time / 1000}},
+        {"timeout", {base.timer_timeout_time}},
+        {"eclipse", {base.eclipse_attack}},
+        {"shared_ledgers", {base.shared_ledgers}}
+    };
+    string line;
+    int line_number = 0;
+    while (getline(file, line))
+    {
+        line_number++;
+        const auto first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+            continue;
+
+        istringstream fields(line);
+        string parameter;
+        fields >> parameter;
+        if (grid.count(parameter) == 0)
+            throw runtime_error("Unknown parameter " + parameter + " in scaling grid line " + to_string(line_number));
+        vector<long long> values;
+        long long value;
+        while (fields >> value)
+            values.push_back(value);
+        if (values.empty() || !fields.eof())
+            throw runtime_error("Invalid scaling grid line " + to_string(line_number) + ": " + line);
+        grid[parameter] = values;
+    }
+
+    vector<SimulationConfig> configs;
+    for (const long long nodes : grid["nodes"])
+        for (const long long malicious : grid["malicious"])
+            for (const long long transaction_interval : grid["transaction_interval"])
+                for (const long long block_interval : grid["block_interval"])
+                    for (const long long timeout : grid["timeout"])
+                        for (const long long eclipse : grid["eclipse"])
+                        for (const long long shared : grid["shared_ledgers"])
+                        {
+                            SimulationConfig config = base;
+                            config.number_of_nodes = static_cast<int>(nodes);
+                            config.percent_malicious_nodes = static_cast<int>(malicious);
+                            config.mean_transaction_inter_arrival_time = static_cast<int>(transaction_interval);
+                            config.block_inter_arrival_time = static_cast<int>(block_interval * 1000);
+                            config.timer_timeout_time = static_cast<int>(timeout);
+                            config.eclipse_attack = eclipse != 0;
+                            config.shared_ledgers = shared != 0;
+                            if (const string error = config.validate(); !error.empty())
+                                throw runtime_error(error + " in scaling grid point " + to_string(configs.size()));
+                            config.output_dir = output_dir + "/point_" + to_string(configs.size());
+                            configs.push_back(config);
+                        }
+    return configs;
+}
+
+// resets the peak RSS (VmHWM) of the process to its current RSS, false if the kernel does not allow it
+static bool reset_peak_rss()
+{
+    ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.close();
+    return static_cast<bool>(clear_refs);
+}
+
+static long long directory_bytes(const string& dir)
+{
+    long long bytes = 0;
+    error_code error;
+    for (const auto& entry : fs::recursive_directory_iterator(dir, error))
+        if (entry.is_regular_file(error))
+            bytes += static_cast<long long>(entry.file_size(error));
+    return bytes;
+}
+
+vector<scaling_result> run_scaling(const vector<SimulationConfig>& configs, const int repeats)
+{
+    vector<scaling_result> results;
+    for (size_t i = 0; i < configs.size(); i++)
+    {
+        for (int repeat = 0; repeat < repeats; repeat++)
+        {
+            scaling_result result;
+            result.config = configs[i];
+            if (repeats > 1)
+                result.config.output_dir += "/repeat_" + to_string(repeat);
+            result.repeat = repeat;
+            fs::remove_all(result.config.output_dir);
+
+            // hand the heap of the previous run back so it does not count towards this one
+            release_object_pools();
+#ifdef __GLIBC__
+            malloc_trim(0);
+#endif
+            result.peak_rss_reset = reset_peak_rss();
+            try
+            {
+                const auto start = chrono::steady_clock::now();
+                const unique_ptr<Simulator> sim = create_simulator(result.config);
+                result.startup_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                sim->start();
+
+                const run_statistics& statistics = sim->get_run_statistics();
+                result.simulation_time = statistics.simulation_seconds;
+                result.stats_time = statistics.stats_seconds;
+                result.events = statistics.events_processed;
+                result.events_per_sec = statistics.simulation_seconds > 0
+                                            ? static_cast<double>(statistics.events_processed) /
+                                              statistics.simulation_seconds
+                                            : 0;
+                result.peak_rss_kb = process_memory_kb("VmHWM");
+            }
+            catch (const exception& e)
+            {
+                result.error = e.what();
+            }
+            result.output_bytes = directory_bytes(result.config.output_dir);
+            results.push_back(result);
+
+            cout << " Scaling point " << i << " repeat " << repeat << ": " << result.events << " events, "
+                << result.events_per_sec << " events/s, peak RSS " << result.peak_rss_kb << " kB" << endl;
+        }
+    }
+    return results;
+}
+
+void write_scaling_results(const vector<scaling_result>& results, const string& filepath)
+{
+    ofstream file(filepath);
+    if (!file)
+    {
+        cerr << "An Error occurred while opening file!" << endl;
+        return;
+    }
+
+    file << "number_of_nodes,percent_malicious,mean_transaction_inter_arrival,block_inter_arrival,timeout,is_eclipse,"
+            "shared_ledgers,repeat,output_dir,startup_sec,simulation_sec,stats_sec,events,events_per_sec,peak_rss_kb,peak_rss_reset,"
+            "output_bytes,error" << endl;
+    for (const auto& result : results)
+    {
+        const SimulationConfig& config = result.config;
+        file << config.number_of_nodes << "," << config.percent_malicious_nodes << ","
+            << config.mean_transaction_inter_arrival_time << "," << config.block_inter_arrival_time / 1000 << ","
+            << config.timer_timeout_time << "," << config.eclipse_attack << "," << config.shared_ledgers << "," << result.repeat << ","
+            << config.output_dir << "," << result.startup_time << "," << result.simulation_time << ","
+            << result.stats_time << "," << result.events << "," << result.events_per_sec << ","
+            << result.peak_rss_kb << "," << result.peak_rss_reset << "," << result.output_bytes << ","
+            << result.error << endl;
+    }
+}
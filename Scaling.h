@@ -0,0 +1,41 @@
+#ifndef SCALING_H
+#define SCALING_H
+
+#include "Simulator.h"
+
+// cost of one full run of a scaling grid point
+struct scaling_result
+{
+    SimulationConfig config;
+    int repeat;
+    double startup_time; // seconds to build the network, genesis and initial events
+    double simulation_time; // seconds of the event loop
+    double stats_time; // seconds of the stats phase
+    long long events;
+    double events_per_sec;
+    long long peak_rss_kb; // of this run if the high water mark could be reset, otherwise of the process so far
+    bool peak_rss_reset;
+    long long output_bytes; // everything the run wrote to its output directory
+    string error; // empty if the run completed
+
+    scaling_result();
+};
+
+// Reads a grid of parameter values, one parameter per line followed by its values, every combination is a run:
+//   nodes 50 100 200
+//   malicious 10 30
+//   transaction_interval 50 100    (mean_transaction_inter_arrival_time, ms)
+//   block_interval 10              (seconds)
+//   timeout 1000
+//   eclipse 0 1
+//   shared_ledgers 0 1             (honest nodes share ledgers)
+// parameters that are not listed keep the values of base, blank lines and lines starting with # are skipped
+vector<SimulationConfig> read_scaling_grid(const string& filepath, const SimulationConfig& base, const string& output_dir);
+
+// runs every configuration repeats times one after the other on this thread, so the runs do not share the machine
+vector<scaling_result> run_scaling(const vector<SimulationConfig>& configs, int repeats);
+
+// one row per run
+void write_scaling_results(const vector<scaling_result>& results, const string& filepath);
+
+#endif //SCALING_H
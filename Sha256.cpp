@@ -0,0 +1,396 @@
+#include "Sha256.h"
+
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SHA256_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+static const uint32_t round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static const uint32_t initial_state[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+static inline uint32_t rotr(const uint32_t x, const int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t load_be32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+        (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+static inline void store_be32(uint8_t* p, const uint32_t x)
+{
+    p[0] = static_cast<uint8_t>(x >> 24);
+    p[1] = static_cast<uint8_t>(x >> 16);
+    p[2] = static_cast<uint8_t>(x >> 8);
+    p[3] = static_cast<uint8_t>(x);
+}
+
+// padding of the last length bytes of a message: their partial last block followed by 0x80, zeros and the
+// bit length of the message including prefix_length bytes already hashed (a multiple of 64)
+// returns the number of tail blocks (1 or 2) written to tail
+static size_t pad_tail(const uint8_t* data, const size_t length, const size_t prefix_length, uint8_t tail[128])
+{
+    const size_t remainder = length % 64;
+    const size_t tail_blocks = remainder < 56 ? 1 : 2;
+    memset(tail, 0, 128);
+    memcpy(tail, data + length - remainder, remainder);
+    tail[remainder] = 0x80;
+    const uint64_t bits = static_cast<uint64_t>(prefix_length + length) * 8;
+    for (int i = 0; i < 8; i++)
+        tail[tail_blocks * 64 - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    return tail_blocks;
+}
+
+static void transform_scalar(uint32_t state[8], const uint8_t* blocks, size_t number_of_blocks)
+{
+    uint32_t w[64];
+    for (; number_of_blocks > 0; number_of_blocks--, blocks += 64)
+    {
+        for (int t = 0; t < 16; t++)
+            w[t] = load_be32(blocks + 4 * t);
+        for (int t = 16; t < 64; t++)
+        {
+            const uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            const uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; t++)
+        {
+            const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) +
+                round_constants[t] + w[t];
+            const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#ifdef SHA256_X86
+
+// SHA extensions, two rounds per sha256rnds2 (Intel reference flow)
+__attribute__((target("sha,sse4.1")))
+static void transform_shani(uint32_t state[8], const uint8_t* blocks, size_t number_of_blocks)
+{
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // state as ABEF and CDGH
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1); // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B); // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0); // CDGH
+
+    for (; number_of_blocks > 0; number_of_blocks--, blocks += 64)
+    {
+        const __m128i abef_save = state0;
+        const __m128i cdgh_save = state1;
+        __m128i msg[4];
+        for (int i = 0; i < 4; i++)
+            msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16 * i)), byte_swap);
+
+        // 16 groups of 4 rounds, the message schedule runs 3 groups ahead
+        for (int group = 0; group < 16; group++)
+        {
+            __m128i& current = msg[group & 3];
+            __m128i m = _mm_add_epi32(current,
+                                      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&round_constants[4 * group])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+            m = _mm_shuffle_epi32(m, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+
+            if (group >= 3 && group < 15)
+            {
+                // completes w[4(group+1) .. 4(group+1)+3]
+                __m128i& next = msg[(group + 1) & 3];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(current, msg[(group + 3) & 3], 4));
+                next = _mm_sha256msg2_epu32(next, current);
+            }
+            if (group >= 1 && group < 13)
+                msg[(group + 3) & 3] = _mm_sha256msg1_epu32(msg[(group + 3) & 3], current);
+        }
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1); // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8); // ABEF
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET static inline __m256i rotr8(const __m256i x, const int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+// one block of 8 independent messages, lane i holds the state of message i
+AVX2_TARGET static void transform_avx2_8(__m256i state[8], const uint8_t* const blocks[8])
+{
+    __m256i w[64];
+    for (int t = 0; t < 16; t++)
+        w[t] = _mm256_setr_epi32(
+            static_cast<int>(load_be32(blocks[0] + 4 * t)), static_cast<int>(load_be32(blocks[1] + 4 * t)),
+            static_cast<int>(load_be32(blocks[2] + 4 * t)), static_cast<int>(load_be32(blocks[3] + 4 * t)),
+            static_cast<int>(load_be32(blocks[4] + 4 * t)), static_cast<int>(load_be32(blocks[5] + 4 * t)),
+            static_cast<int>(load_be32(blocks[6] + 4 * t)), static_cast<int>(load_be32(blocks[7] + 4 * t)));
+    for (int t = 16; t < 64; t++)
+    {
+        const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[t - 15], 7), rotr8(w[t - 15], 18)),
+                                            _mm256_srli_epi32(w[t - 15], 3));
+        const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[t - 2], 17), rotr8(w[t - 2], 19)),
+                                            _mm256_srli_epi32(w[t - 2], 10));
+        w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], s0), _mm256_add_epi32(w[t - 7], s1));
+    }
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int t = 0; t < 64; t++)
+    {
+        const __m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(e, 6), rotr8(e, 11)), rotr8(e, 25));
+        const __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        const __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, sigma1),
+                                            _mm256_add_epi32(_mm256_add_epi32(choose, w[t]),
+                                                             _mm256_set1_epi32(static_cast<int>(round_constants[t]))));
+        const __m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(a, 2), rotr8(a, 13)), rotr8(a, 22));
+        const __m256i majority = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+                                                  _mm256_and_si256(b, c));
+        const __m256i t2 = _mm256_add_epi32(sigma0, majority);
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+    state[0] = _mm256_add_epi32(state[0], a);
+    state[1] = _mm256_add_epi32(state[1], b);
+    state[2] = _mm256_add_epi32(state[2], c);
+    state[3] = _mm256_add_epi32(state[3], d);
+    state[4] = _mm256_add_epi32(state[4], e);
+    state[5] = _mm256_add_epi32(state[5], f);
+    state[6] = _mm256_add_epi32(state[6], g);
+    state[7] = _mm256_add_epi32(state[7], h);
+}
+
+// 8 messages of equal length, all continuing from start after prefix_length bytes
+AVX2_TARGET static void hash_avx2_8(const uint32_t start[8], const size_t prefix_length, const uint8_t* data,
+                                    const size_t length, sha256_digest* out)
+{
+    __m256i state[8];
+    for (int i = 0; i < 8; i++)
+        state[i] = _mm256_set1_epi32(static_cast<int>(start[i]));
+
+    const uint8_t* blocks[8];
+    const size_t full_blocks = length / 64;
+    for (size_t block = 0; block < full_blocks; block++)
+    {
+        for (int lane = 0; lane < 8; lane++)
+            blocks[lane] = data + lane * length + block * 64;
+        transform_avx2_8(state, blocks);
+    }
+
+    uint8_t tails[8][128];
+    size_t tail_blocks = 0;
+    for (int lane = 0; lane < 8; lane++)
+        tail_blocks = pad_tail(data + lane * length, length, prefix_length, tails[lane]);
+    for (size_t block = 0; block < tail_blocks; block++)
+    {
+        for (int lane = 0; lane < 8; lane++)
+            blocks[lane] = tails[lane] + block * 64;
+        transform_avx2_8(state, blocks);
+    }
+
+    alignas(32) uint32_t words[8][8];
+    for (int i = 0; i < 8; i++)
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+    for (int lane = 0; lane < 8; lane++)
+        for (int i = 0; i < 8; i++)
+            store_be32(out[lane].data() + 4 * i, words[i][lane]);
+}
+
+static bool cpu_has(const int kernel)
+{
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (kernel == SHA256_KERNEL_SCALAR)
+        return true;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        return false;
+    if (kernel == SHA256_KERNEL_SHANI)
+    {
+        const bool sha = (ebx >> 29) & 1;
+        __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+        return sha && ((ecx >> 19) & 1) && ((ecx >> 9) & 1); // SSE4.1 and SSSE3
+    }
+    const bool avx2 = (ebx >> 5) & 1;
+    // the OS must save the AVX registers
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!avx2 || !((ecx >> 27) & 1))
+        return false;
+    unsigned int xcr0_low, xcr0_high;
+    __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+    return (xcr0_low & 6) == 6;
+}
+
+#else
+
+static bool cpu_has(const int kernel)
+{
+    return kernel == SHA256_KERNEL_SCALAR;
+}
+
+#endif
+
+static int detect_kernel()
+{
+    if (cpu_has(SHA256_KERNEL_SHANI)) return SHA256_KERNEL_SHANI;
+    if (cpu_has(SHA256_KERNEL_AVX2)) return SHA256_KERNEL_AVX2;
+    return SHA256_KERNEL_SCALAR;
+}
+
+// detected once per process, read by all simulation threads
+static int active_kernel = detect_kernel();
+
+int sha256_kernel()
+{
+    return active_kernel;
+}
+
+const char* sha256_kernel_name(const int kernel)
+{
+    if (kernel == SHA256_KERNEL_SHANI) return "SHA-NI";
+    if (kernel == SHA256_KERNEL_AVX2) return "AVX2 8-way";
+    return "scalar";
+}
+
+bool sha256_kernel_supported(const int kernel)
+{
+    return cpu_has(kernel);
+}
+
+bool sha256_set_kernel(const int kernel)
+{
+    if (!cpu_has(kernel))
+        return false;
+    active_kernel = kernel;
+    return true;
+}
+
+static void transform(uint32_t state[8], const uint8_t* blocks, const size_t number_of_blocks, const int kernel)
+{
+#ifdef SHA256_X86
+    if (kernel == SHA256_KERNEL_SHANI)
+    {
+        transform_shani(state, blocks, number_of_blocks);
+        return;
+    }
+#endif
+    transform_scalar(state, blocks, number_of_blocks);
+}
+
+// single message with the SHA-NI or scalar kernel, continuing from start after prefix_length bytes
+static void hash_one(const uint32_t start[8], const size_t prefix_length, const uint8_t* data, const size_t length,
+                     sha256_digest& out, const int kernel)
+{
+    uint32_t state[8];
+    memcpy(state, start, sizeof(state));
+    uint8_t tail[128];
+    const size_t tail_blocks = pad_tail(data, length, prefix_length, tail);
+    transform(state, data, length / 64, kernel);
+    transform(state, tail, tail_blocks, kernel);
+    for (int i = 0; i < 8; i++)
+        store_be32(out.data() + 4 * i, state[i]);
+}
+
+sha256_digest sha256(const void* data, const size_t length)
+{
+    sha256_digest digest;
+    // the multi-buffer kernel needs 8 messages, single messages use scalar code on AVX2 machines
+    hash_one(initial_state, 0, static_cast<const uint8_t*>(data), length, digest, active_kernel);
+    return digest;
+}
+
+static void hash_many(const uint32_t start[8], const size_t prefix_length, const uint8_t* data, const size_t length,
+                      const size_t count, sha256_digest* out)
+{
+    size_t i = 0;
+#ifdef SHA256_X86
+    if (active_kernel == SHA256_KERNEL_AVX2)
+        for (; i + 8 <= count; i += 8)
+            hash_avx2_8(start, prefix_length, data + i * length, length, out + i);
+#endif
+    for (; i < count; i++)
+        hash_one(start, prefix_length, data + i * length, length, out[i], active_kernel);
+}
+
+void sha256_many(const uint8_t* data, const size_t length, const size_t count, sha256_digest* out)
+{
+    hash_many(initial_state, 0, data, length, count, out);
+}
+
+sha256_midstate sha256_prefix(const uint8_t prefix[64])
+{
+    sha256_midstate midstate;
+    memcpy(midstate.state, initial_state, sizeof(initial_state));
+    transform(midstate.state, prefix, 1, active_kernel);
+    return midstate;
+}
+
+void sha256_many_after(const sha256_midstate& prefix, const uint8_t* data, const size_t length, const size_t count,
+                       sha256_digest* out)
+{
+    hash_many(prefix.state, 64, data, length, count, out);
+}
+
+string to_hex(const sha256_digest& digest)
+{
+    static const char digits[] = "0123456789abcdef";
+    string hex;
+    hex.reserve(64);
+    for (const uint8_t byte : digest)
+    {
+        hex.push_back(digits[byte >> 4]);
+        hex.push_back(digits[byte & 15]);
+    }
+    return hex;
+}
@@ -0,0 +1,41 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+typedef array<uint8_t, 32> sha256_digest;
+
+// SHA-256 compression kernels, the best one the CPU supports is chosen on first use
+#define SHA256_KERNEL_SCALAR 0
+#define SHA256_KERNEL_AVX2 1 // 8 messages side by side, only used by sha256_many
+#define SHA256_KERNEL_SHANI 2
+
+int sha256_kernel();
+const char* sha256_kernel_name(int kernel);
+bool sha256_kernel_supported(int kernel);
+// overrides the dispatch of this process, returns false if the CPU lacks the kernel
+bool sha256_set_kernel(int kernel);
+
+sha256_digest sha256(const void* data, size_t length);
+// hashes count messages of length bytes stored back to back, out receives count digests
+void sha256_many(const uint8_t* data, size_t length, size_t count, sha256_digest* out);
+
+// state after the first 64 bytes of a message, for hashing many messages that start with the same bytes
+struct sha256_midstate
+{
+    uint32_t state[8];
+};
+
+sha256_midstate sha256_prefix(const uint8_t prefix[64]);
+// hashes count messages made of the prefix followed by length bytes each, stored back to back
+void sha256_many_after(const sha256_midstate& prefix, const uint8_t* data, size_t length, size_t count,
+                       sha256_digest* out);
+
+string to_hex(const sha256_digest& digest);
+
+#endif //SHA256_H
@@ -2,43 +2,269 @@
 
 #include <algorithm>
 #include <numeric>
+#include <chrono>
+#include <sstream>
+#include <climits>
+#include "ThreadPool.h"
+#include "Snapshot.h"
+#include "ResultsFile.h"
+#include "Strategy.h"
+#include "ChainStore.h"
+#include "Propagation.h"
+#include "Probes.h"
+
+// Per-thread simulation state, installed by the Simulator running on this thread
+
+// experiment constants
+thread_local int initial_bitcoin;
+thread_local int initial_number_of_transactions;
+thread_local int propagation_delay_min;
+thread_local int propagation_delay_max;
+thread_local int propagation_delay_malicious_min;
+thread_local int propagation_delay_malicious_max;
+thread_local int transaction_amount_min;
+thread_local int transaction_amount_max;
+thread_local int queuing_delay_constant;
+thread_local int transaction_size;
+thread_local int hash_size;
+thread_local int get_message_size;
+thread_local int mining_reward;
+thread_local int maximum_retries;
+thread_local int stats_threads;
+
+// experiment parameters
+thread_local int number_of_nodes;
+thread_local int percent_malicious_nodes;
+thread_local int mean_transaction_inter_arrival_time;
+thread_local int block_inter_arrival_time;
+thread_local int timer_timeout_time;
+thread_local string output_dir;
+
+// Simulation variables
+thread_local long long simulation_time = 0;
+thread_local EQ event_queue;
+thread_local ChainStore chain_store;
+thread_local unsigned int global_seed;
+thread_local Logger l;
+thread_local ostream* console = &cout;
+thread_local bool selfish_mining;
+thread_local bool eclipse_attack;
+thread_local bool mitigation;
+thread_local int global_send_private_counter = 0;
+thread_local bool write_node_files;
+thread_local long long stats_sample_interval;
+thread_local ProofOfWork* active_proof_of_work = nullptr;
+thread_local EventProfiler* active_profiler = nullptr;
+thread_local int release_strategy;
+thread_local bool branching_strategies;
+thread_local bool shared_ledgers;
+thread_local long long finality_depth;
+
+Simulator::Simulator(const SimulationConfig& config) : config(install(config))
+{
+    released_at_end = false;
+    next_sample_time = stats_sample_interval;
+    next_memory_sample_time = 0;
+    install_proof_of_work();
+    propagation.reset(static_cast<int>(network.honest_node_ids.size()));
+}
+
+Simulator::Simulator(const SimulationConfig& config, Network::unbuilt) : config(install(config)),
+                                                                          network(Network::unbuilt())
+{
+    released_at_end = false;
+    next_sample_time = stats_sample_interval;
+    next_memory_sample_time = 0;
+    install_proof_of_work();
+}
+
+const SimulationConfig& Simulator::install(const SimulationConfig& config)
+{
+    initial_bitcoin = config.initial_bitcoin;
+    initial_number_of_transactions = config.initial_number_of_transactions;
+    propagation_delay_min = config.propagation_delay_min;
+    propagation_delay_max = config.propagation_delay_max;
+    propagation_delay_malicious_min = config.propagation_delay_malicious_min;
+    propagation_delay_malicious_max = config.propagation_delay_malicious_max;
+    transaction_amount_min = config.transaction_amount_min;
+    transaction_amount_max = config.transaction_amount_max;
+    queuing_delay_constant = config.queuing_delay_constant;
+    transaction_size = config.transaction_size;
+    hash_size = config.hash_size;
+    get_message_size = config.get_message_size;
+    mining_reward = config.mining_reward;
+    maximum_retries = config.maximum_retries;
+    stats_threads = config.stats_threads;
+
+    number_of_nodes = config.number_of_nodes;
+    percent_malicious_nodes = config.percent_malicious_nodes;
+    mean_transaction_inter_arrival_time = config.mean_transaction_inter_arrival_time;
+    block_inter_arrival_time = config.block_inter_arrival_time;
+    timer_timeout_time = config.timer_timeout_time;
+    output_dir = config.output_dir;
+
+    selfish_mining = config.selfish_mining;
+    eclipse_attack = config.eclipse_attack;
+    mitigation = config.mitigation;
+    release_strategy = config.release_strategy;
+    branching_strategies = config.branching_strategies;
+    shared_ledgers = config.shared_ledgers;
+    finality_depth = config.finality_depth;
+    write_node_files = config.write_node_files;
+    stats_sample_interval = config.stats_sample_interval;
+
+    // fresh clock, queue, seed and ids so runs on the same thread are independent
+    simulation_time = 0;
+    event_queue = EQ();
+    chain_store.clear();
+    clear_shared_ledgers();
+    propagation.reset(0);
+    global_send_private_counter = 0;
+    global_seed = config.seed;
+    active_proof_of_work = nullptr;
+    active_profiler = nullptr;
+    Transaction::reset_ticket();
+    Block::reset_ticket();
+    l.setOutputDir(output_dir);
+    console = config.console_to_log ? static_cast<ostream*>(&l.log) : &cout;
+
+    return config;
+}
+
+void Simulator::install_proof_of_work()
+{
+    if (config.proof_of_work)
+        miner = make_unique<ProofOfWork>(config.pow_hashes_per_block, config.block_inter_arrival_time,
+                                         config.pow_threads);
+    active_proof_of_work = miner.get();
+}
+
+const SimulationConfig& Simulator::get_config() const
+{
+    return config;
+}
+
+const run_statistics& Simulator::get_run_statistics() const
+{
+    return statistics;
+}
+
+string SimulationConfig::validate() const
+{
+    if (number_of_nodes < 1 ||  percent_malicious_nodes < 0 || percent_malicious_nodes > 100
+        || mean_transaction_inter_arrival_time <= 0 || block_inter_arrival_time <= 0 || timer_timeout_time <= 0
+        || stats_sample_interval < 0 || memory_sample_interval < 0 || finality_depth < 0 || pow_hashes_per_block < 1 || pow_threads < 0 || profile_sample_interval < 1
+        || (release_strategy != RELEASE_SELFISH && release_strategy != RELEASE_LEAD_STUBBORN))
+        return "Invalid argument values";
+
+    // the ringmaster is the first malicious node, so at least one is needed
+    if (static_cast<int>(number_of_nodes * (percent_malicious_nodes / 100.0)) < 1)
+        return "Invalid argument values: at least one malicious node is needed";
+    return "";
+}
+
+void SimulationConfig::print(ostream& os) const
+{
+    os << "----------------------------------------------------------------------" << endl;
+    os << "Simulation Configuration:" << endl;
+    os << "  Number of Nodes: " << number_of_nodes << endl;
+    os << "  Percent Malicious: " << percent_malicious_nodes << "%" << endl;
+    os << "  Mean Transaction Inter-Arrival Time: " << mean_transaction_inter_arrival_time << " ms" << endl;
+    os << "  Block Inter-Arrival Time: " << block_inter_arrival_time << " ms" << endl;
+    os << "  Timeout Time: " << timer_timeout_time << " ms" << endl;
+
+    os << "  Propagation Delay (Min-Max): " << propagation_delay_min << " - " << propagation_delay_max << " ms" <<
+        endl;
+    os << "  Propagation Delay Malicious (Min-Max): " << propagation_delay_malicious_min << " - " << propagation_delay_malicious_max << " ms" << endl;
+    os << "  Queuing Delay Constant: " << queuing_delay_constant << " bits/sec" << endl;
+    os << "  Transaction Size: " << transaction_size << " bits" << endl;
+    os << "  Hash size: " << hash_size << endl;
+    os << "  Get message size: " << get_message_size << endl;
+    os << "  Mining reward: " << mining_reward << " bitcoins" << endl;
+    os << "  Initial Bitcoins with each node: " << initial_bitcoin << endl;
+    os << "  Initial Number of Transactions: " << initial_number_of_transactions << endl;
+    os << "  Transaction Amount (Min-Max): " << transaction_amount_min << " - " << transaction_amount_max <<
+        " bitcoins" << endl;
+    os << "  Eclipse Attack: " << (eclipse_attack ? "Enabled" : "Disabled") << endl;
+    os << "  Selfish Mining: " << (selfish_mining ? "Enabled" : "Disabled") << endl;
+    os << "  Mitigation: " << (mitigation ? "Enabled" : "Disabled") << endl;
+    os << "  Release strategy: " << (release_strategy == RELEASE_LEAD_STUBBORN ? "lead-stubborn" : "selfish (SM1)") << endl;
+    os << "  Seed: " << seed << endl;
+    if (shared_ledgers)
+        os << "  Shared ledgers: honest nodes" << endl;
+    if (finality_depth > 0)
+        os << "  Finality depth: " << finality_depth << " blocks" << endl;
+    if (proof_of_work)
+        os << "  Proof of work: " << pow_hashes_per_block << " hashes per block" << endl;
+    if (!restore_path.empty())
+        os << "  Restored from: " << restore_path << endl;
+    os << "  Output Directory: " << output_dir << endl;
+    os << "  Per-node text files: " << (write_node_files ? "Enabled" : "Disabled") << endl;
+    os << "  Chain stats sample interval: " << stats_sample_interval << " ms" << endl;
+    if (memory_sample_interval > 0)
+        os << "  Memory accounting sample interval: " << memory_sample_interval << " ms" << endl;
+    if (profile)
+        os << "  Event loop profile: queue depth every " << profile_sample_interval << " ms"
+            << (profile_counters ? ", hardware counters" : "") << endl;
+    os << "----------------------------------------------------------------------" << endl;
+}
 
 
 void Simulator::create_genesis()
 {
-    auto genesis = make_shared<Block>(0, nullptr,false,true);
+    auto genesis = make_object<Block>(0, nullptr,false,true);
     // create coinbase transaction for each node with initial bitcoin
     for (int i = 0; i < number_of_nodes; i++)
     {
-        auto temp = make_shared<Transaction>(i, initial_bitcoin, true);
+        auto temp = make_object<Transaction>(i, initial_bitcoin, true);
         genesis->transactions.push_back(temp);
     }
 
-    cout << " Created genesis block" << endl;
+    *console << " Created genesis block" << endl;
+    // initial balance and transaction ids, shared by honest nodes with shared ledgers and copied for the others
+    auto ledger = make_object<Ledger>(genesis->id);
+    ledger->balance.resize(number_of_nodes, 0);
+    for (const auto& txn : genesis->transactions)
+    {
+        ledger->transaction_ids.insert(txn->id);
+        if (txn->coinbase()) ledger->balance[txn->receiver()] += txn->amount();
+        else
+        {
+            if (ledger->balance[txn->sender()] - txn->amount() < 0)
+                throw std::runtime_error("Invalid genesis block");
+
+            ledger->balance[txn->sender()] -= txn->amount();
+            ledger->balance[txn->receiver()] += txn->amount();
+        }
+    }
+    if (shared_ledgers)
+        share_ledger(ledger);
+
     // add genesis block to all nodes
     for (int i = 0; i < number_of_nodes; i++)
     {
-        network.nodes[i].genesis = genesis;
+        // genesis is the first root, with a ledger of its own that follows the root
+        network.nodes[i].root = genesis;
+        network.nodes[i].root_ledger = make_object<Ledger>(genesis->id);
+        network.nodes[i].root_ledger->transaction_ids = ledger->transaction_ids;
+        network.nodes[i].root_ledger->balance = ledger->balance;
         network.nodes[i].block_ids_in_tree.insert({genesis->id, simulation_time});
+        network.nodes[i].chain.longest_chain.push_back(genesis->id);
 
         // update leaves in each node with initial balance, transaction ids and balance of each node
-        auto temp = make_shared<LeafNode>(genesis, 1);
-        for (const auto& txn : genesis->transactions)
+        auto temp = make_object<LeafNode>(genesis, 1);
+        if (network.nodes[i].shares_ledgers())
+            temp->ledger = ledger;
+        else
         {
-            temp->transaction_ids.insert(txn->id);
-            if (txn->coinbase) temp->balance[txn->receiver] += txn->amount;
-            else
-            {
-                if (temp->balance[txn->sender] - txn->amount < 0)
-                    throw std::runtime_error("Invalid genesis block");
-
-                temp->balance[txn->sender] -= txn->amount;
-                temp->balance[txn->receiver] += txn->amount;
-            }
+            temp->ledger = make_object<Ledger>(genesis->id);
+            temp->ledger->transaction_ids = ledger->transaction_ids;
+            temp->ledger->balance = ledger->balance;
         }
         network.nodes[i].leaves.insert(temp);
     }
-    cout << " Added genesis block to all nodes" << endl;
+    network.index_node_roots();
+    *console << " Added genesis block to all nodes" << endl;
 }
 
 // Populate the event queue with initial transactions
@@ -46,6 +272,7 @@ void Simulator::create_initial_transactions()
 {
 
     long long event_time = 0; // variable to keep track of future time
+    RandomStream arrival_rng(global_seed, RNG_NO_NODE, RNG_TRANSACTION_ARRIVAL);
 
     create_transaction_object obj(network.ringmaster_node_id);
     auto e = Event(0,CREATE_TRANSACTION, obj);
@@ -54,18 +281,18 @@ void Simulator::create_initial_transactions()
     for (int i = 0; i < initial_number_of_transactions; i++)
     {
         // randomly choose node who creates transaction
-        int creator_node_id = uniform_distribution(0, number_of_nodes - 1);
+        int creator_node_id = uniform_distribution(arrival_rng, 0, number_of_nodes - 1);
         // create transaction object and put into  event_queue
         create_transaction_object obj(creator_node_id);
-        event_time += exponential_distribution(mean_transaction_inter_arrival_time);
+        event_time += exponential_distribution(arrival_rng, mean_transaction_inter_arrival_time);
         auto e = Event(event_time,CREATE_TRANSACTION, obj);
         event_queue.push(e);
 
         create_transaction_object objr(network.ringmaster_node_id);
-        event_time += exponential_distribution(mean_transaction_inter_arrival_time);
+        event_time += exponential_distribution(arrival_rng, mean_transaction_inter_arrival_time);
         auto er = Event(event_time,CREATE_TRANSACTION, objr);
     }
-    cout << " Initialized event queue with " << initial_number_of_transactions << " transactions" << endl;
+    *console << " Initialized event queue with " << initial_number_of_transactions << " transactions" << endl;
 }
 
 void Simulator::initialize()
@@ -77,225 +304,693 @@ void Simulator::initialize()
     create_initial_transactions();
 }
 
-void Simulator::start()
+void Simulator::dispatch(const Event& e)
+{
+    if (e.type == CREATE_TRANSACTION)
+    {
+        const auto obj = std::get<struct create_transaction_object>(e.object);
+        SIM_PROBE4(event_dispatch, obj.creator_node_id, -1, e.time, e.type); // detail: event type
+        network.nodes[obj.creator_node_id].create_transaction();
+    }
+
+    else if (e.type == RECEIVE_TRANSACTION)
+    {
+        auto obj = std::get<struct receive_transaction_object>(e.object);
+        SIM_PROBE4(event_dispatch, obj.receiver_node_id, -1, e.time, e.type);
+        network.nodes[obj.receiver_node_id].receive_transaction(obj);
+    }
+    else if (e.type == RECEIVE_BLOCK)
+    {
+        const auto obj = std::get<struct receive_block_object>(e.object);
+        SIM_PROBE4(event_dispatch, obj.receiver_node_id, obj.blk->id, e.time, e.type);
+        network.nodes[obj.receiver_node_id].receive_block(obj);
+    }
+
+    else if (e.type == BLOCK_MINED)
+    {
+        const auto obj = std::get<struct block_mined_object>(e.object);
+        SIM_PROBE4(event_dispatch, obj.miner_node_id, obj.blk->id, e.time, e.type);
+        network.nodes[obj.miner_node_id].complete_mining(obj.blk);
+    }
+
+    else if (e.type == RECEIVE_HASH)
+    {
+        const auto obj = std::get<struct receive_hash_object>(e.object);
+        SIM_PROBE4(event_dispatch, obj.receiver_node_id, obj.blk->id, e.time, e.type);
+        network.nodes[obj.receiver_node_id].receive_hash(obj);
+    }
+
+    else if (e.type == GET_BLOCK_REQUEST)
+    {
+        const auto obj = std::get<struct get_block_request_object>(e.object);
+        SIM_PROBE4(event_dispatch, obj.receiver_node_id, obj.blk->id, e.time, e.type);
+        network.nodes[obj.receiver_node_id].send_block(obj);
+
+    }
+
+    else if (e.type == TIMER_EXPIRED)
+    {
+        const auto obj = std::get<struct timer_expired_object>(e.object);
+        SIM_PROBE4(event_dispatch, obj.node_id, obj.blk->id, e.time, e.type);
+        network.nodes[obj.node_id].timer_expired(obj);
+    }
+
+    else if (e.type == RELEASE_PRIVATE)
+    {
+        const auto obj = std::get<struct release_private_object>(e.object);
+        SIM_PROBE4(event_dispatch, obj.node_id, -1, e.time, e.type);
+        network.nodes[obj.node_id].release_private(obj.counter, obj.height);
+    }
+}
+
+bool Simulator::run_until(const long long end_time)
 {
-    bool flag = true;
-    cout << " Simulation started" << endl;
+    // time series of the streaming chain stats
+    if (stats_sample_interval > 0 && !samples.is_open())
+        open_chain_stats_samples(samples);
+    if (config.memory_sample_interval > 0 && !memory_samples.is_open())
+        open_memory_samples();
+    // a restored or branched run profiles from its current time on
+    if (config.profile && !profiler)
+    {
+        profiler = make_unique<EventProfiler>(config.profile_sample_interval, simulation_time,
+                                              config.profile_counters);
+        active_profiler = profiler.get();
+    }
+    if (profiler)
+        profiler->resume();
+
     // Process each type of event in event queue
-    while (!event_queue.empty())
+    while (true)
     {
+        // blocks found by the nonce search up to the next event come first, without events it searches to a hit
+        if (miner)
+            miner->advance(event_queue.empty() ? end_time : min(end_time, event_queue.top().time), event_queue);
+        if (event_queue.empty() || event_queue.top().time > end_time)
+            break;
         // get the event and update the simulation clock
         Event e = event_queue.top();
         event_queue.pop();
-        simulation_time = e.time;
-
-        if (e.type == CREATE_TRANSACTION)
-        {
-            const auto obj = std::get<struct create_transaction_object>(e.object);
-            network.nodes[obj.creator_node_id].create_transaction();
-        }
+        statistics.events_processed++;
 
-        else if (e.type == RECEIVE_TRANSACTION)
+        // sample the state as of every interval boundary passed
+        while (stats_sample_interval > 0 && e.time >= next_sample_time)
         {
-            auto obj = std::get<struct receive_transaction_object>(e.object);
-            network.nodes[obj.receiver_node_id].receive_transaction(obj);
+            write_chain_stats_sample(samples, next_sample_time);
+            next_sample_time += stats_sample_interval;
         }
-        else if (e.type == RECEIVE_BLOCK)
+        if (config.memory_sample_interval > 0 && e.time >= next_memory_sample_time)
         {
-            const auto obj = std::get<struct receive_block_object>(e.object);
-            network.nodes[obj.receiver_node_id].receive_block(obj);
+            const memory_breakdown memory = account_memory(network, event_queue);
+            for (; e.time >= next_memory_sample_time; next_memory_sample_time += config.memory_sample_interval)
+                write_memory_sample(memory_samples, next_memory_sample_time, memory);
         }
+        simulation_time = e.time;
 
-        else if (e.type == BLOCK_MINED)
+        if (profiler)
         {
-            const auto obj = std::get<struct block_mined_object>(e.object);
-            network.nodes[obj.miner_node_id].complete_mining(obj.blk);
+            profiler->before_event(e.time, event_queue.size());
+            perf_counts counts_start, counts_end;
+            profiler->read_counters(counts_start);
+            const auto handler_start = chrono::steady_clock::now();
+            dispatch(e);
+            const auto handler_time = chrono::steady_clock::now() - handler_start;
+            profiler->read_counters(counts_end);
+            profiler->record(e.type, handler_time, counts_start, counts_end);
         }
+        else
+            dispatch(e);
 
-        else if (e.type == RECEIVE_HASH)
+        if (event_queue.empty() && (!miner || miner->idle()) && !released_at_end)
         {
-            const auto obj = std::get<struct receive_hash_object>(e.object);
-            network.nodes[obj.receiver_node_id].receive_hash(obj);
+            released_at_end = true;
+            network.nodes[network.ringmaster_node_id].release_private(global_send_private_counter++);
         }
+    }
+    if (profiler)
+        profiler->pause();
+    return !event_queue.empty() || (miner && !miner->idle());
+}
 
-        else if (e.type == GET_BLOCK_REQUEST)
-        {
-            const auto obj = std::get<struct get_block_request_object>(e.object);
-            network.nodes[obj.receiver_node_id].send_block(obj);
+void Simulator::start()
+{
+    *console << " Simulation started" << endl;
+    const auto simulation_start = chrono::steady_clock::now();
 
-        }
+    run_until(LLONG_MAX);
+    propagation.finish();
+
+    const auto stats_start = chrono::steady_clock::now();
+    *console << " Simulation completed, Writing stats to files" << endl;
+    const memory_breakdown memory = account_memory(network, event_queue);
+    write_memory_report(memory);
+    statistics.accounted_bytes = memory.total();
 
-        else if (e.type == TIMER_EXPIRED)
+    // Write stats file
+    write_node_stats_to_file();
+    write_all_node_details_to_file(network.nodes, "all_node_details.csv");
+    propagation.write_histograms(output_dir + "/Temp_files/propagation_latency.csv");
+    if (profiler)
+        profiler->write_report(output_dir + "/Temp_files/");
+    const auto stats_end = chrono::steady_clock::now();
+    statistics.simulation_seconds = chrono::duration<double>(stats_start - simulation_start).count();
+    statistics.stats_seconds = chrono::duration<double>(stats_end - stats_start).count();
+
+    *console << " Simulation phase took " << statistics.simulation_seconds << " s" << endl;
+    *console << " Stats phase took " << statistics.stats_seconds << " s" << endl;
+    if (miner)
+        miner->print_statistics(*console);
+    print_memory_summary(*console, memory);
+    propagation.print_summary(*console);
+    if (profiler)
+    {
+        profiler->print_summary(*console);
+        *console << " Profile written to " << output_dir << "/Temp_files/profile.json" << endl;
+    }
+    *console << " Stats written in ./files/ directory" << endl;
+    *console << " Logs written in ./files/logs.txt" << endl;
+}
+
+unique_ptr<Simulator> create_simulator(const SimulationConfig& config)
+{
+    if (!config.restore_path.empty())
+        return Simulator::restore_snapshot(config.restore_path, config);
+    auto sim = make_unique<Simulator>(config);
+    sim->initialize();
+    return sim;
+}
+
+// every config value that shapes the network or the events, a restored run must use the same ones
+static vector<long long> snapshot_parameters(const SimulationConfig& config)
+{
+    return {config.number_of_nodes, config.percent_malicious_nodes, config.mean_transaction_inter_arrival_time,
+            config.block_inter_arrival_time, config.timer_timeout_time, config.seed, config.initial_bitcoin,
+            config.initial_number_of_transactions, config.propagation_delay_min, config.propagation_delay_max,
+            config.propagation_delay_malicious_min, config.propagation_delay_malicious_max,
+            config.transaction_amount_min, config.transaction_amount_max, config.queuing_delay_constant,
+            config.transaction_size, config.hash_size, config.get_message_size, config.mining_reward,
+            config.maximum_retries, config.proof_of_work, config.pow_hashes_per_block, config.finality_depth};
+}
+
+void Simulator::branch(const SimulationConfig& variant)
+{
+    SimulationConfig same_seed = variant;
+    same_seed.seed = config.seed;
+    if (snapshot_parameters(same_seed) != snapshot_parameters(config))
+        throw runtime_error("A branch may only change the attack toggles, the seed and the output options");
+
+    config.selfish_mining = selfish_mining = variant.selfish_mining;
+    config.eclipse_attack = eclipse_attack = variant.eclipse_attack;
+    config.mitigation = mitigation = variant.mitigation;
+    config.release_strategy = release_strategy = variant.release_strategy;
+    network.assign_strategies();
+    // the profile of a branch covers its own events, and the counters of the forked child's thread
+    profiler.reset();
+    active_profiler = nullptr;
+    config.write_node_files = write_node_files = variant.write_node_files;
+    config.output_dir = output_dir = variant.output_dir;
+    l.setOutputDir(output_dir);
+    // samples continue in the new output directory
+    if (samples.is_open())
+        samples.close();
+    if (memory_samples.is_open())
+        memory_samples.close();
+
+    // fresh streams keyed by the new seed, independent of the ones used so far
+    if (variant.seed != config.seed)
+    {
+        config.seed = global_seed = variant.seed;
+        for (auto& node : network.nodes)
         {
-            const auto obj = std::get<struct timer_expired_object>(e.object);
-            network.nodes[obj.node_id].timer_expired(obj);
+            node.latency_rng = RandomStream(global_seed, node.id, RNG_LINK_LATENCY);
+            node.mining_rng = RandomStream(global_seed, node.id, RNG_MINING_TIME);
+            node.transaction_rng = RandomStream(global_seed, node.id, RNG_TRANSACTION);
+            node.topology_rng = RandomStream(global_seed, node.id, RNG_TOPOLOGY);
         }
+    }
+}
+
+void Simulator::flush_output()
+{
+    l.log.flush();
+    if (samples.is_open())
+        samples.flush();
+    if (memory_samples.is_open())
+        memory_samples.flush();
+}
+
+void Simulator::prepare_fork()
+{
+    flush_output();
+    if (miner)
+        miner->stop_helpers();
+}
+
+size_t Simulator::save_snapshot(const string& path) const
+{
+    const auto save_start = chrono::steady_clock::now();
+    const vector<Event>& events = event_heap(event_queue);
+
+    SnapshotWriter out;
+    out.put_string(string("P2PSNAP\0", 8));
+    out.put<uint32_t>(SNAPSHOT_VERSION);
+    out.put_vector(snapshot_parameters(config));
 
-        else if (e.type == RELEASE_PRIVATE)
+    out.put<long long>(simulation_time);
+    out.put<long long>(Transaction::get_ticket());
+    out.put<long long>(Block::get_ticket());
+    out.put<int>(global_send_private_counter);
+    out.put<bool>(released_at_end);
+    out.put<long long>(next_sample_time);
+
+    SnapshotObjects objects;
+    objects.collect(network, events);
+    if (miner)
+        for (const auto& [node_id, job] : miner->jobs)
+            objects.collect(job.blk);
+    objects.write(out);
+    write_network(out, network);
+    write_propagation(out, propagation);
+    // blocks being searched for and the progress of the search, only in proof of work mode
+    if (miner)
+    {
+        out.put<long long>(miner->searched_until);
+        out.put<long long>(miner->blocks_found);
+        out.put<double>(miner->exposure);
+        out.put<double>(miner->scaled_time_sum);
+        out.put<double>(miner->scaled_time_square_sum);
+        out.put<uint64_t>(miner->jobs.size());
+        for (const auto& [node_id, job] : miner->jobs)
         {
-            const auto obj = std::get<struct release_private_object>(e.object);
-            network.nodes[obj.node_id].release_private(obj.counter);
+            out.put<int>(node_id);
+            out.put<long long>(job.blk->id);
+            out.put<long long>(job.start_time);
+            out.put<double>(job.hashing_fraction);
+            out.put<long long>(job.searched);
+            out.put<long long>(job.found);
         }
+    }
+    out.put<uint64_t>(events.size());
+    for (const auto& e : events)
+        write_event(out, e);
+
+    if (fs::path dir = fs::path(path).parent_path(); !dir.empty() && !fs::exists(dir))
+        fs::create_directories(dir);
+    ofstream file(path, ios::binary);
+    if (!file)
+    {
+        cerr << "An Error occurred while opening file!" << endl;
+        return 0;
+    }
+    file.write(out.bytes().data(), static_cast<streamsize>(out.bytes().size()));
+    file.close();
 
-        if (event_queue.empty() && flag)
+    *console << " Snapshot at time " << simulation_time << " ms: " << out.bytes().size() << " bytes ("
+        << objects.number_of_blocks() << " blocks, " << objects.number_of_transactions() << " transactions, "
+        << events.size() << " events) written in "
+        << chrono::duration<double>(chrono::steady_clock::now() - save_start).count() << " s" << endl;
+    return out.bytes().size();
+}
+
+unique_ptr<Simulator> Simulator::restore_snapshot(const string& path, const SimulationConfig& config)
+{
+    const auto restore_start = chrono::steady_clock::now();
+    ifstream file(path, ios::binary);
+    if (!file)
+        throw runtime_error("Unable to open snapshot " + path);
+    const string buffer((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+    SnapshotReader in(buffer);
+    if (in.get_string() != string("P2PSNAP\0", 8) || in.get<uint32_t>() != SNAPSHOT_VERSION)
+        throw runtime_error(path + " is not a snapshot of this version");
+    if (in.get_vector<long long>() != snapshot_parameters(config))
+        throw runtime_error("Snapshot " + path + " was taken with different parameters");
+
+    // private constructor, so no make_unique
+    unique_ptr<Simulator> sim(new Simulator(config, Network::unbuilt()));
+    simulation_time = in.get<long long>();
+    const long long transaction_ticket = in.get<long long>();
+    const long long block_ticket = in.get<long long>();
+    global_send_private_counter = in.get<int>();
+    sim->released_at_end = in.get<bool>();
+    sim->next_sample_time = in.get<long long>();
+
+    SnapshotObjects objects;
+    objects.read(in);
+    read_network(in, sim->network, objects);
+    sim->network.assign_strategies();
+    propagation.reset(static_cast<int>(sim->network.honest_node_ids.size()));
+    read_propagation(in, propagation);
+    if (sim->miner)
+    {
+        ProofOfWork& miner = *sim->miner;
+        miner.searched_until = in.get<long long>();
+        miner.blocks_found = in.get<long long>();
+        miner.exposure = in.get<double>();
+        miner.scaled_time_sum = in.get<double>();
+        miner.scaled_time_square_sum = in.get<double>();
+        const uint64_t number_of_jobs = in.get<uint64_t>();
+        for (uint64_t i = 0; i < number_of_jobs; i++)
         {
-            flag = false;
-            network.nodes[network.ringmaster_node_id].release_private(global_send_private_counter++);
+            mining_job& job = miner.jobs[in.get<int>()];
+            job.blk = objects.block(in.get<long long>());
+            job.start_time = in.get<long long>();
+            job.hashing_fraction = in.get<double>();
+            job.searched = in.get<long long>();
+            job.found = in.get<long long>();
+            miner.resume(job);
         }
     }
-    cout << " Simulation completed, Writing stats to files" << endl;
+    vector<Event> events;
+    const uint64_t number_of_events = in.get<uint64_t>();
+    events.reserve(number_of_events);
+    for (uint64_t i = 0; i < number_of_events; i++)
+        events.push_back(read_event(in, objects));
+    set_event_heap(event_queue, std::move(events));
+    if (!in.at_end())
+        throw runtime_error("Snapshot " + path + " has trailing data");
 
-    // Write stats file
-    write_node_stats_to_file();
-    write_all_node_details_to_file(network.nodes, "all_node_details.csv");
-    cout << " Stats written in ./files/ directory" << endl;
-    cout << " Logs written in ./files/logs.txt" << endl;
+    // restoring constructed objects with fresh ids, continue after the saved ones
+    Transaction::set_ticket(transaction_ticket);
+    Block::set_ticket(block_ticket);
+
+    *console << " Restored snapshot at time " << simulation_time << " ms: " << buffer.size() << " bytes in "
+        << chrono::duration<double>(chrono::steady_clock::now() - restore_start).count() << " s" << endl;
+    return sim;
 }
 
-void Simulator::write_node_stats_to_file()
+void Simulator::open_chain_stats_samples(ofstream& file) const
 {
-    // Check if the directory exists, if not create it
-    if (fs::path dir = output_dir + "/Node_Files"; !fs::exists(dir))
+    if (fs::path dir = output_dir + "/Temp_files/"; !fs::exists(dir))
         fs::create_directories(dir);
 
+    file.open(output_dir + "/Temp_files/chain_stats_timeseries.csv");
+    if (!file)
+    {
+        cerr << "An Error occurred while opening file!" << endl;
+        return;
+    }
+    file << "time,node_id,blocks_mined,blocks_mined_in_longest_chain,blocks_in_longest_chain,number_of_forks,"
+            "longest_fork_length,average_fork_length,reorganisations,deepest_reorganisation" << "\n";
+}
 
-    ofstream file;
-    for (int i = 0; i < number_of_nodes; i++)
+void Simulator::open_memory_samples()
+{
+    if (fs::path dir = output_dir + "/Temp_files/"; !fs::exists(dir))
+        fs::create_directories(dir);
+
+    memory_samples.open(output_dir + "/Temp_files/memory_timeseries.csv");
+    if (!memory_samples)
     {
-        string filepath = output_dir + "/Node_Files/Node_" + std::to_string(i) + ".txt";
-        file.open(filepath);
+        cerr << "An Error occurred while opening file!" << endl;
+        return;
+    }
+    write_memory_sample_header(memory_samples);
+    // first boundary after the current time, restored and branched runs continue from there
+    next_memory_sample_time = (simulation_time / config.memory_sample_interval + 1) * config.memory_sample_interval;
+}
+
+void Simulator::write_memory_report(const memory_breakdown& memory) const
+{
+    if (fs::path dir = output_dir + "/Temp_files/"; !fs::exists(dir))
+        fs::create_directories(dir);
 
-        if (!file)
+    ofstream file(output_dir + "/Temp_files/memory_breakdown.csv");
+    if (!file)
+    {
+        cerr << "An Error occurred while opening file!" << endl;
+        return;
+    }
+    write_memory_breakdown(file, memory);
+}
+
+void Simulator::write_chain_stats_sample(ofstream& file, const long long time) const
+{
+    for (const auto& node : network.nodes)
+    {
+        const node_summary summary = node.summarize_chain();
+        file << time << "," << node.id << "," << summary.blocks_mined << "," << summary.blocks_mined_in_longest_chain
+            << "," << summary.blocks_in_longest_chain << "," << summary.number_of_forks << ","
+            << summary.longest_fork_length << "," << summary.average_fork_length << "," << summary.reorganisations
+            << "," << summary.deepest_reorganisation << "\n";
+    }
+}
+
+vector<block_index_entry> Simulator::build_block_index() const
+{
+    // every block a node validated is in the archive of the store, the genesis leaf is the only one that may be
+    // unsealed and so not archived yet
+    for (const auto& node : network.nodes)
+        for (const auto& leaf : node.leaves)
+            chain_store.seal(*leaf->block);
+
+    vector<block_index_entry> archive;
+    for (size_t i = 0; i < chain_store.archive_block_id.size(); i++)
+    {
+        const long long block_id = chain_store.archive_block_id[i];
+        if (block_id >= static_cast<long long>(archive.size()))
+            archive.resize(block_id + 1);
+        block_index_entry& entry = archive[block_id];
+        entry.parent_block_id = chain_store.archive_parent_id[i];
+        entry.num_transactions = chain_store.archive_transaction_count[i];
+        entry.creation_time = chain_store.archive_creation_time[i];
+        entry.miner = chain_store.archive_miner[i];
+    }
+
+    // only the chains of the nodes are listed, not the dead forks they pruned
+    vector<block_index_entry> block_index(archive.size());
+    for (const auto& node : network.nodes)
+    {
+        for (const auto& leaf : node.leaves)
         {
-            cerr << "An Error occurred while opening file!" << endl;
-            return;
+            // rest of the chain already indexed through another leaf
+            for (long long block_id = leaf->block->id; block_id != -1 && !block_index[block_id].present;
+                 block_id = archive[block_id].parent_block_id)
+            {
+                block_index[block_id] = archive[block_id];
+                block_index[block_id].present = true;
+            }
         }
+    }
+    return block_index;
+}
 
-        // if (network.nodes[i].private_leaf != nullptr)
-        //     network.nodes[i].leaves.insert(network.nodes[i].private_leaf);
+void Simulator::collect_node_blocks(const Node& node, const vector<block_index_entry>& block_index,
+                                    vector<block_stats>& blocks) const
+{
+    blocks.clear();
+    vector<char> block_visited(block_index.size(), 0); // to keep track of already inserted blocks
+
+    long long longest = (*node.leaves.begin())->block->id;
 
-        file << "Node ID: " << network.nodes[i].id << endl;
-        file << "Fast node: " << network.nodes[i].fast << endl;
-        file << "Peers:" << endl;
-        for (auto& peer : network.nodes[i].peers)
+    // longest chain comes first in the leaves, then the forks down to where they join an already listed block
+    vector<long long> tips;
+    for (const auto& leaf : node.leaves)
+        tips.push_back(leaf->block->id);
+    for (const long long tip : tips)
+    {
+        const bool longest_flag = tip == longest;
+
+        long long temp_block = tip;
+        while (temp_block != -1)
         {
-            file << "\t Node id: " << peer.peer << " Propagation delay: " << peer.propagation_delay << " ms"
-                << " Link speed: " << peer.link_speed << endl;
+            // rest of the chain already listed through another leaf
+            if (block_visited[temp_block])
+                break;
+
+            const block_index_entry& entry = block_index[temp_block];
+
+            block_stats b;
+            b.block_id = temp_block;
+            b.parent_block_id = entry.parent_block_id;
+            b.first_seen_time = node.first_seen_time(temp_block);
+            b.num_transactions = entry.num_transactions;
+            block_visited[temp_block] = 1;
+
+            b.part_of_longest = longest_flag;
+            b.generated_by_node = entry.miner == node.id;
+
+            blocks.push_back(b);
+            temp_block = entry.parent_block_id;
         }
-        file << "Transactions received: " << network.nodes[i].transactions_received << endl;
-        file << "Blocks received: " << network.nodes[i].blocks_received << endl;
+    }
+    sort(blocks.begin(), blocks.end());
+}
 
-        long long blocks_created = 0;
-        long long blocks_in_longest_chain = 0;
-        long long created_blocks_in_longest_chain = 0;
-        set<block_stats> blocks; // block statistics to be sorted by first seen time
-        set<long long> block_ids; // set to keep track of already inserted blocks
+string Simulator::render_node_stats(const Node& node, const node_summary& summary, const vector<block_stats>& blocks) const
+{
+    ostringstream file;
 
+    file << "Node ID: " << node.id << endl;
+    file << "Fast node: " << node.fast() << endl;
+    file << "Peers:" << endl;
+    for (auto& peer : node.peers)
+    {
+        file << "\t Node id: " << peer.peer << " Propagation delay: " << peer.propagation_delay << " ms"
+            << " Link speed: " << peer.link_speed << endl;
+    }
+    file << "Transactions received: " << node.transactions_received << endl;
+    file << "Blocks received: " << node.blocks_received << endl;
 
-        long long longest = (*network.nodes[i].leaves.begin())->block->id;
+    file << "Blocks mined: " << summary.blocks_mined << endl;
+    file << "Blocks mined in longest chain: " << summary.blocks_mined_in_longest_chain << endl;
+    file << "Number of blocks in longest chain: " << summary.blocks_in_longest_chain << endl;
+    file << "Fraction of blocks mined in longest chain: " << summary.fraction_mined_in_longest_chain() << endl;
+    file << "Fraction of mined blocks not in longest chain: " << summary.fraction_mined_not_in_longest_chain() << endl;
 
-        // variables for counting fork statistics
-        vector<long long> fork_lengths;
-        long long temp_fork_length = 0;
-        set< long long> block_ids_in_longest;
+    file << "Number of forks: " << summary.number_of_forks << endl;
+    file << "Longest fork length:" << summary.longest_fork_length << endl;
+    file << "Shortest fork length:" << summary.shortest_fork_length << endl;
+    file << "Average fork length: " << summary.average_fork_length << endl;
+    file << "Reorganisations: " << summary.reorganisations << endl;
+    file << "Deepest reorganisation: " << summary.deepest_reorganisation << endl;
+    file << "Blockchain: " << endl;
+    file << "Block_id, parent_block_id, first_seen_time, number_of_transactions, part_of_longest, mined by node" <<
+        endl;
+    for (const auto& x : blocks)
+    {
+        file << x.block_id << ", " << x.parent_block_id << ", " << x.first_seen_time << ", " << x.num_transactions
+            << ", " << x.part_of_longest
+            << ", " << x.generated_by_node << endl;
+    }
+    if (!node.chain.pruned_fork_tips.empty())
+    {
+        file << "Pruned forks: " << endl;
+        file << "Tip_id, tip_height, length" << endl;
+        for (const auto& fork : node.chain.pruned_fork_tips)
+            file << fork.tip_id << ", " << fork.tip_height << ", " << fork.length << endl;
+    }
+    return file.str();
+}
 
-        // traverse other chains and get block stats
-        for (const auto& leaf : network.nodes[i].leaves)
-        {
-            bool longest_flag = false;
-            if (leaf->block->id == longest)
-                longest_flag = true;
+void Simulator::write_node_stats_to_file()
+{
+    // Check if the directory exists, if not create it
+    if (fs::path dir = output_dir + "/Node_Files"; write_node_files && !fs::exists(dir))
+        fs::create_directories(dir);
+
+    // index built once so workers never touch the reference counts of the blocks, they are not atomic
+    const vector<block_index_entry> block_index = build_block_index();
+
+    // deduplicated global block table, row of each block in it
+    vector<results_block_record> block_table;
+    vector<long long> block_row(block_index.size(), -1);
+    for (long long id = 0; id < static_cast<long long>(block_index.size()); id++)
+    {
+        if (!block_index[id].present) continue;
+        block_row[id] = static_cast<long long>(block_table.size());
+        block_table.push_back({id, block_index[id].parent_block_id, block_index[id].creation_time,
+                               block_index[id].num_transactions, block_index[id].miner, 0});
+    }
+
+    ResultsFileWriter results;
+    if (!results.open(output_dir + "/results.bin", number_of_nodes))
+    {
+        cerr << "An Error occurred while opening file!" << endl;
+        return;
+    }
+    results.write_block_table(block_table);
+
+    // summaries come from the chain stats maintained during the run
+    vector<node_summary> summaries(number_of_nodes);
+    for (int i = 0; i < number_of_nodes; i++)
+        summaries[i] = network.nodes[i].summarize_chain();
+
+    ThreadPool pool(stats_threads);
+
+    // nodes are processed in batches so only a bounded number of membership sections is held in memory
+    const int batch_size = static_cast<int>(4 * pool.size());
+    for (int batch_start = 0; batch_start < number_of_nodes; batch_start += batch_size)
+    {
+        const int batch_end = min(number_of_nodes, batch_start + batch_size);
+        vector<string> sections(batch_end - batch_start);
 
-            shared_ptr<Block> temp_block = leaf->block;
-            while (temp_block)
+        for (int i = batch_start; i < batch_end; i++)
+        {
+            // workers have their own thread-local globals, so everything they need is captured
+            pool.enqueue([this, i, batch_start, &block_index, &block_row, &block_table, &summaries, &sections,
+                          node_files = write_node_files, dir = output_dir]
             {
-                // if already reached block in the longest return
-                if (block_ids_in_longest.count(temp_block->id) != 0)
-                {
-                    fork_lengths.push_back(temp_fork_length);
-                    temp_fork_length = 0;
-                    break;
-                }
+                const Node& node = network.nodes[i];
+                vector<block_stats> blocks;
+                collect_node_blocks(node, block_index, blocks);
 
-                // if block visited already just increment fork length
-                if (block_ids.count(temp_block->id) != 0)
-                {
-                    temp_fork_length++;
-                    temp_block = temp_block->parent_block;
-                    continue;
-                }
+                ResultsMembership membership(block_table.size());
+                for (const auto& b : blocks)
+                    membership.add(block_row[b.block_id], b.first_seen_time, b.part_of_longest);
+                sections[i - batch_start] = membership.bytes();
 
-                block_stats b;
-                b.block_id = temp_block->id;
-                if (temp_block->parent_block)
-                    b.parent_block_id = temp_block->parent_block->id;
-                else
-                    b.parent_block_id = -1;
-                b.first_seen_time = network.nodes[i].block_ids_in_tree[temp_block->id];
-                b.num_transactions = static_cast<long long>(temp_block->transactions.size());
-                block_ids.insert(b.block_id);
-
-                if (longest_flag)
-                {
-                    b.part_of_longest = true;
-                    blocks_in_longest_chain++;
-                    block_ids_in_longest.insert(temp_block->id);
-                }
-                else
-                {
-                    temp_fork_length++;
-                    b.part_of_longest = false;
-                }
+                if (!node_files)
+                    return;
 
-                if (temp_block->transactions[0]->receiver == i && temp_block != network.nodes[i].genesis)
+                // single sequential write of the whole file
+                const string buffer = render_node_stats(node, summaries[i], blocks);
+                ofstream file(dir + "/Node_Files/Node_" + std::to_string(i) + ".txt", ios::binary);
+                if (!file)
                 {
-                    b.generated_by_node = true;
-                    blocks_created++;
-                    if (longest_flag) created_blocks_in_longest_chain++;
+                    cerr << "An Error occurred while opening file!" << endl;
+                    return;
                 }
-
-                blocks.insert(b);
-                temp_block = temp_block->parent_block;
-            }
+                file.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+            });
         }
+        pool.wait_idle();
 
-        file << "Blocks mined: " << blocks_created << endl;
-        file << "Blocks mined in longest chain: " << created_blocks_in_longest_chain << endl;
-        file << "Number of blocks in longest chain: " << blocks_in_longest_chain << endl;
-        file << "Fraction of blocks mined in longest chain: " <<
-            static_cast<double>(created_blocks_in_longest_chain) / static_cast<double>(blocks_in_longest_chain) << endl;
-        if ( blocks_created !=0 )
-            file << "Fraction of mined blocks not in longest chain: " << static_cast<double>(blocks_created - created_blocks_in_longest_chain)/static_cast<double> (blocks_created)
-        << endl;
-        else
-            file << "Fraction of mined blocks not in longest chain: " << 0 << endl;
-
-        file << "Number of forks: " << fork_lengths.size() << endl;
+        for (const auto& section : sections)
+            results.append_membership(section);
+    }
 
-        unsigned long long average_fork_length = 0;
-        long long shortest_fork_length = 0;
-        long long longest_fork_length = 0;
+    // per-node summary columns
+    deque<results_column> columns;
+    const auto add_column = [&columns](const string& name, char type) -> results_column&
+    {
+        return columns.emplace_back(name, type, number_of_nodes);
+    };
+    auto& node_id = add_column("node_id", 'i');
+    auto& fast = add_column("fast", 'i');
+    auto& malicious = add_column("malicious", 'i');
+    auto& ringmaster = add_column("ringmaster", 'i');
+    auto& hashing_power = add_column("hashing_power", 'i');
+    auto& number_of_peers = add_column("number_of_peers", 'i');
+    auto& transactions_received = add_column("transactions_received", 'i');
+    auto& blocks_received = add_column("blocks_received", 'i');
+    auto& blocks_mined = add_column("blocks_mined", 'i');
+    auto& blocks_mined_in_longest_chain = add_column("blocks_mined_in_longest_chain", 'i');
+    auto& blocks_in_longest_chain = add_column("blocks_in_longest_chain", 'i');
+    auto& fraction_mined_in_longest = add_column("fraction_mined_in_longest", 'f');
+    auto& fraction_mined_not_in_longest = add_column("fraction_mined_not_in_longest", 'f');
+    auto& number_of_forks = add_column("number_of_forks", 'i');
+    auto& longest_fork_length = add_column("longest_fork_length", 'i');
+    auto& shortest_fork_length = add_column("shortest_fork_length", 'i');
+    auto& average_fork_length = add_column("average_fork_length", 'i');
+    auto& reorganisations = add_column("reorganisations", 'i');
+    auto& deepest_reorganisation = add_column("deepest_reorganisation", 'i');
 
-        if (!fork_lengths.empty())
-        {
-            average_fork_length  = accumulate(fork_lengths.begin(), fork_lengths.end(), 0LL) / fork_lengths.size();
-            longest_fork_length  = *max_element(fork_lengths.begin(), fork_lengths.end());
-            shortest_fork_length = *min_element(fork_lengths.begin(), fork_lengths.end());
-        }
-        file << "Longest fork length:" << longest_fork_length << endl;
-        file << "Shortest fork length:" << shortest_fork_length << endl;
-        file << "Average fork length: " << average_fork_length << endl;
-        file << "Blockchain: " << endl;
-        file << "Block_id, parent_block_id, first_seen_time, number_of_transactions, part_of_longest, mined by node" <<
-            endl;
-        for (auto x : blocks)
-        {
-            file << x.block_id << ", " << x.parent_block_id << ", " << x.first_seen_time << ", " << x.num_transactions
-                << ", " << x.part_of_longest
-                << ", " << x.generated_by_node << endl;
-        }
-        file.close();
+    for (int i = 0; i < number_of_nodes; i++)
+    {
+        const Node& node = network.nodes[i];
+        const node_summary& summary = summaries[i];
+        node_id.int_values[i] = node.id;
+        fast.int_values[i] = node.fast();
+        malicious.int_values[i] = node.malicious();
+        ringmaster.int_values[i] = node.ringmaster();
+        hashing_power.int_values[i] = node.hashing_power();
+        number_of_peers.int_values[i] = static_cast<int64_t>(node.peers.size());
+        transactions_received.int_values[i] = node.transactions_received;
+        blocks_received.int_values[i] = node.blocks_received;
+        blocks_mined.int_values[i] = summary.blocks_mined;
+        blocks_mined_in_longest_chain.int_values[i] = summary.blocks_mined_in_longest_chain;
+        blocks_in_longest_chain.int_values[i] = summary.blocks_in_longest_chain;
+        fraction_mined_in_longest.real_values[i] = summary.fraction_mined_in_longest_chain();
+        fraction_mined_not_in_longest.real_values[i] = summary.fraction_mined_not_in_longest_chain();
+        number_of_forks.int_values[i] = summary.number_of_forks;
+        longest_fork_length.int_values[i] = summary.longest_fork_length;
+        shortest_fork_length.int_values[i] = summary.shortest_fork_length;
+        average_fork_length.int_values[i] = static_cast<int64_t>(summary.average_fork_length);
+        reorganisations.int_values[i] = summary.reorganisations;
+        deepest_reorganisation.int_values[i] = summary.deepest_reorganisation;
     }
+    results.finish(columns);
 }
 
 void Simulator::write_all_node_details_to_file(const vector<Node>& nodes, const std::string &fname)
@@ -319,11 +1014,11 @@ void Simulator::write_all_node_details_to_file(const vector<Node>& nodes, const
 
     for (const auto& node : nodes) {
         file << node.id << ","
-             << node.malicious << ","   // 1 if MaliciousNode, 0 otherwise
-             << node.ringmaster << ","  // 1 if RingMasterNode, 0 otherwise
-             << node.fast << ","
-             << node.hashing_power << ","
-             << static_cast<double>(node.hashing_power) / static_cast<double>(number_of_nodes) << ","
+             << node.malicious() << ","   // 1 if MaliciousNode, 0 otherwise
+             << node.ringmaster() << ","  // 1 if RingMasterNode, 0 otherwise
+             << node.fast() << ","
+             << node.hashing_power() << ","
+             << static_cast<double>(node.hashing_power()) / static_cast<double>(number_of_nodes) << ","
              << node.peers.size() << ","
              << node.malicious_peers.size() << "," << endl;
     }
@@ -338,6 +1033,15 @@ bool block_stats::operator<(const block_stats& other) const
 }
 
 
+block_index_entry::block_index_entry()
+{
+    parent_block_id = -1;
+    num_transactions = 0;
+    creation_time = 0;
+    miner = -1;
+    present = false;
+}
+
 block_stats::block_stats()
 {
     block_id = -1;
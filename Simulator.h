@@ -6,33 +6,91 @@
 #include <fstream>
 #include "utility_functions.h"
 #include <filesystem>
+#include "ProofOfWork.h"
+#include "Profiler.h"
+#include "MemoryAccounting.h"
 
 using namespace std;
 
 namespace fs = filesystem;
 
-extern int initial_bitcoin;
-extern int initial_number_of_transactions;
-extern int mean_transaction_inter_arrival_time;
+extern thread_local int initial_bitcoin;
+extern thread_local int initial_number_of_transactions;
+extern thread_local int mean_transaction_inter_arrival_time;
+extern thread_local int stats_threads;
+extern thread_local bool write_node_files;
+extern thread_local long long stats_sample_interval;
 
-class Simulator
+// All constants and parameters of one simulation run.
+// A Simulator installs its config into the thread-local globals read by the node handlers,
+// so any number of simulations can run concurrently, one per thread.
+struct SimulationConfig
 {
-    // Initializes each nodes blockchain with genesis block containing starting balances of all nodes
-    void create_genesis();
+    // experiment constants
+    int initial_bitcoin = 1000;
+    int initial_number_of_transactions = 5000;
+    int propagation_delay_min = 10;
+    int propagation_delay_max = 500;
+    int propagation_delay_malicious_min = 1;
+    int propagation_delay_malicious_max = 10;
+    int transaction_amount_min = 5;
+    int transaction_amount_max = 20;
+    int queuing_delay_constant = 96;  // 96000 per second
+    int transaction_size = 1024 * 8;
+    int hash_size = 64*8;
+    int get_message_size = 64*8;
+    int mining_reward = 50;
+    int maximum_retries = 100;
+    int stats_threads = 0; // worker threads for writing stats, 0 uses all hardware threads
 
-    // Populates event queue with CREATE_TRANSACTION events
-    void create_initial_transactions();
+    // experiment parameters
+    int number_of_nodes = 0;
+    int percent_malicious_nodes = 0;
+    int mean_transaction_inter_arrival_time = 0;
+    int block_inter_arrival_time = 0; // milliseconds
+    int timer_timeout_time = 0;
+    string output_dir = "Output";
+    unsigned int seed = 911;
 
-public:
-    Network& network = Network::getInstance();
-    // Assign initial balance, create genesis block, create initial transactions
-    void initialize();
-    // Start processing event queue
-    void start();
-    // write stats of each node to file
-    void write_node_stats_to_file();
-    // creates a csv files to store all nodes details
-    void write_all_node_details_to_file(const vector<Node>& nodes, const string &fname);
+    // attack and output toggles
+    bool selfish_mining = true;
+    bool eclipse_attack = false;
+    bool mitigation = false;
+    int release_strategy = 0; // RELEASE_SELFISH or RELEASE_LEAD_STUBBORN (Strategy.h)
+    bool branching_strategies = false; // evaluate every strategy check per event instead of per-node policies
+    bool shared_ledgers = false; // honest nodes share one ledger per validated block instead of one per leaf
+    long long finality_depth = 0; // blocks this far below the tip are final and their forks pruned, 0 keeps everything
+    bool write_node_files = false;
+    bool console_to_log = false; // progress messages and chain traces go to the run's log instead of stdout
+    long long stats_sample_interval = 0; // milliseconds between chain stats samples, 0 disables sampling
+    string restore_path; // if set the run continues from this snapshot instead of a new network
+
+    // proof of work mode, mining times come from a real nonce search instead of an exponential draw
+    bool proof_of_work = false;
+    long long pow_hashes_per_block = 1 << 14; // expected hashes per block, sets the difficulty target
+    int pow_threads = 0; // nonce search workers, 0 uses all hardware threads
+
+    // event loop profiler, times every handler and writes a report next to all_node_details.csv
+    bool profile = false;
+    long long profile_sample_interval = 1000; // milliseconds of simulation time between queue depth samples
+    bool profile_counters = false; // also read hardware counters with perf_event_open, needs profile
+    long long memory_sample_interval = 0; // milliseconds between memory accounting samples, 0 disables sampling
+
+    // empty if all parameters are in range, otherwise the reason
+    string validate() const;
+    void print(ostream& os) const;
+};
+
+// read-only summary of a block shared by all stats workers, indexed by block id
+struct block_index_entry
+{
+    long long parent_block_id;
+    long long num_transactions;
+    long long creation_time;
+    int miner; // receiver of the coinbase transaction, -1 for genesis
+    bool present;
+
+    block_index_entry();
 };
 
 struct block_stats
@@ -48,6 +106,98 @@ struct block_stats
     bool operator <(const block_stats & other) const;
 };
 
+// progress and phase times of a run, filled in by run_until and start
+struct run_statistics
+{
+    long long events_processed = 0;
+    double simulation_seconds = 0;
+    double stats_seconds = 0;
+    uint64_t accounted_bytes = 0; // heap bytes of the simulation state at the end of the run (MemoryAccounting.h)
+};
+
+class Simulator
+{
+    SimulationConfig config; // installed before the network is built
+    bool released_at_end; // the ringmaster released its private chain once the event queue drained
+    long long next_sample_time; // simulation time of the next chain stats sample
+    ofstream samples;
+    long long next_memory_sample_time; // simulation time of the next memory accounting sample
+    ofstream memory_samples;
+    unique_ptr<ProofOfWork> miner; // only in proof of work mode
+    unique_ptr<EventProfiler> profiler; // only when profiling, created by the first run_until
+    run_statistics statistics;
+
+    // installs config with an empty network, for restoring a snapshot
+    Simulator(const SimulationConfig& config, Network::unbuilt);
+
+    // copies the config into the thread-local globals and resets clock, event queue, RNG and id tickets
+    static const SimulationConfig& install(const SimulationConfig& config);
+    // creates the nonce search pool in proof of work mode and installs it for the node handlers
+    void install_proof_of_work();
+    // Initializes each nodes blockchain with genesis block containing starting balances of all nodes
+    void create_genesis();
+
+    // Populates event queue with CREATE_TRANSACTION events
+    void create_initial_transactions();
+
+    // runs the handler of a single event
+    void dispatch(const Event& e);
+
+    // csv time series of the streaming chain stats of every node
+    void open_chain_stats_samples(ofstream& file) const;
+    void write_chain_stats_sample(ofstream& file, long long time) const;
+
+    // csv time series of the memory accounting, written every memory_sample_interval
+    void open_memory_samples();
+    // final memory breakdown by subsystem and node class with the peak RSS, next to the stats
+    void write_memory_report(const memory_breakdown& memory) const;
+
+    // collects every block reachable from the leaves of any node
+    vector<block_index_entry> build_block_index() const;
+
+    // traverses the tree of a single node to list its blocks sorted by first seen time,
+    // safe to call concurrently
+    void collect_node_blocks(const Node& node, const vector<block_index_entry>& block_index,
+                             vector<block_stats>& blocks) const;
+
+    // renders the text stats file of a single node
+    string render_node_stats(const Node& node, const node_summary& summary, const vector<block_stats>& blocks) const;
+
+public:
+    Network network;
+
+    explicit Simulator(const SimulationConfig& config);
+    Simulator(const Simulator&) = delete;
+    Simulator& operator=(const Simulator&) = delete;
+
+    // Assign initial balance, create genesis block, create initial transactions
+    void initialize();
+    // Start processing event queue, then write the stats
+    void start();
+    // processes all events up to and including end_time, returns false once the event queue is empty
+    bool run_until(long long end_time);
+    // continues this run with the attack toggles, release strategy, seed and output options of variant,
+    // used by forked branches
+    void branch(const SimulationConfig& variant);
+    // writes buffered log and samples so a forked child does not write them again
+    void flush_output();
+    // flushes output and joins helper threads, which a forked child would not have
+    void prepare_fork();
+    // writes the complete simulation state to a binary snapshot and returns its size in bytes
+    size_t save_snapshot(const string& path) const;
+    // continues a simulation saved by save_snapshot, config must have the parameters of the saved run,
+    // only the attack toggles and output options may differ
+    static unique_ptr<Simulator> restore_snapshot(const string& path, const SimulationConfig& config);
+    // write stats of all nodes to the consolidated results file and optionally one text file per node,
+    // one node per task on a thread pool
+    void write_node_stats_to_file();
+    // creates a csv files to store all nodes details
+    void write_all_node_details_to_file(const vector<Node>& nodes, const string &fname);
+    const SimulationConfig& get_config() const;
+    const run_statistics& get_run_statistics() const;
+};
 
+// restores config.restore_path if set, otherwise builds and initializes a new simulation
+unique_ptr<Simulator> create_simulator(const SimulationConfig& config);
 
 #endif //SIMULATOR_H
@@ -0,0 +1,710 @@
+#include "Snapshot.h"
+
+void SnapshotWriter::put_string(const string& value)
+{
+    put<uint64_t>(value.size());
+    buffer.append(value);
+}
+
+void SnapshotWriter::put_varint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+const string& SnapshotWriter::bytes() const
+{
+    return buffer;
+}
+
+SnapshotReader::SnapshotReader(const string& buffer) : buffer(buffer)
+{
+    position = 0;
+}
+
+string SnapshotReader::get_string()
+{
+    const uint64_t size = get<uint64_t>();
+    if (position + size > buffer.size())
+        throw runtime_error("Snapshot is truncated");
+    string value = buffer.substr(position, size);
+    position += size;
+    return value;
+}
+
+uint64_t SnapshotReader::get_varint()
+{
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        const auto byte = static_cast<uint8_t>(get<char>());
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+    throw runtime_error("Snapshot contains an invalid varint");
+}
+
+bool SnapshotReader::at_end() const
+{
+    return position == buffer.size();
+}
+
+void SnapshotObjects::collect(const object_ptr<Block>& blk)
+{
+    // ancestors already present were collected together with their own ancestors
+    for (auto temp = blk; temp != nullptr && blocks.count(temp->id) == 0; temp = temp->parent_block)
+    {
+        blocks.emplace(temp->id, temp);
+        for (const auto& txn : temp->transactions)
+            collect(txn);
+    }
+}
+
+void SnapshotObjects::collect(const object_ptr<Transaction>& txn)
+{
+    transactions.emplace(txn->id, txn);
+}
+
+void SnapshotObjects::collect(const Network& network, const vector<Event>& events)
+{
+    for (const auto& node : network.nodes)
+    {
+        collect(node.root);
+        for (const auto& leaf : node.leaves)
+            collect(leaf->block);
+        if (node.private_leaf != nullptr)
+            collect(node.private_leaf->block);
+        for (const auto& blk : node.local_storage)
+            collect(blk);
+        for (const auto& [id, timer] : node.timers)
+            collect(timer.blk);
+
+        queue<object_ptr<Transaction>> mempool = node.mempool;
+        for (; !mempool.empty(); mempool.pop())
+            collect(mempool.front());
+    }
+
+    for (const auto& e : events)
+    {
+        visit([this](const auto& obj)
+        {
+            using T = decay_t<decltype(obj)>;
+            if constexpr (is_same_v<T, receive_transaction_object>)
+                collect(obj.txn);
+            else if constexpr (!is_same_v<T, create_transaction_object> && !is_same_v<T, release_private_object>)
+                collect(obj.blk);
+        }, e.object);
+    }
+}
+
+void SnapshotObjects::write(SnapshotWriter& out) const
+{
+    out.put<uint64_t>(transactions.size());
+    for (const auto& [id, txn] : transactions)
+    {
+        out.put<long long>(txn->id);
+        out.put<int>(txn->receiver());
+        out.put<long long>(txn->amount());
+        out.put<bool>(txn->coinbase());
+        out.put<int>(txn->sender());
+    }
+
+    // ascending ids, so parents precede their children
+    out.put<uint64_t>(blocks.size());
+    for (const auto& [id, blk] : blocks)
+    {
+        out.put<long long>(blk->id);
+        out.put<long long>(blk->parent_block ? blk->parent_block->id : -1);
+        out.put<long long>(blk->creation_time());
+        out.put<long long>(blk->nonce);
+        out.put<long long>(blk->height);
+        // a root cut from its parent keeps the hash it had
+        if (blk->parent_block == nullptr && blk->height > 1)
+            for (const uint8_t byte : blk->hash())
+                out.put<uint8_t>(byte);
+        out.put<bool>(blk->is_private());
+        out.put<bool>(blk->is_honest());
+        out.put<bool>(chain_store.block_flags[blk->store_index] & BLOCK_ARCHIVED);
+        out.put<uint64_t>(blk->transactions.size());
+        for (const auto& txn : blk->transactions)
+            out.put<long long>(txn->id);
+    }
+}
+
+void SnapshotObjects::read(SnapshotReader& in)
+{
+    transactions.clear();
+    blocks.clear();
+
+    const uint64_t number_of_transactions = in.get<uint64_t>();
+    for (uint64_t i = 0; i < number_of_transactions; i++)
+    {
+        const long long id = in.get<long long>();
+        const int receiver = in.get<int>();
+        const long long amount = in.get<long long>();
+        const bool coinbase = in.get<bool>();
+        const int sender = in.get<int>();
+
+        // constructed with a placeholder id, the tickets are restored afterwards
+        auto txn = make_object<Transaction>(receiver, 0, coinbase, sender);
+        txn->id = id;
+        chain_store.transaction_id[txn->store_index] = id;
+        chain_store.transaction_amount[txn->store_index] = amount;
+        transactions.emplace_hint(transactions.end(), id, txn);
+    }
+
+    const uint64_t number_of_blocks = in.get<uint64_t>();
+    for (uint64_t i = 0; i < number_of_blocks; i++)
+    {
+        const long long id = in.get<long long>();
+        const long long parent_id = in.get<long long>();
+        const long long creation_time = in.get<long long>();
+        const long long nonce = in.get<long long>();
+        const long long height = in.get<long long>();
+        sha256_digest root_hash{};
+        if (parent_id == -1 && height > 1)
+            for (uint8_t& byte : root_hash)
+                byte = in.get<uint8_t>();
+        const bool is_private = in.get<bool>();
+        const bool is_honest = in.get<bool>();
+        const bool archived = in.get<bool>();
+
+        auto blk = make_object<Block>(creation_time, block(parent_id), is_private, is_honest);
+        blk->id = id;
+        chain_store.block_id[blk->store_index] = id;
+        blk->height = height;
+        blk->nonce = nonce;
+        if (archived)
+            chain_store.block_flags[blk->store_index] |= BLOCK_ARCHIVED;
+        if (parent_id == -1 && height > 1)
+            blk->restore_hash(root_hash);
+        const uint64_t number_of_block_transactions = in.get<uint64_t>();
+        blk->transactions.reserve(number_of_block_transactions);
+        for (uint64_t j = 0; j < number_of_block_transactions; j++)
+            blk->transactions.push_back(transaction(in.get<long long>()));
+        blocks.emplace_hint(blocks.end(), id, blk);
+    }
+}
+
+object_ptr<Block> SnapshotObjects::block(const long long id) const
+{
+    if (id == -1)
+        return nullptr;
+    const auto it = blocks.find(id);
+    if (it == blocks.end())
+        throw runtime_error("Snapshot references unknown block " + to_string(id));
+    return it->second;
+}
+
+object_ptr<Transaction> SnapshotObjects::transaction(const long long id) const
+{
+    const auto it = transactions.find(id);
+    if (it == transactions.end())
+        throw runtime_error("Snapshot references unknown transaction " + to_string(id));
+    return it->second;
+}
+
+size_t SnapshotObjects::number_of_blocks() const
+{
+    return blocks.size();
+}
+
+size_t SnapshotObjects::number_of_transactions() const
+{
+    return transactions.size();
+}
+
+void write_random_stream(SnapshotWriter& out, const RandomStream& stream)
+{
+    const random_stream_state state = stream.state();
+    out.put<uint32_t>(state.seed);
+    out.put<uint32_t>(state.node);
+    out.put<uint32_t>(state.purpose);
+    out.put<int32_t>(state.uniform_position);
+    out.put<int32_t>(state.exponential_position);
+    out.put<uint64_t>(state.uniform_block);
+    out.put<uint64_t>(state.exponential_block);
+}
+
+RandomStream read_random_stream(SnapshotReader& in)
+{
+    random_stream_state state{};
+    state.seed = in.get<uint32_t>();
+    state.node = in.get<uint32_t>();
+    state.purpose = in.get<uint32_t>();
+    state.uniform_position = in.get<int32_t>();
+    state.exponential_position = in.get<int32_t>();
+    state.uniform_block = in.get<uint64_t>();
+    state.exponential_block = in.get<uint64_t>();
+    return RandomStream(state);
+}
+
+static void write_link(SnapshotWriter& out, const Link& link)
+{
+    out.put<int>(link.peer);
+    out.put<int>(link.propagation_delay);
+    out.put<long long>(link.link_speed);
+    out.put<long long>(link.failed);
+    out.put_ids(link.transactions_sent);
+    out.put_set(link.hash_sent);
+    out.put_set(link.release_private_sent);
+}
+
+static Link read_link(SnapshotReader& in)
+{
+    const int peer = in.get<int>();
+    const int propagation_delay = in.get<int>();
+    const long long link_speed = in.get<long long>();
+    Link link(peer, propagation_delay, link_speed);
+    link.failed = in.get<long long>();
+    link.transactions_sent = in.get_ids();
+    link.hash_sent = in.get_set<long long>();
+    link.release_private_sent = in.get_set<int>();
+    return link;
+}
+
+static void write_links(SnapshotWriter& out, const vector<Link>& links)
+{
+    out.put<uint64_t>(links.size());
+    for (const auto& link : links)
+        write_link(out, link);
+}
+
+static vector<Link> read_links(SnapshotReader& in)
+{
+    vector<Link> links;
+    const uint64_t size = in.get<uint64_t>();
+    links.reserve(max<uint64_t>(size, 6));
+    for (uint64_t i = 0; i < size; i++)
+        links.push_back(read_link(in));
+    return links;
+}
+
+static void write_leaf(SnapshotWriter& out, const LeafNode& leaf)
+{
+    out.put<long long>(leaf.block->id);
+    out.put<long long>(leaf.length);
+    out.put_ids(leaf.ledger->transaction_ids);
+    out.put_vector(leaf.ledger->balance);
+    out.put<long long>(leaf.blocks_mined);
+    out.put<long long>(leaf.fork_height);
+}
+
+// leaves of nodes sharing ledgers share the ledger of their block like during the run
+static object_ptr<LeafNode> read_leaf(SnapshotReader& in, const SnapshotObjects& objects, const bool shared_ledger)
+{
+    const auto blk = objects.block(in.get<long long>());
+    const long long length = in.get<long long>();
+    auto leaf = make_object<LeafNode>(blk, length);
+    auto ledger = make_object<Ledger>(blk->id);
+    ledger->transaction_ids = in.get_ids();
+    ledger->balance = in.get_vector<long long>();
+    const auto shared = shared_ledger ? find_shared_ledger(blk->id) : nullptr;
+    if (shared != nullptr)
+        ledger = shared;
+    else if (shared_ledger)
+        share_ledger(ledger);
+    leaf->ledger = std::move(ledger);
+    leaf->blocks_mined = in.get<long long>();
+    leaf->fork_height = in.get<long long>();
+    return leaf;
+}
+
+static void write_node(SnapshotWriter& out, const Node& node)
+{
+    out.put<int>(node.id);
+    out.put<bool>(node.fast());
+    out.put<bool>(node.malicious());
+    out.put<bool>(node.ringmaster());
+    out.put<bool>(node.currently_mining());
+    out.put<long long>(node.hashing_power());
+
+    vector<long long> mempool;
+    for (queue<object_ptr<Transaction>> pending = node.mempool; !pending.empty(); pending.pop())
+        mempool.push_back(pending.front()->id);
+    out.put_vector(mempool);
+    out.put_set(node.transactions_in_pool);
+
+    write_links(out, node.peers);
+    write_links(out, node.malicious_peers);
+
+    out.put<uint64_t>(node.local_storage.size());
+    for (const auto& blk : node.local_storage)
+        out.put<long long>(blk->id);
+    out.put<long long>(node.root->id);
+    out.put_ids(node.root_ledger->transaction_ids);
+    out.put_vector(node.root_ledger->balance);
+    out.put<long long>(node.root_blocks_mined);
+    out.put<uint64_t>(node.leaves.size());
+    for (const auto& leaf : node.leaves)
+        write_leaf(out, *leaf);
+    out.put<bool>(node.private_leaf != nullptr);
+    if (node.private_leaf != nullptr)
+        write_leaf(out, *node.private_leaf);
+    out.put<long long>(node.withheld_fork_point ? node.withheld_fork_point->id : -1);
+    out.put<uint64_t>(node.withheld_blocks.size());
+    for (const auto& blk : node.withheld_blocks)
+        out.put<long long>(blk->id);
+    out.put<bool>(node.withheld_partially_released);
+    out.put<uint64_t>(node.block_ids_in_tree.size());
+    for (const auto& [block_id, first_seen] : node.block_ids_in_tree)
+    {
+        out.put<long long>(block_id);
+        out.put<long long>(first_seen);
+    }
+    out.put<long long>(node.finalized_height);
+    out.put<long long>(node.block_watermark);
+
+    write_random_stream(out, node.latency_rng);
+    write_random_stream(out, node.mining_rng);
+    write_random_stream(out, node.transaction_rng);
+    write_random_stream(out, node.topology_rng);
+
+    out.put<long long>(node.transactions_received);
+    out.put<long long>(node.blocks_received);
+    out.put<long long>(node.chain.blocks_mined);
+    out.put<long long>(node.chain.private_blocks_mined);
+    out.put_vector(node.chain.longest_chain);
+    out.put<long long>(node.chain.longest_chain_offset);
+    out.put<long long>(node.chain.pruned_forks);
+    out.put<long long>(node.chain.pruned_fork_length);
+    out.put<long long>(node.chain.pruned_longest_fork);
+    out.put<long long>(node.chain.pruned_shortest_fork);
+    out.put<uint64_t>(node.chain.pruned_fork_tips.size());
+    for (const auto& fork : node.chain.pruned_fork_tips)
+    {
+        out.put<long long>(fork.tip_id);
+        out.put<long long>(fork.tip_height);
+        out.put<long long>(fork.length);
+    }
+    out.put<long long>(node.chain.reorganisations);
+    out.put<long long>(node.chain.deepest_reorganisation);
+
+    out.put<uint64_t>(node.timers.size());
+    for (const auto& [block_id, timer] : node.timers)
+    {
+        out.put<long long>(block_id);
+        out.put<long long>(timer.blk->id);
+        vector<int> available_senders;
+        for (queue<int> senders = timer.available_senders; !senders.empty(); senders.pop())
+            available_senders.push_back(senders.front());
+        out.put_vector(available_senders);
+        out.put_set(timer.tried_senders);
+        out.put<bool>(timer.is_running);
+        out.put<int>(timer.current_sender);
+    }
+    out.put_set(node.hashes_seen);
+}
+
+static void read_node(SnapshotReader& in, Node& node, const SnapshotObjects& objects)
+{
+    node.id = in.get<int>();
+    node_columns& columns = *node.columns;
+    columns.fast[node.id] = in.get<bool>();
+    columns.malicious[node.id] = in.get<bool>();
+    columns.ringmaster[node.id] = in.get<bool>();
+    columns.currently_mining[node.id] = in.get<bool>();
+    columns.hashing_power[node.id] = in.get<long long>();
+
+    node.mempool = queue<object_ptr<Transaction>>();
+    for (const long long txn_id : in.get_vector<long long>())
+        node.mempool.push(objects.transaction(txn_id));
+    node.transactions_in_pool = in.get_set<long long>();
+
+    node.peers = read_links(in);
+    node.malicious_peers = read_links(in);
+
+    node.local_storage.clear();
+    const uint64_t stored = in.get<uint64_t>();
+    for (uint64_t i = 0; i < stored; i++)
+        node.local_storage.insert(objects.block(in.get<long long>()));
+    node.root = objects.block(in.get<long long>());
+    node.root_ledger = make_object<Ledger>(node.root->id);
+    node.root_ledger->transaction_ids = in.get_ids();
+    node.root_ledger->balance = in.get_vector<long long>();
+    node.root_blocks_mined = in.get<long long>();
+    node.leaves.clear();
+    const uint64_t number_of_leaves = in.get<uint64_t>();
+    for (uint64_t i = 0; i < number_of_leaves; i++)
+        node.leaves.insert(read_leaf(in, objects, node.shares_ledgers()));
+    node.private_leaf = in.get<bool>() ? read_leaf(in, objects, false) : nullptr;
+    node.withheld_fork_point = objects.block(in.get<long long>());
+    node.withheld_blocks.clear();
+    const uint64_t withheld = in.get<uint64_t>();
+    for (uint64_t i = 0; i < withheld; i++)
+        node.withheld_blocks.push_back(objects.block(in.get<long long>()));
+    node.withheld_partially_released = in.get<bool>();
+    node.block_ids_in_tree.clear();
+    const uint64_t blocks_in_tree = in.get<uint64_t>();
+    for (uint64_t i = 0; i < blocks_in_tree; i++)
+    {
+        const long long block_id = in.get<long long>();
+        node.block_ids_in_tree.emplace_hint(node.block_ids_in_tree.end(), block_id, in.get<long long>());
+    }
+    node.finalized_height = in.get<long long>();
+    node.block_watermark = in.get<long long>();
+
+    node.latency_rng = read_random_stream(in);
+    node.mining_rng = read_random_stream(in);
+    node.transaction_rng = read_random_stream(in);
+    node.topology_rng = read_random_stream(in);
+
+    node.transactions_received = in.get<long long>();
+    node.blocks_received = in.get<long long>();
+    node.chain.blocks_mined = in.get<long long>();
+    node.chain.private_blocks_mined = in.get<long long>();
+    node.chain.longest_chain = in.get_vector<long long>();
+    node.chain.longest_chain_offset = in.get<long long>();
+    node.chain.pruned_forks = in.get<long long>();
+    node.chain.pruned_fork_length = in.get<long long>();
+    node.chain.pruned_longest_fork = in.get<long long>();
+    node.chain.pruned_shortest_fork = in.get<long long>();
+    node.chain.pruned_fork_tips.resize(in.get<uint64_t>());
+    for (auto& fork : node.chain.pruned_fork_tips)
+    {
+        fork.tip_id = in.get<long long>();
+        fork.tip_height = in.get<long long>();
+        fork.length = in.get<long long>();
+    }
+    node.chain.reorganisations = in.get<long long>();
+    node.chain.deepest_reorganisation = in.get<long long>();
+
+    node.timers.clear();
+    const uint64_t number_of_timers = in.get<uint64_t>();
+    for (uint64_t i = 0; i < number_of_timers; i++)
+    {
+        const long long block_id = in.get<long long>();
+        Timer timer(objects.block(in.get<long long>()), false);
+        for (const int sender : in.get_vector<int>())
+            timer.available_senders.push(sender);
+        timer.tried_senders = in.get_set<int>();
+        timer.is_running = in.get<bool>();
+        timer.current_sender = in.get<int>();
+        node.timers.emplace_hint(node.timers.end(), block_id, timer);
+    }
+    node.hashes_seen = in.get_set<long long>();
+}
+
+void write_network(SnapshotWriter& out, const Network& network)
+{
+    out.put_vector(network.malicious_node_ids);
+    out.put_vector(network.honest_node_ids);
+    out.put<int>(network.ringmaster_node_id);
+    write_random_stream(out, network.topology_rng);
+    out.put<uint64_t>(network.nodes.size());
+    for (const auto& node : network.nodes)
+        write_node(out, node);
+
+    out.put_vector(chain_store.archive_block_id);
+    out.put_vector(chain_store.archive_parent_id);
+    out.put_vector(chain_store.archive_creation_time);
+    out.put_vector(chain_store.archive_transaction_count);
+    out.put_vector(chain_store.archive_miner);
+}
+
+void read_network(SnapshotReader& in, Network& network, const SnapshotObjects& objects)
+{
+    network.malicious_node_ids = in.get_vector<int>();
+    network.honest_node_ids = in.get_vector<int>();
+    network.ringmaster_node_id = in.get<int>();
+    network.topology_rng = read_random_stream(in);
+    if (in.get<uint64_t>() != network.nodes.size())
+        throw runtime_error("Snapshot was taken with a different number of nodes");
+    for (auto& node : network.nodes)
+        read_node(in, node, objects);
+
+    chain_store.archive_block_id = in.get_vector<long long>();
+    chain_store.archive_parent_id = in.get_vector<long long>();
+    chain_store.archive_creation_time = in.get_vector<long long>();
+    chain_store.archive_transaction_count = in.get_vector<uint32_t>();
+    chain_store.archive_miner = in.get_vector<int32_t>();
+    network.index_node_roots();
+}
+
+void write_propagation(SnapshotWriter& out, const PropagationTracker& tracker)
+{
+    out.put<uint64_t>(tracker.pending.size());
+    for (const auto& [block_id, block] : tracker.pending)
+    {
+        out.put<long long>(block_id);
+        out.put<long long>(block.mined_time);
+        out.put<int>(block.honest_reached);
+        out.put<int>(block.honest_passed);
+        out.put<int>(block.mode);
+        out.put<bool>(block.honest_miner);
+    }
+    for (int mode = 0; mode < PROPAGATION_MODES; mode++)
+        for (int miner_class = 0; miner_class < PROPAGATION_CLASSES; miner_class++)
+        {
+            out.put<long long>(tracker.blocks_mined[mode][miner_class]);
+            for (const auto& histogram : tracker.histograms[mode][miner_class])
+            {
+                for (const long long count : histogram.buckets)
+                    out.put_varint(count);
+                out.put<long long>(histogram.blocks);
+                out.put<long long>(histogram.total_latency);
+                out.put<long long>(histogram.max_latency);
+            }
+        }
+}
+
+void read_propagation(SnapshotReader& in, PropagationTracker& tracker)
+{
+    const uint64_t number_of_pending = in.get<uint64_t>();
+    for (uint64_t i = 0; i < number_of_pending; i++)
+    {
+        const long long block_id = in.get<long long>();
+        propagation_pending& block = tracker.pending[block_id];
+        block.mined_time = in.get<long long>();
+        block.honest_reached = in.get<int>();
+        block.honest_passed = in.get<int>();
+        block.mode = in.get<int>();
+        block.honest_miner = in.get<bool>();
+    }
+    for (int mode = 0; mode < PROPAGATION_MODES; mode++)
+        for (int miner_class = 0; miner_class < PROPAGATION_CLASSES; miner_class++)
+        {
+            tracker.blocks_mined[mode][miner_class] = in.get<long long>();
+            for (auto& histogram : tracker.histograms[mode][miner_class])
+            {
+                for (long long& count : histogram.buckets)
+                    count = static_cast<long long>(in.get_varint());
+                histogram.blocks = in.get<long long>();
+                histogram.total_latency = in.get<long long>();
+                histogram.max_latency = in.get<long long>();
+            }
+        }
+}
+
+void write_event(SnapshotWriter& out, const Event& e)
+{
+    out.put<long long>(e.time);
+    out.put<int>(e.type);
+    out.put<uint32_t>(static_cast<uint32_t>(e.object.index()));
+    visit([&out](const auto& obj)
+    {
+        using T = decay_t<decltype(obj)>;
+        if constexpr (is_same_v<T, create_transaction_object>)
+            out.put<int>(obj.creator_node_id);
+        else if constexpr (is_same_v<T, receive_transaction_object>)
+        {
+            out.put<int>(obj.sender_node_id);
+            out.put<int>(obj.receiver_node_id);
+            out.put<long long>(obj.txn->id);
+        }
+        else if constexpr (is_same_v<T, receive_block_object> || is_same_v<T, get_block_request_object>)
+        {
+            out.put<int>(obj.sender_node_id);
+            out.put<int>(obj.receiver_node_id);
+            out.put<long long>(obj.blk->id);
+        }
+        else if constexpr (is_same_v<T, block_mined_object>)
+        {
+            out.put<int>(obj.miner_node_id);
+            out.put<long long>(obj.blk->id);
+        }
+        else if constexpr (is_same_v<T, receive_hash_object>)
+        {
+            out.put<long long>(obj.block_hash);
+            out.put<int>(obj.sender_node_id);
+            out.put<int>(obj.receiver_node_id);
+            out.put<long long>(obj.blk->id);
+        }
+        else if constexpr (is_same_v<T, timer_expired_object>)
+        {
+            out.put<int>(obj.node_id);
+            out.put<long long>(obj.blk->id);
+        }
+        else
+        {
+            out.put<int>(obj.node_id);
+            out.put<int>(obj.counter);
+            out.put<long long>(obj.height);
+        }
+    }, e.object);
+}
+
+Event read_event(SnapshotReader& in, const SnapshotObjects& objects)
+{
+    const long long time = in.get<long long>();
+    const int type = in.get<int>();
+    const uint32_t index = in.get<uint32_t>();
+
+    // fields are read into named locals since the order of evaluation of constructor arguments is unspecified
+    switch (index)
+    {
+    case 0:
+        {
+            const int creator = in.get<int>();
+            return {time, type, create_transaction_object(creator)};
+        }
+    case 1:
+        {
+            const int sender = in.get<int>();
+            const int receiver = in.get<int>();
+            return {time, type, receive_transaction_object(sender, receiver, objects.transaction(in.get<long long>()))};
+        }
+    case 2:
+        {
+            const int sender = in.get<int>();
+            const int receiver = in.get<int>();
+            return {time, type, receive_block_object(sender, receiver, objects.block(in.get<long long>()))};
+        }
+    case 3:
+        {
+            const int miner = in.get<int>();
+            return {time, type, block_mined_object(miner, objects.block(in.get<long long>()))};
+        }
+    case 4:
+        {
+            const long long hash = in.get<long long>();
+            const int sender = in.get<int>();
+            const int receiver = in.get<int>();
+            return {time, type, receive_hash_object(hash, sender, receiver, objects.block(in.get<long long>()))};
+        }
+    case 5:
+        {
+            const int sender = in.get<int>();
+            const int receiver = in.get<int>();
+            return {time, type, get_block_request_object(sender, receiver, objects.block(in.get<long long>()))};
+        }
+    case 6:
+        {
+            const int node_id = in.get<int>();
+            return {time, type, timer_expired_object(node_id, objects.block(in.get<long long>()))};
+        }
+    case 7:
+        {
+            const int node_id = in.get<int>();
+            const int counter = in.get<int>();
+            const long long height = in.get<long long>();
+            return {time, type, release_private_object(node_id, counter, height)};
+        }
+    default:
+        throw runtime_error("Snapshot contains an unknown event");
+    }
+}
+
+// the container of a priority_queue is a protected member, reachable through a derived class
+struct event_queue_access : EQ
+{
+    static vector<Event>& heap(EQ& queue)
+    {
+        return queue.*(&event_queue_access::c);
+    }
+};
+
+const vector<Event>& event_heap(const EQ& queue)
+{
+    return event_queue_access::heap(const_cast<EQ&>(queue));
+}
+
+void set_event_heap(EQ& queue, vector<Event> events)
+{
+    event_queue_access::heap(queue) = std::move(events);
+}
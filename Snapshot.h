@@ -0,0 +1,191 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include "Network.h"
+#include "Propagation.h"
+
+using namespace std;
+
+/*
+ * Binary snapshot of a simulation (little endian, written by Simulator::save_snapshot)
+ *   header            magic "P2PSNAP\0", version
+ *   parameters        every config value that shapes the network and the events, checked on restore
+ *   clock             simulation time, id tickets, private release counter, progress of the event loop
+ *   transactions      table by id
+ *   blocks            table by id with nonces, parents and transactions stored as ids, hashes are recomputed
+ *                     except for roots cut from their parents
+ *   network           node roles, topology stream and every node: mempool, links, leaves, withheld segment,
+ *                     timers, streams, finality watermarks, roots with their ledgers, pruned forks and
+ *                     reorganisation counts, then the block archive of the chain store
+ *   propagation       blocks still spreading to the honest nodes and the latency histograms
+ *   events            heap array of the event queue, blocks and transactions stored as ids
+ * Objects shared between nodes and events are written once and referenced by id, so they are shared again
+ * after restoring.
+ */
+
+#define SNAPSHOT_VERSION 14
+
+class SnapshotWriter
+{
+    string buffer;
+
+public:
+    template <typename T>
+    void put(const T& value)
+    {
+        static_assert(is_arithmetic_v<T>, "only arithmetic values are written directly");
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void put_string(const string& value);
+    // LEB128, 1 byte for values below 128
+    void put_varint(uint64_t value);
+
+    template <typename T>
+    void put_vector(const vector<T>& values)
+    {
+        put<uint64_t>(values.size());
+        for (const auto& value : values)
+            put<T>(value);
+    }
+
+    // sorted ids as varint gaps, most sets hold dense ranges of ids
+    template <typename T>
+    void put_set(const set<T>& values)
+    {
+        static_assert(is_integral_v<T>, "only sets of ids are written");
+        put_varint(values.size());
+        long long previous = -1;
+        for (const auto& value : values)
+        {
+            put_varint(static_cast<uint64_t>(static_cast<long long>(value) - previous));
+            previous = value;
+        }
+    }
+
+    // same layout as a set of the same ids
+    void put_ids(const IdSet& values)
+    {
+        put_varint(values.size());
+        long long previous = -1;
+        values.for_each([this, &previous](const long long value)
+        {
+            put_varint(static_cast<uint64_t>(value - previous));
+            previous = value;
+        });
+    }
+
+    const string& bytes() const;
+};
+
+class SnapshotReader
+{
+    const string& buffer;
+    size_t position;
+
+public:
+    explicit SnapshotReader(const string& buffer);
+
+    template <typename T>
+    T get()
+    {
+        static_assert(is_arithmetic_v<T>, "only arithmetic values are read directly");
+        if (position + sizeof(T) > buffer.size())
+            throw runtime_error("Snapshot is truncated");
+        T value;
+        memcpy(&value, buffer.data() + position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+
+    string get_string();
+    uint64_t get_varint();
+
+    template <typename T>
+    vector<T> get_vector()
+    {
+        vector<T> values(get<uint64_t>());
+        for (auto& value : values)
+            value = get<T>();
+        return values;
+    }
+
+    template <typename T>
+    set<T> get_set()
+    {
+        set<T> values;
+        const uint64_t size = get_varint();
+        long long previous = -1;
+        for (uint64_t i = 0; i < size; i++)
+        {
+            previous += static_cast<long long>(get_varint());
+            values.insert(values.end(), static_cast<T>(previous));
+        }
+        return values;
+    }
+
+    IdSet get_ids()
+    {
+        IdSet values;
+        const uint64_t size = get_varint();
+        long long previous = -1;
+        for (uint64_t i = 0; i < size; i++)
+        {
+            previous += static_cast<long long>(get_varint());
+            values.insert(previous);
+        }
+        return values;
+    }
+
+    bool at_end() const;
+};
+
+// blocks and transactions of a simulation by id
+class SnapshotObjects
+{
+    map<long long, object_ptr<Transaction>> transactions;
+    map<long long, object_ptr<Block>> blocks;
+
+public:
+    // adds a block with its transactions and all its ancestors
+    void collect(const object_ptr<Block>& blk);
+    void collect(const object_ptr<Transaction>& txn);
+    // adds every block and transaction referenced by the nodes and the pending events
+    void collect(const Network& network, const vector<Event>& events);
+
+    void write(SnapshotWriter& out) const;
+    void read(SnapshotReader& in);
+
+    // nullptr for id -1
+    object_ptr<Block> block(long long id) const;
+    object_ptr<Transaction> transaction(long long id) const;
+    size_t number_of_blocks() const;
+    size_t number_of_transactions() const;
+};
+
+void write_random_stream(SnapshotWriter& out, const RandomStream& stream);
+RandomStream read_random_stream(SnapshotReader& in);
+
+void write_network(SnapshotWriter& out, const Network& network);
+// network must have been created with the saved number of nodes
+void read_network(SnapshotReader& in, Network& network, const SnapshotObjects& objects);
+
+// tracker must have been reset with the number of honest nodes of the restored network
+void write_propagation(SnapshotWriter& out, const PropagationTracker& tracker);
+void read_propagation(SnapshotReader& in, PropagationTracker& tracker);
+
+void write_event(SnapshotWriter& out, const Event& e);
+Event read_event(SnapshotReader& in, const SnapshotObjects& objects);
+
+// heap array of the event queue, restored as is so events with equal times pop in the saved order
+const vector<Event>& event_heap(const EQ& queue);
+void set_event_heap(EQ& queue, vector<Event> events);
+
+#endif //SNAPSHOT_H
@@ -0,0 +1,135 @@
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include <climits>
+#include <utility>
+#include "Network.h"
+
+using namespace std;
+
+/*
+ * Mining strategies as compile-time policies. Every node is bound to a strategy kind by
+ * Network::assign_strategies, each event dispatches once on that kind and the handlers are instantiated per
+ * policy, so the attack checks of honest nodes are resolved at compile time.
+ *
+ * A policy answers, for a node:
+ *   attacker          member of the malicious overlay, its blocks can arrive before they are public
+ *   withholds         keeps private blocks in a private leaf until they are released
+ *   mines_privately   mines on its private leaf (the selfish ringmaster)
+ *   eclipses          refuses honest blocks to honest requesters
+ *   release_height    after an honest block extended its longest chain: publish the withheld blocks up to this
+ *                     height, LLONG_MAX for all of them, -1 for none
+ * New strategies only need a policy and a kind in dispatch_strategy.
+ */
+
+// release rules of the ringmaster, chosen with SimulationConfig::release_strategy
+#define RELEASE_SELFISH 0 // SM1: override when the lead drops to one, match the honest tip otherwise
+#define RELEASE_LEAD_STUBBORN 1 // never override, publish all only at a tie and match the honest tip otherwise
+
+// strategy kinds, attackers add ATTACKER_* flags to STRATEGY_ATTACKER
+#define STRATEGY_HONEST 0
+#define STRATEGY_ATTACKER 1
+#define ATTACKER_WITHHOLD 1
+#define ATTACKER_ECLIPSE 2
+#define ATTACKER_RINGMASTER 4
+#define ATTACKER_STUBBORN 8
+#define STRATEGY_KINDS (STRATEGY_ATTACKER + 16)
+#define STRATEGY_BRANCHING STRATEGY_KINDS // every check evaluated per event, as before the policies
+
+struct SelfishRelease
+{
+    static long long release_height(const long long public_length, const long long private_length)
+    {
+        if (public_length == private_length - 1 || public_length == private_length)
+            return LLONG_MAX;
+        return public_length < private_length - 1 ? public_length : -1;
+    }
+};
+
+struct LeadStubbornRelease
+{
+    static long long release_height(const long long public_length, const long long private_length)
+    {
+        if (public_length == private_length)
+            return LLONG_MAX;
+        return public_length < private_length ? public_length : -1;
+    }
+};
+
+struct HonestStrategy
+{
+    static constexpr bool attacker(const Node&) { return false; }
+    static constexpr bool withholds(const Node&) { return false; }
+    static constexpr bool mines_privately(const Node&) { return false; }
+    static constexpr bool eclipses(const Node&) { return false; }
+    static constexpr long long release_height(long long, long long) { return -1; }
+};
+
+template <bool Withhold, bool Eclipse, bool Ringmaster, typename Release>
+struct AttackerStrategy
+{
+    static constexpr bool attacker(const Node&) { return true; }
+    static constexpr bool withholds(const Node&) { return Withhold; }
+    static constexpr bool mines_privately(const Node&) { return Withhold && Ringmaster; }
+    static constexpr bool eclipses(const Node&) { return Eclipse; }
+    static long long release_height(const long long public_length, const long long private_length)
+    {
+        return Release::release_height(public_length, private_length);
+    }
+};
+
+// reads the node roles and the attack toggles on every check
+struct BranchingStrategy
+{
+    static bool attacker(const Node& node) { return node.malicious(); }
+    static bool withholds(const Node& node) { return selfish_mining && node.malicious(); }
+    static bool mines_privately(const Node& node) { return selfish_mining && node.ringmaster(); }
+    static bool eclipses(const Node& node) { return eclipse_attack && node.malicious(); }
+    static long long release_height(const long long public_length, const long long private_length)
+    {
+        return release_strategy == RELEASE_LEAD_STUBBORN
+                   ? LeadStubbornRelease::release_height(public_length, private_length)
+                   : SelfishRelease::release_height(public_length, private_length);
+    }
+};
+
+template <int Flags>
+using attacker_strategy = AttackerStrategy<(Flags & ATTACKER_WITHHOLD) != 0, (Flags & ATTACKER_ECLIPSE) != 0,
+                                           (Flags & ATTACKER_RINGMASTER) != 0,
+                                           conditional_t<(Flags & ATTACKER_STUBBORN) != 0, LeadStubbornRelease,
+                                                         SelfishRelease>>;
+
+template <typename F, int... Flags>
+void dispatch_attacker(const int flags, F&& handler, integer_sequence<int, Flags...>)
+{
+    ((flags == Flags ? (handler(attacker_strategy<Flags>()), true) : false) || ...);
+}
+
+// calls handler with a default constructed policy of the given kind
+template <typename F>
+void dispatch_strategy(const int kind, F&& handler)
+{
+    if (kind == STRATEGY_HONEST)
+        handler(HonestStrategy());
+    else if (kind == STRATEGY_BRANCHING)
+        handler(BranchingStrategy());
+    else
+        dispatch_attacker(kind - STRATEGY_ATTACKER, handler, make_integer_sequence<int, 16>());
+}
+
+// kind of a node for the current roles and toggles
+inline int strategy_kind(const Node& node)
+{
+    if (branching_strategies)
+        return STRATEGY_BRANCHING;
+    if (!node.malicious())
+        return STRATEGY_HONEST;
+    int flags = 0;
+    if (selfish_mining) flags |= ATTACKER_WITHHOLD;
+    if (eclipse_attack) flags |= ATTACKER_ECLIPSE;
+    if (node.ringmaster()) flags |= ATTACKER_RINGMASTER;
+    if (selfish_mining && node.ringmaster() && release_strategy == RELEASE_LEAD_STUBBORN) flags |= ATTACKER_STUBBORN;
+    return STRATEGY_ATTACKER + flags;
+}
+
+#endif //STRATEGY_H
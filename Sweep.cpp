@@ -0,0 +1,126 @@
+#include "Sweep.h"
+
+#include <chrono>
+#include <sstream>
+#include "ThreadPool.h"
+#include "Strategy.h"
+
+sweep_result::sweep_result()
+{
+    ringmaster_node_id = -1;
+    wall_time = 0;
+    accounted_bytes = 0;
+}
+
+vector<SimulationConfig> read_sweep_file(const string& filepath, const SimulationConfig& base, const string& output_dir)
+{
+    ifstream file(filepath);
+    if (!file)
+        throw runtime_error("Unable to open sweep file " + filepath);
+
+    vector<SimulationConfig> configs;
+    string line;
+    int line_number = 0;
+    while (getline(file, line))
+    {
+        line_number++;
+        const auto first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+            continue;
+
+        SimulationConfig config = base;
+        istringstream fields(line);
+        int block_inter_arrival_time_sec = 0;
+        if (!(fields >> config.number_of_nodes >> config.percent_malicious_nodes
+                     >> config.mean_transaction_inter_arrival_time >> block_inter_arrival_time_sec
+                     >> config.timer_timeout_time))
+            throw runtime_error("Invalid sweep line " + to_string(line_number) + ": " + line);
+        config.block_inter_arrival_time = block_inter_arrival_time_sec * 1000;
+
+        string option;
+        while (fields >> option)
+        {
+            if (option == "--eclipse") config.eclipse_attack = true;
+            else if (option == "--mitigation") config.mitigation = true;
+            else if (option == "--no-selfish-mining") config.selfish_mining = false;
+            else if (option == "--stubborn") config.release_strategy = RELEASE_LEAD_STUBBORN;
+            else if (option == "--restore" && fields >> config.restore_path) continue;
+            else throw runtime_error("Unknown option " + option + " in sweep line " + to_string(line_number));
+        }
+
+        if (const string error = config.validate(); !error.empty())
+            throw runtime_error(error + " in sweep line " + to_string(line_number));
+
+        config.output_dir = output_dir + "/run_" + to_string(configs.size());
+        configs.push_back(config);
+    }
+    return configs;
+}
+
+vector<sweep_result> run_sweep(const vector<SimulationConfig>& configs, const unsigned int num_threads)
+{
+    vector<sweep_result> results(configs.size());
+    ThreadPool pool(num_threads);
+
+    for (size_t i = 0; i < configs.size(); i++)
+    {
+        pool.enqueue([&configs, &results, i]
+        {
+            sweep_result& result = results[i];
+            result.config = configs[i];
+            const auto start = chrono::steady_clock::now();
+            try
+            {
+                // the simulator installs its state into this pool thread's globals, its console output goes to
+                // its own log since concurrent runs share stdout
+                SimulationConfig config = configs[i];
+                config.console_to_log = true;
+                const unique_ptr<Simulator> sim = create_simulator(config);
+                sim->start();
+                result.accounted_bytes = sim->get_run_statistics().accounted_bytes;
+
+                result.ringmaster_node_id = sim->network.ringmaster_node_id;
+                result.ringmaster = sim->network.nodes[sim->network.ringmaster_node_id].summarize_chain();
+            }
+            catch (const exception& e)
+            {
+                result.error = e.what();
+            }
+            result.wall_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        });
+    }
+    pool.wait_idle();
+    return results;
+}
+
+void write_sweep_results(const vector<sweep_result>& results, const string& filepath)
+{
+    ofstream file(filepath);
+    if (!file)
+    {
+        cerr << "An Error occurred while opening file!" << endl;
+        return;
+    }
+
+    // ratio_1 and ratio_2 as computed by scripts/exp_multi.py
+    file << "number_of_nodes,percent_malicious,mean_transaction_inter_arrival,block_inter_arrival,timeout,is_eclipse,"
+            "mitigation,selfish_mining,release_strategy,output_dir,ringmaster_id,blocks_mined,blocks_mined_in_longest_chain,blocks_in_longest_chain,"
+            "ratio_1,ratio_2,wall_time_sec,accounted_bytes,error" << endl;
+    for (const auto& result : results)
+    {
+        const SimulationConfig& config = result.config;
+        const node_summary& ringmaster = result.ringmaster;
+        const double ratio_2 = ringmaster.blocks_mined > 0
+                                   ? static_cast<double>(ringmaster.blocks_mined_in_longest_chain) /
+                                     static_cast<double>(ringmaster.blocks_mined)
+                                   : 0;
+        file << config.number_of_nodes << "," << config.percent_malicious_nodes << ","
+            << config.mean_transaction_inter_arrival_time << "," << config.block_inter_arrival_time / 1000 << ","
+            << config.timer_timeout_time << "," << config.eclipse_attack << "," << config.mitigation << ","
+            << config.selfish_mining << "," << config.release_strategy << ","
+            << config.output_dir << "," << result.ringmaster_node_id << "," << ringmaster.blocks_mined << ","
+            << ringmaster.blocks_mined_in_longest_chain << "," << ringmaster.blocks_in_longest_chain << ","
+            << (result.error.empty() ? ringmaster.fraction_mined_in_longest_chain() : 0) << "," << ratio_2 << ","
+            << result.wall_time << "," << result.accounted_bytes << "," << result.error << endl;
+    }
+}
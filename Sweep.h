@@ -0,0 +1,30 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "Simulator.h"
+
+// outcome of one configuration of a sweep, as seen by its ringmaster
+struct sweep_result
+{
+    SimulationConfig config;
+    int ringmaster_node_id;
+    node_summary ringmaster;
+    double wall_time; // seconds
+    uint64_t accounted_bytes; // heap bytes of this simulation at its end, process RSS would include the other runs
+    string error; // empty if the run completed
+
+    sweep_result();
+};
+
+// Reads one configuration per line, blank lines and lines starting with # are skipped:
+// <number_of_nodes> <percent_malicious> <mean_transaction_inter_arrival_time> <block_inter_arrival_time> <timeout time> [--eclipse] [--mitigation] [--no-selfish-mining] [--restore <snapshot>]
+// each configuration writes its output to a subdirectory of output_dir
+vector<SimulationConfig> read_sweep_file(const string& filepath, const SimulationConfig& base, const string& output_dir);
+
+// runs all configurations in this process, each simulation on its own pool thread
+vector<sweep_result> run_sweep(const vector<SimulationConfig>& configs, unsigned int num_threads);
+
+// one row per configuration
+void write_sweep_results(const vector<sweep_result>& results, const string& filepath);
+
+#endif //SWEEP_H
@@ -0,0 +1,70 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int num_threads)
+{
+    if (num_threads == 0)
+        num_threads = max(1u, thread::hardware_concurrency());
+
+    running_tasks = 0;
+    stopping = false;
+    workers.reserve(num_threads);
+    for (unsigned int i = 0; i < num_threads; i++)
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(tasks_mutex);
+        stopping = true;
+    }
+    task_available.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::enqueue(function<void()> task)
+{
+    {
+        lock_guard<mutex> lock(tasks_mutex);
+        tasks.push(std::move(task));
+    }
+    task_available.notify_one();
+}
+
+void ThreadPool::wait_idle()
+{
+    unique_lock<mutex> lock(tasks_mutex);
+    all_done.wait(lock, [this] { return tasks.empty() && running_tasks == 0; });
+}
+
+size_t ThreadPool::size() const
+{
+    return workers.size();
+}
+
+void ThreadPool::worker_loop()
+{
+    while (true)
+    {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(tasks_mutex);
+            task_available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop();
+            running_tasks++;
+        }
+
+        task();
+
+        {
+            lock_guard<mutex> lock(tasks_mutex);
+            running_tasks--;
+            if (tasks.empty() && running_tasks == 0)
+                all_done.notify_all();
+        }
+    }
+}
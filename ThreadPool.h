@@ -0,0 +1,39 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+// Fixed size pool of worker threads processing a shared FIFO of tasks
+class ThreadPool
+{
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex tasks_mutex;
+    condition_variable task_available;
+    condition_variable all_done;
+    size_t running_tasks;
+    bool stopping;
+
+    void worker_loop();
+
+public:
+    // 0 threads uses the number of hardware threads
+    explicit ThreadPool(unsigned int num_threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(function<void()> task);
+    // blocks until the queue is empty and no task is running
+    void wait_idle();
+    size_t size() const;
+};
+
+#endif //THREADPOOL_H
@@ -0,0 +1,45 @@
+// Compares the SHA-256 kernels on block headers and Merkle tree levels
+// Run: ./hash_benchmark [messages]
+
+#include "../Sha256.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void run(const string& name, const vector<uint8_t>& data, const size_t length, const size_t count)
+{
+    vector<sha256_digest> digests(count);
+    const auto start = chrono::steady_clock::now();
+    sha256_many(data.data(), length, count, digests.data());
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "  " << name << ": " << seconds * 1e9 / static_cast<double>(count) << " ns/hash, "
+        << static_cast<double>(length * count) / seconds / 1e6 << " MB/s (first " << to_hex(digests[0]).substr(0, 16)
+        << ")" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t count = argc > 1 ? stoull(argv[1]) : 2000000;
+    vector<uint8_t> data(count * 80);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+
+    cout << "Default kernel: " << sha256_kernel_name(sha256_kernel()) << endl;
+    for (const int kernel : {SHA256_KERNEL_SCALAR, SHA256_KERNEL_AVX2, SHA256_KERNEL_SHANI})
+    {
+        if (!sha256_set_kernel(kernel))
+        {
+            cout << sha256_kernel_name(kernel) << ": not supported by this CPU" << endl;
+            continue;
+        }
+        cout << sha256_kernel_name(kernel) << endl;
+        run("32 byte transaction leaves", data, 32, count);
+        run("64 byte Merkle pairs", data, 64, count);
+        run("80 byte block headers", data, 80, count);
+    }
+    return 0;
+}
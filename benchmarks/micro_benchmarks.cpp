@@ -0,0 +1,352 @@
+// Parameterized micro benchmarks of the simulator hot paths, results as JSON to track regressions across versions
+// Run: ./micro_benchmarks [output.json] [--quick] [--filter <name>] [--label <version>]
+// The summary goes to stderr, the simulators print their progress to stdout
+
+#include "../Simulator.h"
+#include "../Sha256.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// one benchmark at one parameter setting
+struct benchmark_result
+{
+    string name;
+    vector<pair<string, string>> params;
+    long long iterations; // operations per batch
+    vector<double> ns_per_op; // one value per batch
+};
+
+struct benchmark_options
+{
+    bool quick = false;
+    string filter;
+    int batches = 9;
+};
+
+static vector<benchmark_result> results;
+
+static bool selected(const benchmark_options& options, const string& name)
+{
+    return options.filter.empty() || name.find(options.filter) != string::npos;
+}
+
+// small network whose nodes are used directly, the initial transactions are dropped
+static SimulationConfig benchmark_config(const int number_of_nodes)
+{
+    SimulationConfig config;
+    config.number_of_nodes = number_of_nodes;
+    config.percent_malicious_nodes = 10;
+    config.mean_transaction_inter_arrival_time = 50;
+    config.block_inter_arrival_time = 10000;
+    config.timer_timeout_time = 1000;
+    config.initial_number_of_transactions = 1000;
+    config.output_dir = "micro_benchmark_out";
+    return config;
+}
+
+static int honest_miner(const Network& network)
+{
+    for (const auto& node : network.nodes)
+        if (!node.malicious() && node.hashing_power() > 0)
+            return node.id;
+    return 0;
+}
+
+// block on parent mined by miner with transfers of 1 between neighbouring node ids
+static object_ptr<Block> make_block(const object_ptr<Block>& parent, const int miner, const int transfers)
+{
+    auto blk = make_object<Block>(simulation_time, parent, false, true);
+    blk->transactions.push_back(make_object<Transaction>(miner, mining_reward, true));
+    for (int i = 0; i < transfers; i++)
+    {
+        const int sender = static_cast<int>((blk->id + i) % number_of_nodes);
+        blk->transactions.push_back(make_object<Transaction>((sender + 1) % number_of_nodes, 1, false, sender));
+    }
+    return blk;
+}
+
+static void report(const benchmark_result& result)
+{
+    vector<double> sorted = result.ns_per_op;
+    sort(sorted.begin(), sorted.end());
+    cerr << "  " << result.name;
+    for (const auto& [key, value] : result.params)
+        cerr << " " << key << "=" << value;
+    cerr << ": " << sorted[sorted.size() / 2] << " ns/op (min " << sorted.front() << ")" << endl;
+    results.push_back(result);
+}
+
+// validate_and_add_block on the tip (leaf parent) or on the block below it (non-leaf parent, walks the chain)
+static void benchmark_validate_and_add_block(const benchmark_options& options)
+{
+    const string name = "validate_and_add_block";
+    if (!selected(options, name))
+        return;
+    const vector<long long> chain_lengths = options.quick ? vector<long long>{100, 1000}
+                                                          : vector<long long>{100, 1000, 4000};
+    const int transfers = 4;
+    const int iterations = 10;
+
+    for (const long long chain_length : chain_lengths)
+    {
+        const unique_ptr<Simulator> sim = create_simulator(benchmark_config(20));
+        Node& node = sim->network.nodes[honest_miner(sim->network)];
+        object_ptr<Block> tip = node.root;
+        for (long long i = 1; i < chain_length; i++)
+        {
+            tip = make_block(tip, node.id, transfers);
+            node.validate_and_add_block(tip);
+        }
+        event_queue = EQ();
+        // every batch starts from the same leaves and chain stats
+        const auto saved_leaves = node.leaves;
+        const chain_stats saved_chain = node.chain;
+
+        for (const bool leaf_parent : {true, false})
+        {
+            benchmark_result result{name, {{"parent", leaf_parent ? "leaf" : "non_leaf"},
+                                           {"chain_length", to_string(chain_length)}}, iterations, {}};
+            for (int batch = 0; batch < options.batches; batch++)
+            {
+                // leaf parents extend the tip block by block, non-leaf parents all fork below the tip
+                vector<object_ptr<Block>> blocks;
+                object_ptr<Block> parent = leaf_parent ? tip : tip->parent_block;
+                for (int i = 0; i < iterations; i++)
+                {
+                    blocks.push_back(make_block(parent, node.id, transfers));
+                    if (leaf_parent)
+                        parent = blocks.back();
+                }
+
+                const auto start = chrono::steady_clock::now();
+                for (const auto& blk : blocks)
+                    node.validate_and_add_block(blk);
+                const double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+                result.ns_per_op.push_back(ns / iterations);
+
+                node.leaves = saved_leaves;
+                node.chain = saved_chain;
+                event_queue = EQ();
+            }
+            report(result);
+        }
+    }
+}
+
+// mine_block with a mempool of the given size, a block takes at most 1000 transactions
+static void benchmark_mine_block(const benchmark_options& options)
+{
+    const string name = "mine_block";
+    if (!selected(options, name))
+        return;
+    const vector<int> mempool_sizes = options.quick ? vector<int>{10, 1000} : vector<int>{10, 100, 1000, 10000};
+    const int iterations = 50;
+
+    const unique_ptr<Simulator> sim = create_simulator(benchmark_config(20));
+    Node& node = sim->network.nodes[honest_miner(sim->network)];
+    event_queue = EQ();
+
+    for (const int mempool_size : mempool_sizes)
+    {
+        vector<object_ptr<Transaction>> pool;
+        for (int i = 0; i < mempool_size; i++)
+        {
+            const int sender = i % number_of_nodes;
+            pool.push_back(make_object<Transaction>((sender + 1) % number_of_nodes, 1, false, sender));
+        }
+
+        benchmark_result result{name, {{"mempool_size", to_string(mempool_size)}}, iterations, {}};
+        for (int batch = 0; batch < options.batches; batch++)
+        {
+            double ns = 0;
+            for (int i = 0; i < iterations; i++)
+            {
+                node.mempool = queue<object_ptr<Transaction>>();
+                node.transactions_in_pool.clear();
+                for (const auto& txn : pool)
+                {
+                    node.mempool.push(txn);
+                    node.transactions_in_pool.insert(txn->id);
+                }
+                const auto start = chrono::steady_clock::now();
+                node.mine_block();
+                ns += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+                node.set_currently_mining(false);
+            }
+            result.ns_per_op.push_back(ns / iterations);
+            event_queue = EQ();
+        }
+        report(result);
+    }
+}
+
+// one push and one pop of the event queue at a steady depth
+static void benchmark_event_queue(const benchmark_options& options)
+{
+    const string name = "event_queue_push_pop";
+    if (!selected(options, name))
+        return;
+    const vector<int> depths = options.quick ? vector<int>{1000, 100000} : vector<int>{1000, 10000, 100000, 1000000};
+    const int iterations = 100000;
+
+    RandomStream rng(911, 0, RNG_TRANSACTION);
+    for (const int depth : depths)
+    {
+        EQ queue;
+        for (int i = 0; i < depth; i++)
+            queue.emplace(exponential_distribution(rng, 1000.0 * depth), RECEIVE_BLOCK,
+                          receive_block_object(0, 1, nullptr));
+
+        benchmark_result result{name, {{"depth", to_string(depth)}}, iterations, {}};
+        for (int batch = 0; batch < options.batches; batch++)
+        {
+            const auto start = chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                const long long now = queue.top().time;
+                queue.pop();
+                queue.emplace(now + exponential_distribution(rng, 1000.0 * depth), RECEIVE_BLOCK,
+                              receive_block_object(0, 1, nullptr));
+            }
+            const double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            result.ns_per_op.push_back(ns / iterations);
+        }
+        report(result);
+    }
+}
+
+// a new Simulator runs Network::build_network for the common and the malicious overlay
+static void benchmark_build_network(const benchmark_options& options)
+{
+    const string name = "build_network";
+    if (!selected(options, name))
+        return;
+    const vector<int> sizes = options.quick ? vector<int>{100, 250} : vector<int>{100, 250, 500, 1000};
+
+    for (const int number_of_nodes : sizes)
+    {
+        benchmark_result result{name, {{"number_of_nodes", to_string(number_of_nodes)}}, 1, {}};
+        for (int batch = 0; batch < max(1, options.batches / 3); batch++)
+        {
+            const auto start = chrono::steady_clock::now();
+            Simulator sim(benchmark_config(number_of_nodes));
+            result.ns_per_op.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+        }
+        report(result);
+    }
+}
+
+// stats of a finished run, with and without the per-node text files
+static void benchmark_write_node_stats(const benchmark_options& options)
+{
+    const string name = "write_node_stats_to_file";
+    if (!selected(options, name))
+        return;
+    const vector<int> sizes = options.quick ? vector<int>{10} : vector<int>{10, 30};
+
+    for (const int number_of_nodes : sizes)
+    {
+        const unique_ptr<Simulator> sim = create_simulator(benchmark_config(number_of_nodes));
+        sim->run_until(LLONG_MAX);
+        for (const bool node_files : {false, true})
+        {
+            write_node_files = node_files;
+            benchmark_result result{name, {{"number_of_nodes", to_string(number_of_nodes)},
+                                           {"node_files", node_files ? "true" : "false"}}, 1, {}};
+            for (int batch = 0; batch < max(1, options.batches / 3); batch++)
+            {
+                const auto start = chrono::steady_clock::now();
+                sim->write_node_stats_to_file();
+                result.ns_per_op.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+            }
+            report(result);
+        }
+    }
+}
+
+static void write_json(ostream& os, const string& label, const benchmark_options& options)
+{
+    const time_t now = time(nullptr);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    os << "{" << endl;
+    os << "  \"context\": {\"label\": \"" << label << "\", \"date\": \"" << date << "\", \"compiler\": \""
+        << __VERSION__ << "\", \"sha256_kernel\": \"" << sha256_kernel_name(sha256_kernel())
+        << "\", \"hardware_threads\": " << thread::hardware_concurrency() << ", \"quick\": "
+        << (options.quick ? "true" : "false") << "}," << endl;
+    os << "  \"benchmarks\": [" << endl;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const benchmark_result& result = results[i];
+        vector<double> sorted = result.ns_per_op;
+        sort(sorted.begin(), sorted.end());
+        double mean = 0;
+        for (const double ns : sorted)
+            mean += ns / static_cast<double>(sorted.size());
+
+        os << "    {\"name\": \"" << result.name << "\", \"params\": {";
+        for (size_t p = 0; p < result.params.size(); p++)
+        {
+            const string& value = result.params[p].second;
+            const bool number = !value.empty() && all_of(value.begin(), value.end(), ::isdigit);
+            os << (p > 0 ? ", " : "") << "\"" << result.params[p].first << "\": "
+                << (number || value == "true" || value == "false" ? value : "\"" + value + "\"");
+        }
+        os << "}, \"iterations\": " << result.iterations << ", \"batches\": " << sorted.size()
+            << ", \"ns_per_op\": {\"min\": " << sorted.front() << ", \"median\": " << sorted[sorted.size() / 2]
+            << ", \"mean\": " << mean << ", \"max\": " << sorted.back() << "}}"
+            << (i + 1 < results.size() ? "," : "") << endl;
+    }
+    os << "  ]" << endl;
+    os << "}" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    string output = "micro_benchmarks.json";
+    string label;
+    benchmark_options options;
+    for (int i = 1; i < argc; i++)
+    {
+        if (string(argv[i]) == "--quick") options.quick = true;
+        else if (string(argv[i]) == "--filter" && i + 1 < argc) options.filter = argv[++i];
+        else if (string(argv[i]) == "--label" && i + 1 < argc) label = argv[++i];
+        else if (argv[i][0] != '-') output = argv[i];
+        else
+        {
+            cerr << "Usage: " << argv[0] << " [output.json] [--quick] [--filter <name>] [--label <version>]" << endl;
+            return 1;
+        }
+    }
+    if (options.quick)
+        options.batches = 3;
+
+    cerr << "Micro benchmarks, median of " << options.batches << " batches" << endl;
+    benchmark_validate_and_add_block(options);
+    benchmark_mine_block(options);
+    benchmark_event_queue(options);
+    benchmark_build_network(options);
+    benchmark_write_node_stats(options);
+
+    ofstream file(output);
+    if (!file)
+    {
+        cerr << "An Error occurred while opening file!" << endl;
+        return 1;
+    }
+    write_json(file, label, options);
+    cerr << "Results written to " << output << endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+// Compares role and speed checks on random nodes through the hot node columns against the previous layout, where the
+// flags sat next to the id at the start of every Node object
+// Run: ./node_layout_benchmark [number_of_nodes ...] [--checks <n>]
+
+#include "../Simulator.h"
+#include "../PerfCounters.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// a Node of the previous layout: same size, the hot scalars directly after the id
+struct legacy_node
+{
+    int id;
+    bool fast;
+    bool malicious;
+    bool ringmaster;
+    bool currently_mining;
+    long long hashing_power;
+    int strategy;
+    char containers[sizeof(Node) - 24];
+};
+
+struct layout_result
+{
+    double ns_per_check = 0;
+    double llc_misses_per_check = -1;
+    double cycles_per_check = -1;
+    long long checksum = 0;
+};
+
+// the checks of receive_hash, send_block and the link setup: is the sender malicious, are both ends fast
+template <typename Check>
+static layout_result measure(const vector<int>& receivers, const vector<int>& senders, const PerfCounterGroup& counters,
+                             Check check)
+{
+    layout_result result;
+    perf_counts start, end;
+    counters.read(start);
+    const auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < receivers.size(); i++)
+        result.checksum += check(receivers[i], senders[i]);
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    counters.read(end);
+
+    const double checks = static_cast<double>(receivers.size());
+    result.ns_per_check = seconds * 1e9 / checks;
+    if (counters.has(PERF_LLC_MISSES))
+        result.llc_misses_per_check = static_cast<double>(end.values[PERF_LLC_MISSES] - start.values[PERF_LLC_MISSES]) / checks;
+    if (counters.has(PERF_CYCLES))
+        result.cycles_per_check = static_cast<double>(end.values[PERF_CYCLES] - start.values[PERF_CYCLES]) / checks;
+    return result;
+}
+
+static void print(const char* name, const layout_result& result)
+{
+    cerr << "    " << name << result.ns_per_check << " ns/check";
+    if (result.llc_misses_per_check >= 0)
+        cerr << ", " << result.llc_misses_per_check << " LLC misses/check";
+    if (result.cycles_per_check >= 0)
+        cerr << ", " << result.cycles_per_check << " cycles/check";
+    cerr << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    vector<int> node_counts;
+    long long checks = 10 * 1000 * 1000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (string(argv[i]) == "--checks" && i + 1 < argc)
+            checks = stoll(argv[++i]);
+        else
+            node_counts.push_back(stoi(argv[i]));
+    }
+    if (node_counts.empty())
+        node_counts = {100, 1000, 5000};
+
+    const PerfCounterGroup counters;
+    if (!counters.available())
+        cerr << "Hardware counters unavailable (" << counters.unavailable_reason() << "), reporting time only" << endl;
+
+    bool identical = true;
+    for (const int n : node_counts)
+    {
+        SimulationConfig config;
+        config.number_of_nodes = n;
+        config.percent_malicious_nodes = 20;
+        config.mean_transaction_inter_arrival_time = 100;
+        config.block_inter_arrival_time = 20 * 1000;
+        config.timer_timeout_time = 500;
+        config.initial_number_of_transactions = 0;
+        config.output_dir = "node_layout_benchmark_out";
+        const unique_ptr<Simulator> sim = create_simulator(config);
+        const Network& network = sim->network;
+
+        vector<legacy_node> legacy(n);
+        for (int i = 0; i < n; i++)
+        {
+            const Node& node = network.nodes[i];
+            legacy[i].id = node.id;
+            legacy[i].fast = node.fast();
+            legacy[i].malicious = node.malicious();
+            legacy[i].ringmaster = node.ringmaster();
+            legacy[i].currently_mining = node.currently_mining();
+            legacy[i].hashing_power = node.hashing_power();
+            legacy[i].strategy = node.strategy();
+        }
+
+        // receiver and sender of every check drawn uniformly, like the destinations of the event queue
+        RandomStream rng(config.seed, RNG_NO_NODE, RNG_TOPOLOGY);
+        vector<int> receivers(checks), senders(checks);
+        for (long long i = 0; i < checks; i++)
+        {
+            receivers[i] = uniform_distribution(rng, 0, n - 1);
+            senders[i] = uniform_distribution(rng, 0, n - 1);
+        }
+
+        // the receiver's own flags come from its object or column, the sender's role and speed from the table
+        const layout_result old_layout = measure(receivers, senders, counters, [&legacy](const int r, const int s)
+        {
+            const legacy_node& receiver = legacy[r];
+            return (receiver.malicious && legacy[s].malicious) + (receiver.fast && legacy[s].fast) * 2;
+        });
+        const node_columns& columns = network.columns;
+        const layout_result hot_columns = measure(receivers, senders, counters, [&columns](const int r, const int s)
+        {
+            return (columns.malicious[r] && columns.malicious[s]) + (columns.fast[r] && columns.fast[s]) * 2;
+        });
+        identical = identical && old_layout.checksum == hot_columns.checksum;
+
+        cerr << "  " << n << " nodes, " << checks << " checks, Node " << sizeof(Node) << " bytes" << endl;
+        print("Node objects: ", old_layout);
+        print("hot columns:  ", hot_columns);
+    }
+    cerr << "  checks identical: " << (identical ? "yes" : "NO") << endl;
+    return identical ? 0 : 1;
+}
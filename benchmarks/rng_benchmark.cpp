@@ -0,0 +1,87 @@
+// Compares the cost per variate of the random number generation used on the event hot paths
+// Run: ./rng_benchmark [draws]
+
+#include "../RandomStream.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+// previous implementation: mt19937 shared by all draws and a distribution constructed per call
+static int mt19937_exponential(mt19937& generator, const double mean)
+{
+    std::exponential_distribution<double> distribution(1.0 / mean);
+    return static_cast<int>(distribution(generator));
+}
+
+static int mt19937_uniform(mt19937& generator, const int min, const int max)
+{
+    std::uniform_int_distribution<int> distribution(min, max);
+    return distribution(generator);
+}
+
+// one Philox block per four words and a libm log per variate, without batching
+struct scalar_philox
+{
+    uint32_t key[2] = {911, 0};
+    uint64_t block = 0;
+    uint32_t buffer[4] = {};
+    int position = 4;
+
+    uint32_t next_u32()
+    {
+        if (position == 4)
+        {
+            const uint32_t counter[4] = {static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32), 0, 1};
+            RandomStream::philox(counter, key, buffer);
+            block++;
+            position = 0;
+        }
+        return buffer[position++];
+    }
+
+    int exponential(const double mean)
+    {
+        const uint64_t k = (static_cast<uint64_t>(next_u32() >> 5) << 26) | (next_u32() >> 6);
+        return static_cast<int>(-mean * log1p(-static_cast<double>(k) * (1.0 / 9007199254740992.0)));
+    }
+};
+
+template <typename F>
+static void run(const string& name, const long long draws, F draw)
+{
+    long long checksum = 0;
+    const auto start = chrono::steady_clock::now();
+    for (long long i = 0; i < draws; i++)
+        checksum += draw(i);
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << ": " << seconds * 1e9 / static_cast<double>(draws) << " ns/variate (checksum " << checksum
+        << ")" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    const long long draws = argc > 1 ? stoll(argv[1]) : 20000000;
+    // queuing delay means of a slow and a fast link
+    const double means[2] = {96.0 / 5000.0 * 1000, 96.0 / 100000.0 * 1000};
+
+    cout << "Exponential variates" << endl;
+    mt19937 generator(911);
+    run("  mt19937 + std::exponential_distribution", draws,
+        [&](const long long i) { return mt19937_exponential(generator, means[i & 1]); });
+    scalar_philox scalar;
+    run("  scalar Philox + log1p", draws, [&](const long long i) { return scalar.exponential(means[i & 1]); });
+    RandomStream stream(911, 0, RNG_LINK_LATENCY);
+    run("  batched RandomStream", draws, [&](const long long i) { return stream.exponential(means[i & 1]); });
+
+    cout << "Uniform variates" << endl;
+    run("  mt19937 + std::uniform_int_distribution", draws,
+        [&](const long long) { return mt19937_uniform(generator, 10, 500); });
+    RandomStream uniform_stream(911, 0, RNG_LINK_LATENCY);
+    run("  batched RandomStream", draws, [&](const long long) { return uniform_stream.uniform(10, 500); });
+    return 0;
+}
@@ -0,0 +1,78 @@
+// Compares the per-node strategy policies against evaluating every strategy check per event
+// Run: ./strategy_benchmark <number_of_nodes> <percent_malicious> <mean_transaction_inter_arrival_time> <block_inter_arrival_time> <timeout time> [repeats] [--eclipse] [--stubborn]
+
+#include "../Simulator.h"
+#include "../Strategy.h"
+
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// simulation time of one run without building the network and writing stats
+static double run(SimulationConfig config, const bool branching, node_summary& ringmaster)
+{
+    config.branching_strategies = branching;
+    const unique_ptr<Simulator> sim = create_simulator(config);
+    const auto start = chrono::steady_clock::now();
+    sim->run_until(LLONG_MAX);
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    ringmaster = sim->network.nodes[sim->network.ringmaster_node_id].summarize_chain();
+    return seconds;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 6)
+    {
+        cerr << "Usage: " << argv[0] << " <number_of_nodes> <percent_malicious> <mean_transaction_inter_arrival_time> "
+            "<block_inter_arrival_time> <timeout time> [repeats] [--eclipse] [--stubborn]" << endl;
+        return 1;
+    }
+    SimulationConfig config;
+    config.number_of_nodes = stoi(argv[1]);
+    config.percent_malicious_nodes = stoi(argv[2]);
+    config.mean_transaction_inter_arrival_time = stoi(argv[3]);
+    config.block_inter_arrival_time = stoi(argv[4]) * 1000;
+    config.timer_timeout_time = stoi(argv[5]);
+    config.output_dir = "strategy_benchmark_out";
+    int repeats = 3;
+    for (int i = 6; i < argc; i++)
+    {
+        if (string(argv[i]) == "--eclipse") config.eclipse_attack = true;
+        else if (string(argv[i]) == "--stubborn") config.release_strategy = RELEASE_LEAD_STUBBORN;
+        else repeats = stoi(argv[i]);
+    }
+    if (const string error = config.validate(); !error.empty())
+    {
+        cerr << error << endl;
+        return 1;
+    }
+
+    // runs alternate so both variants see the same machine load, the simulators print to stdout
+    double best[2] = {1e300, 1e300};
+    double total[2] = {0, 0};
+    bool identical = true;
+    for (int r = 0; r < repeats; r++)
+    {
+        node_summary summaries[2];
+        for (int branching = 0; branching < 2; branching++)
+        {
+            const double seconds = run(config, branching == 1, summaries[branching]);
+            best[branching] = min(best[branching], seconds);
+            total[branching] += seconds;
+        }
+        identical = identical && summaries[0].blocks_mined == summaries[1].blocks_mined &&
+            summaries[0].blocks_mined_in_longest_chain == summaries[1].blocks_mined_in_longest_chain &&
+            summaries[0].blocks_in_longest_chain == summaries[1].blocks_in_longest_chain;
+    }
+
+    cerr << "Event loop time over " << repeats << " runs (best / mean)" << endl;
+    cerr << "  strategy policies:   " << best[0] << " s / " << total[0] / repeats << " s" << endl;
+    cerr << "  runtime branching:   " << best[1] << " s / " << total[1] / repeats << " s" << endl;
+    cerr << "  speedup of policies: " << best[1] / best[0] << "x" << endl;
+    cerr << "  ringmaster results identical: " << (identical ? "yes" : "NO") << endl;
+    return identical ? 0 : 1;
+}
@@ -4,110 +4,276 @@
 
 #include "Network.h"
 #include "Simulator.h"
+#include "Branch.h"
+#include "Scaling.h"
 #include "Event.h"
+#include "Strategy.h"
 #include <cstdlib>
 #include <fstream>
+#include <chrono>
 
-// experiment constants
-int initial_bitcoin = 1000;
-int initial_number_of_transactions = 5000;
-int propagation_delay_min = 10;
-int propagation_delay_max = 500;
-int propagation_delay_malicious_min = 1;
-int propagation_delay_malicious_max = 10;
-int transaction_amount_min = 5;
-int transaction_amount_max = 20;
-int queuing_delay_constant = 96;  // 96000 per second
-int transaction_size = 1024 * 8;
-int hash_size = 64*8;
-int get_message_size = 64*8;
-int mining_reward = 50;
-int maximum_retries = 100;
-
-// experiment parameters
-int number_of_nodes;
-int percent_malicious_nodes;
-int mean_transaction_inter_arrival_time;
-int block_inter_arrival_time;
-int timer_timeout_time;
-string output_dir = "Output";
-
-// Simulation variables
-long long simulation_time = 0;
-EQ event_queue;
-unsigned int global_seed = 911;
-Logger l;
-bool selfish_mining = true;
-bool eclipse_attack = false;
-bool mitigation = false;
-int global_send_private_counter =0;
+// Experiment constants are defaults of SimulationConfig in Simulator.h
 
+static void print_usage(const char* program)
+{
+    cerr << "Usage: " << program <<
+        " <number_of_nodes> <percent_malicious> <mean_transaction_inter_arrival_time> <block_inter_arrival_time> <timeout time> <output_dir> [--eclipse] [--mitigation] [--no-selfish-mining] [--stubborn] [--node-files] [--shared-ledgers] [--finality-depth <blocks>] [--transactions <n>] [--stats-interval <ms>] [--memory-interval <ms>] [--seed <seed>] [--warmup <ms> <snapshot>] [--restore <snapshot>] [--branch-at <ms> <branch_file>] [--proof-of-work <hashes_per_block>] [--pow-threads <n>] [--profile] [--profile-interval <ms>] [--perf-counters]"
+        << endl;
+    cerr << "       " << program << " --sweep <sweep_file> <output_dir> [--threads <n>]" << endl;
+    cerr << "       " << program << " --scaling <grid_file> <output_dir> [--repeats <n>]" << endl;
+    cerr << "  mean_transaction_inter_arrival_time: milli-seconds" << endl;
+    cerr << "  block_inter_arrival_time: seconds" << endl;
+    cerr << "  timeout time: milli-seconds" << endl;
+    cerr << "  output_dir" << endl;
+    cerr << "  [--eclipse]: optional argument to enable eclipse attack" << endl;
+    cerr << "  [--mitigation]: optional argument to drop peers that repeatedly fail to deliver blocks" << endl;
+    cerr << "  [--no-selfish-mining]: optional argument to let the ringmaster publish its blocks like honest nodes" << endl;
+    cerr << "  [--stubborn]: optional argument to let the ringmaster follow the lead-stubborn strategy instead of SM1" << endl;
+    cerr << "  [--node-files]: optional argument to also write one text stats file per node" << endl;
+    cerr << "  [--shared-ledgers]: optional argument to let honest nodes share one ledger per validated block" << endl;
+    cerr << "  [--finality-depth <blocks>]: optional argument to prune forks and dedup state of blocks <blocks> below the tip" << endl;
+    cerr << "  [--transactions <n>]: optional argument to change the number of transactions created over the run (5000)" << endl;
+    cerr << "  [--stats-interval <ms>]: optional argument to sample chain stats of all nodes every <ms> of simulation time" << endl;
+    cerr << "  [--memory-interval <ms>]: optional argument to sample the memory accounting every <ms> of simulation time" << endl;
+    cerr << "  [--seed <seed>]: optional argument to change the random seed" << endl;
+    cerr << "  [--warmup <ms> <snapshot>]: runs until <ms> of simulation time, saves the state to <snapshot> and stops" << endl;
+    cerr << "  [--restore <snapshot>]: continues a warmed up run, the parameters must match, attack toggles may differ" << endl;
+    cerr << "  [--branch-at <ms> <branch_file>]: runs until <ms>, then forks one child per line of branch_file" << endl;
+    cerr << "           line format: [--eclipse] [--mitigation] [--selfish-mining | --no-selfish-mining] [--stubborn] [--seed <seed>]" << endl;
+    cerr << "  [--proof-of-work <hashes_per_block>]: optional argument to mine by nonce search against a target met once per <hashes_per_block> hashes" << endl;
+    cerr << "  [--pow-threads <n>]: optional argument to set the nonce search workers, default all hardware threads" << endl;
+    cerr << "  [--profile]: optional argument to time every event handler and write Temp_files/profile.json and csv reports" << endl;
+    cerr << "  [--profile-interval <ms>]: optional argument to sample the event queue depth every <ms> of simulation time, default 1000" << endl;
+    cerr << "  [--perf-counters]: optional argument to profile with cycles, instructions, LLC and branch misses per event type and node method" << endl;
+    cerr << "  --sweep: runs every configuration line of sweep_file concurrently in this process" << endl;
+    cerr << "           line format: <number_of_nodes> <percent_malicious> <mean_transaction_inter_arrival_time> <block_inter_arrival_time> <timeout time> [--eclipse] [--mitigation] [--no-selfish-mining] [--stubborn] [--restore <snapshot>]" << endl;
+    cerr << "  --scaling: runs every combination of the parameter values in grid_file one after the other and records their cost" << endl;
+    cerr << "           line format: nodes | malicious | transaction_interval | block_interval | timeout | eclipse followed by its values" << endl;
+}
 
-int main(int argc, char* argv[])
+// runs all configurations of a sweep file on a thread pool and writes one results table
+static int run_sweep_mode(int argc, char* argv[])
 {
-    if (argc < 7 || argc > 8)
+    if (argc < 4)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const string sweep_file = argv[2];
+    const string sweep_output_dir = argv[3];
+    unsigned int num_threads = 0;
+    for (int i = 4; i < argc; i++)
+    {
+        if (string(argv[i]) == "--threads" && i + 1 < argc)
+            num_threads = stoi(argv[++i]);
+        else
+        {
+            cerr << "Unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+
+    vector<SimulationConfig> configs;
+    try
+    {
+        configs = read_sweep_file(sweep_file, SimulationConfig(), sweep_output_dir);
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    fs::create_directories(sweep_output_dir);
+    cout << "Running " << configs.size() << " configurations" << endl;
+    const vector<sweep_result> results = run_sweep(configs, num_threads);
+    write_sweep_results(results, sweep_output_dir + "/sweep_results.csv");
+    cout << "Sweep results written to " << sweep_output_dir + "/sweep_results.csv" << endl;
+    return 0;
+}
+
+// runs every point of a scaling grid in turn and writes their startup, event loop, stats, memory and output costs
+static int run_scaling_mode(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const string grid_file = argv[2];
+    const string scaling_output_dir = argv[3];
+    int repeats = 1;
+    for (int i = 4; i < argc; i++)
+    {
+        if (string(argv[i]) == "--repeats" && i + 1 < argc)
+            repeats = stoi(argv[++i]);
+        else
+        {
+            cerr << "Unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+    if (repeats < 1)
+    {
+        cerr << "--repeats must be at least 1" << endl;
+        return 1;
+    }
+
+    vector<SimulationConfig> configs;
+    try
+    {
+        // the parameters a grid does not list keep the defaults of a medium sized run
+        SimulationConfig base;
+        base.number_of_nodes = 50;
+        base.percent_malicious_nodes = 20;
+        base.mean_transaction_inter_arrival_time = 100;
+        base.block_inter_arrival_time = 20 * 1000;
+        base.timer_timeout_time = 500;
+        configs = read_scaling_grid(grid_file, base, scaling_output_dir);
+    }
+    catch (const exception& e)
     {
-        cerr << "Usage: " << argv[0] <<
-            " <number_of_nodes> <percent_malicious> <mean_transaction_inter_arrival_time> <block_inter_arrival_time> <timeout time> <output_dir> [--eclipse]" 
-            << endl;
-        cerr << "  mean_transaction_inter_arrival_time: milli-seconds" << endl;
-        cerr << "  block_inter_arrival_time: seconds" << endl;
-        cerr << "  timeout time: milli-seconds" << endl;
-        cerr << "  output_dir" << endl;
-        cerr << "  [--eclipse]: optional argument to enable eclipse attack" << endl;
+        cerr << e.what() << endl;
         return 1;
     }
 
-    number_of_nodes = stoi(argv[1]);
-    percent_malicious_nodes = stoi(argv[2]);
-    mean_transaction_inter_arrival_time = stoi(argv[3]);
-    block_inter_arrival_time = stoi(argv[4])* 1000 ;
-    timer_timeout_time = stoi(argv[5]);
-    output_dir = argv[6];
+    fs::create_directories(scaling_output_dir);
+    cout << "Running " << configs.size() << " grid points " << repeats << " time(s) each" << endl;
+    const vector<scaling_result> results = run_scaling(configs, repeats);
+    write_scaling_results(results, scaling_output_dir + "/scaling_results.csv");
+    cout << "Scaling results written to " << scaling_output_dir + "/scaling_results.csv" << endl;
+    return 0;
+}
+
+// warms up once, then runs every variant of the branch file in a forked child
+static int run_branch_mode(Simulator& sim, const SimulationConfig& config, const long long branch_time,
+                           const vector<SimulationConfig>& variants)
+{
+    sim.run_until(branch_time);
+    const auto start = chrono::steady_clock::now();
+    const vector<sweep_result> results = run_fork_branches(sim, variants, 0);
+    cout << " " << variants.size() << " branches from time " << simulation_time << " ms took "
+        << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
 
-    l.setOutputDir(output_dir);
+    write_sweep_results(results, config.output_dir + "/branch_results.csv");
+    cout << "Branch results written to " << config.output_dir + "/branch_results.csv" << endl;
+    return 0;
+}
 
-    if (argc == 8 && string(argv[7]) == "--eclipse")
-        eclipse_attack = true;
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && string(argv[1]) == "--sweep")
+        return run_sweep_mode(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--scaling")
+        return run_scaling_mode(argc, argv);
 
-    if (number_of_nodes < 1 ||  percent_malicious_nodes < 0 || percent_malicious_nodes > 100
-        || mean_transaction_inter_arrival_time <= 0 || block_inter_arrival_time <= 0 || timer_timeout_time <= 0)
+    if (argc < 7)
     {
-        cerr << "Invalid argument values" << endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    SimulationConfig config;
+    long long warmup_time = -1;
+    string warmup_snapshot;
+    long long branch_time = -1;
+    string branch_file;
+    config.number_of_nodes = stoi(argv[1]);
+    config.percent_malicious_nodes = stoi(argv[2]);
+    config.mean_transaction_inter_arrival_time = stoi(argv[3]);
+    config.block_inter_arrival_time = stoi(argv[4])* 1000 ;
+    config.timer_timeout_time = stoi(argv[5]);
+    config.output_dir = argv[6];
+
+    for (int i = 7; i < argc; i++)
+    {
+        if (string(argv[i]) == "--eclipse")
+            config.eclipse_attack = true;
+        else if (string(argv[i]) == "--mitigation")
+            config.mitigation = true;
+        else if (string(argv[i]) == "--no-selfish-mining")
+            config.selfish_mining = false;
+        else if (string(argv[i]) == "--stubborn")
+            config.release_strategy = RELEASE_LEAD_STUBBORN;
+        else if (string(argv[i]) == "--node-files")
+            config.write_node_files = true;
+        else if (string(argv[i]) == "--shared-ledgers")
+            config.shared_ledgers = true;
+        else if (string(argv[i]) == "--finality-depth" && i + 1 < argc)
+            config.finality_depth = stoll(argv[++i]);
+        else if (string(argv[i]) == "--transactions" && i + 1 < argc)
+            config.initial_number_of_transactions = stoi(argv[++i]);
+        else if (string(argv[i]) == "--stats-interval" && i + 1 < argc)
+            config.stats_sample_interval = stoll(argv[++i]);
+        else if (string(argv[i]) == "--memory-interval" && i + 1 < argc)
+            config.memory_sample_interval = stoll(argv[++i]);
+        else if (string(argv[i]) == "--seed" && i + 1 < argc)
+            config.seed = static_cast<unsigned int>(stoul(argv[++i]));
+        else if (string(argv[i]) == "--warmup" && i + 2 < argc)
+        {
+            warmup_time = stoll(argv[++i]);
+            warmup_snapshot = argv[++i];
+        }
+        else if (string(argv[i]) == "--branch-at" && i + 2 < argc)
+        {
+            branch_time = stoll(argv[++i]);
+            branch_file = argv[++i];
+        }
+        else if (string(argv[i]) == "--restore" && i + 1 < argc)
+            config.restore_path = argv[++i];
+        else if (string(argv[i]) == "--proof-of-work" && i + 1 < argc)
+        {
+            config.proof_of_work = true;
+            config.pow_hashes_per_block = stoll(argv[++i]);
+        }
+        else if (string(argv[i]) == "--pow-threads" && i + 1 < argc)
+            config.pow_threads = stoi(argv[++i]);
+        else if (string(argv[i]) == "--profile")
+            config.profile = true;
+        else if (string(argv[i]) == "--profile-interval" && i + 1 < argc)
+            config.profile_sample_interval = stoll(argv[++i]);
+        else if (string(argv[i]) == "--perf-counters")
+            config.profile = config.profile_counters = true;
+        else
+        {
+            cerr << "Unknown option " << argv[i] << endl;
+            return 1;
+        }
+    }
+
+    if (const string error = config.validate(); !error.empty())
+    {
+        cerr << error << endl;
         return 1;
     }
 
     // Print experiment configuration
-    cout << "----------------------------------------------------------------------" << endl;
-    cout << "Simulation Configuration:" << endl;
-    cout << "  Number of Nodes: " << number_of_nodes << endl;
-    cout << "  Percent Malicious: " << percent_malicious_nodes << "%" << endl;
-    cout << "  Mean Transaction Inter-Arrival Time: " << mean_transaction_inter_arrival_time << " ms" << endl;
-    cout << "  Block Inter-Arrival Time: " << block_inter_arrival_time << " ms" << endl;
-    cout << "  Timeout Time: " << timer_timeout_time << " ms" << endl;
-
-    cout << "  Propagation Delay (Min-Max): " << propagation_delay_min << " - " << propagation_delay_max << " ms" <<
-        endl;
-    cout << "  Propagation Delay Malicious (Min-Max): " << propagation_delay_malicious_min << " - " << propagation_delay_malicious_max << " ms" << endl;
-    cout << "  Queuing Delay Constant: " << queuing_delay_constant << " bits/sec" << endl;
-    cout << "  Transaction Size: " << transaction_size << " bits" << endl;
-    cout << "  Hash size: " << hash_size << endl;
-    cout << "  Get message size: " << get_message_size << endl;
-    cout << "  Mining reward: " << mining_reward << " bitcoins" << endl;
-    cout << "  Initial Bitcoins with each node: " << initial_bitcoin << endl;
-    cout << "  Initial Number of Transactions: " << initial_number_of_transactions << endl;
-    cout << "  Transaction Amount (Min-Max): " << transaction_amount_min << " - " << transaction_amount_max <<
-        " bitcoins" << endl;
-    cout << "  Eclipse Attack: " << (eclipse_attack ? "Enabled" : "Disabled") << endl;
-    cout << "  Selfish Mining: " << (selfish_mining ? "Enabled" : "Disabled") << endl;
-    cout << "  Output Directory: " << output_dir << endl;
-    cout << "----------------------------------------------------------------------" << endl;
-    srand(global_seed);
+    config.print(cout);
 
     // Create and start simulation
-    Simulator sim;
-    sim.initialize();
-    sim.start();
+    unique_ptr<Simulator> sim;
+    vector<SimulationConfig> variants;
+    try
+    {
+        if (branch_time >= 0)
+            variants = read_branch_file(branch_file, config, config.output_dir);
+        sim = create_simulator(config);
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    if (warmup_time >= 0)
+    {
+        sim->run_until(warmup_time);
+        sim->save_snapshot(warmup_snapshot);
+        return 0;
+    }
+    if (branch_time >= 0)
+        return run_branch_mode(*sim, config, branch_time, variants);
+    sim->start();
 
     return 0;
 }
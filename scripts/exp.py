@@ -8,47 +8,15 @@ import subprocess
 import itertools
 from tqdm import tqdm
 import math
+from results_reader import parse_node_results, get_ringmaster_node
 
 
-def parse_node_file(file_path):
-    """Parses the node log file and extracts relevant blockchain statistics."""
-    data = {
-        "blocks_mined_total": 0.0,
-        "blocks_mined_in_longest_chain": 0.0,
-        "Fraction_of_blocks_mined_in_longest_chain": 0.0,
-    }
-    
-    with open(file_path, 'r') as f:
-        content = f.readlines()
-    
-    for line in content:
-        if line.startswith("Blocks mined: "):
-            data["blocks_mined_total"] = float(line.split(": ")[1])
-        elif line.startswith("Blocks mined in longest chain: "):
-            data["blocks_mined_in_longest_chain"] = float(line.split(": ")[1])
-        elif line.startswith("Fraction of blocks mined in longest chain: "):
-            data["Fraction_of_blocks_mined_in_longest_chain"] = float(line.split(": ")[1])
-        elif line.strip() == "Blockchain:":
-            break
-    
-    return data
-
 def compute_ratios(node_data):
     """Computes the required ratios."""
     ratio_1 = node_data["Fraction_of_blocks_mined_in_longest_chain"]
     ratio_2 = (node_data["blocks_mined_in_longest_chain"] / node_data["blocks_mined_total"]) if node_data["blocks_mined_total"] > 0 else 0
     return ratio_1, ratio_2
 
-def get_ringmaster_node(node_properties_filepath):
-    """Extracts the ringmaster node ID from the CSV file."""
-    with open(node_properties_filepath, 'r') as f:
-        reader = csv.DictReader(f)
-        for row in reader:
-            if int(row['ringmaster']) == 1:
-                return int(row['node_id'])
-    print("Error: No ringmaster node found!")
-    return None
-
 def main():
     """ Run as: python scripts/exp.py and relax!"""
 
@@ -64,8 +32,7 @@ def main():
 
     project_root = os.getcwd()
     output_folder = os.path.join(project_root, "Output")
-    node_properties_filepath = os.path.join(output_folder, "Temp_files", "all_node_details.csv")
-    input_folder = os.path.join(output_folder, "Node_Files")
+    results_filepath = os.path.join(output_folder, "results.bin")
     
     # Experiment folder setup
     experiment_root = os.path.join(project_root, "experiments")
@@ -123,14 +90,11 @@ def main():
         time.sleep(3)
 
         # Parse results
-        ringmaster_node = get_ringmaster_node(node_properties_filepath)
-        if ringmaster_node is None:
-            continue
-        
-
-        input_file = os.path.join(input_folder, f"Node_{ringmaster_node}.txt")
-        if os.path.exists(input_file):
-            node_data = parse_node_file(input_file)
+        if os.path.exists(results_filepath):
+            ringmaster_node = get_ringmaster_node(results_filepath)
+            if ringmaster_node is None:
+                continue
+            node_data = parse_node_results(results_filepath, ringmaster_node)
             ratio_1, ratio_2 = compute_ratios(node_data)
         else:
             ratio_1, ratio_2 = 'Nan', 'Nan'
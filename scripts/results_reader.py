@@ -0,0 +1,112 @@
+import struct
+import numpy as np
+
+# Reader for the consolidated results file (Output/results.bin) written by the simulator.
+# Layout is documented in ResultsFile.h
+
+HEADER = struct.Struct("<8sIIQQQQ")
+COLUMN_DESCRIPTOR = struct.Struct("<32sc7x")
+BLOCK_DTYPE = np.dtype([
+    ("block_id", "<i8"),
+    ("parent_block_id", "<i8"),
+    ("creation_time", "<i8"),
+    ("num_transactions", "<i8"),
+    ("miner", "<i4"),
+    ("reserved", "<i4"),
+])
+INDEX_DTYPE = np.dtype([("offset", "<u8"), ("length", "<u8")])
+
+
+def read_header(f):
+    """Returns the header fields of an open results file as a dict."""
+    f.seek(0)
+    magic, version, number_of_nodes, number_of_blocks, block_table_offset, node_table_offset, \
+        membership_index_offset = HEADER.unpack(f.read(HEADER.size))
+    if magic != b"P2PRSLT\0":
+        raise ValueError("not a results file")
+    return {
+        "version": version,
+        "number_of_nodes": number_of_nodes,
+        "number_of_blocks": number_of_blocks,
+        "block_table_offset": block_table_offset,
+        "node_table_offset": node_table_offset,
+        "membership_index_offset": membership_index_offset,
+    }
+
+
+def read_node_table(file_path):
+    """Returns the per-node summary columns as {column name: numpy array indexed by node id}."""
+    with open(file_path, "rb") as f:
+        header = read_header(f)
+        n = header["number_of_nodes"]
+        f.seek(header["node_table_offset"])
+        number_of_columns, _ = struct.unpack("<II", f.read(8))
+        descriptors = []
+        for _ in range(number_of_columns):
+            name, type_code = COLUMN_DESCRIPTOR.unpack(f.read(COLUMN_DESCRIPTOR.size))
+            descriptors.append((name.rstrip(b"\0").decode(), "<i8" if type_code == b"i" else "<f8"))
+        columns = {}
+        for name, dtype in descriptors:
+            columns[name] = np.frombuffer(f.read(8 * n), dtype=dtype)
+    return columns
+
+
+def read_node_summary(file_path, node_id):
+    """Returns the summary columns of a single node as a dict."""
+    return {name: values[node_id].item() for name, values in read_node_table(file_path).items()}
+
+
+def read_block_table(file_path):
+    """Returns the deduplicated global block table as a numpy structured array sorted by block id."""
+    with open(file_path, "rb") as f:
+        header = read_header(f)
+        f.seek(header["block_table_offset"])
+        return np.frombuffer(f.read(BLOCK_DTYPE.itemsize * header["number_of_blocks"]), dtype=BLOCK_DTYPE)
+
+
+def read_node_blocks(file_path, node_id):
+    """Returns the blocks in the tree of a single node, with first_seen_time and part_of_longest columns."""
+    with open(file_path, "rb") as f:
+        header = read_header(f)
+        b = header["number_of_blocks"]
+        f.seek(header["membership_index_offset"] + INDEX_DTYPE.itemsize * node_id)
+        entry = np.frombuffer(f.read(INDEX_DTYPE.itemsize), dtype=INDEX_DTYPE)[0]
+        f.seek(int(entry["offset"]))
+        section = f.read(int(entry["length"]))
+
+        words = (b + 63) // 64
+        in_tree = np.unpackbits(np.frombuffer(section[:8 * words], dtype=np.uint8), bitorder="little")[:b].astype(bool)
+        in_longest = np.unpackbits(np.frombuffer(section[8 * words:16 * words], dtype=np.uint8),
+                                   bitorder="little")[:b].astype(bool)
+        first_seen = np.frombuffer(section[16 * words:], dtype="<i8")
+
+        f.seek(header["block_table_offset"])
+        blocks = np.frombuffer(f.read(BLOCK_DTYPE.itemsize * b), dtype=BLOCK_DTYPE)
+
+    return {
+        "block_id": blocks["block_id"][in_tree],
+        "parent_block_id": blocks["parent_block_id"][in_tree],
+        "num_transactions": blocks["num_transactions"][in_tree],
+        "miner": blocks["miner"][in_tree],
+        "first_seen_time": first_seen,
+        "part_of_longest": in_longest[in_tree],
+    }
+
+
+def get_ringmaster_node(file_path):
+    """Returns the id of the ringmaster node or None."""
+    ringmaster = np.flatnonzero(read_node_table(file_path)["ringmaster"])
+    if len(ringmaster) == 0:
+        print("Error: No ringmaster node found!")
+        return None
+    return int(ringmaster[0])
+
+
+def parse_node_results(file_path, node_id):
+    """Extracts the blockchain statistics used by the experiment scripts for a single node."""
+    summary = read_node_summary(file_path, node_id)
+    return {
+        "blocks_mined_total": float(summary["blocks_mined"]),
+        "blocks_mined_in_longest_chain": float(summary["blocks_mined_in_longest_chain"]),
+        "Fraction_of_blocks_mined_in_longest_chain": summary["fraction_mined_in_longest"],
+    }
@@ -6,32 +6,10 @@ import time
 import sys
 import shutil
 import subprocess
+from results_reader import parse_node_results, get_ringmaster_node
 
 # example run: python3 scripts/stats.py 10 10 40 10 1000 50 1000 2000 200 --eclipse
 
-def parse_node_file(file_path):
-    """Parses the node log file and extracts relevant blockchain statistics."""
-    data = {
-        "blocks_mined_total": 0.0,
-        "blocks_mined_in_longest_chain": 0.0,
-        "Fraction_of_blocks_mined_in_longest_chain": 0.0,
-    }
-    
-    with open(file_path, 'r') as f:
-        content = f.readlines()
-    
-    for line in content:
-        if line.startswith("Blocks mined: "):
-            data["blocks_mined_total"] = float(line.split(": ")[1])
-        elif line.startswith("Blocks mined in longest chain: "):
-            data["blocks_mined_in_longest_chain"] = float(line.split(": ")[1])
-        elif line.startswith("Fraction of blocks mined in longest chain: "):
-            data["Fraction_of_blocks_mined_in_longest_chain"] = float(line.split(": ")[1])
-        elif line.strip() == "Blockchain:":
-            break
-    
-    return data
-
 def compute_ratios(node_data):
     """Computes the required ratios."""
 
@@ -39,21 +17,6 @@ def compute_ratios(node_data):
     ratio_2 = (node_data["blocks_mined_in_longest_chain"] / node_data["blocks_mined_total"]) if node_data["blocks_mined_total"] > 0 else 0
     return ratio_1, ratio_2
 
-def get_ringmaster_node(node_properties_filepath):
-    ringmaster_node = None
-    # extract ringmaster node 
-    with open(node_properties_filepath, 'r') as f:
-        reader = csv.DictReader(f)
-        for row in reader:
-            node_id = int(row['node_id'])
-            if int(row['ringmaster']) == 1:
-                ringmaster_node = node_id
-    
-    if ringmaster_node is None:
-        print("Error: No ringmaster node found!")
-        return
-    return ringmaster_node
-
 def main():
 
     if len(sys.argv) < 10:
@@ -75,8 +38,7 @@ def main():
 
     project_root = os.getcwd()
     output_folder = os.path.join(project_root, "Output")
-    node_properties_filepath = os.path.join(project_root, "Output/Temp_files", "all_node_details.csv")
-    input_folder = os.path.join(project_root, "Output/Node_Files")
+    results_filepath = os.path.join(project_root, "Output", "results.bin")
     
     # experiment folder
     experiment_root = os.path.join(project_root, "experiments")
@@ -86,7 +48,6 @@ def main():
     os.makedirs(experiment_subfolder, exist_ok=True)
 
 
-    # print(input_file)
     malicious_percentages = list(range(percent_malicious_nodes_start, percent_malicious_nodes_end + 1, percent_malicious_nodes_step_size))
     timeout_times = list(range(timer_timeout_time_start, timer_timeout_time_end + 1, timer_timeout_time_step_size))
     
@@ -126,13 +87,8 @@ def main():
             # now 
             # time.sleep(1000)
             print("main execution completed")
-            ringmaster_node =get_ringmaster_node(node_properties_filepath)
-            input_file = [os.path.join(input_folder, f"Node_{ringmaster_node}.txt")]
-
-
-            if os.path.exists(input_folder):
-                node_data = parse_node_file(input_file[0])
-                # print(node_data)
+            ringmaster_node =get_ringmaster_node(results_filepath)
+            node_data = parse_node_results(results_filepath, ringmaster_node)
             
             ratio_1, ratio_2 = compute_ratios(node_data)
             results[(percent, Tt)] = (ratio_1, ratio_2)
@@ -3,31 +3,25 @@
 #include <ctime>
 #include <algorithm>
 #include <stack>
-#include <random>
 #include <filesystem>
-#include <openssl/evp.h>
 #include <sstream>
 
 
 
 // return random number from uniform distribution
-int uniform_distribution(const int min, const int max)
+int uniform_distribution(RandomStream& stream, const int min, const int max)
 {
-    static std::mt19937 generator(global_seed); // Mersenne Twister generator
-    std::uniform_int_distribution<int> distribution(min, max);
-    return distribution(generator);
+    return stream.uniform(min, max);
 }
 
 // returns discrete event timings from exponential distribution
-int exponential_distribution(double mean)
+int exponential_distribution(RandomStream& stream, double mean)
 {
-    static std::mt19937 generator(global_seed); // Mersenne Twister generator
-    std::exponential_distribution<double> distribution(1.0 / mean);
-    return static_cast<int>(distribution(generator));
+    return stream.exponential(mean);
 }
 
 // returns percentage of nodes from given 0 to n-1 nodes
-vector<int> choose_percent(const int n, const double percent)
+vector<int> choose_percent(RandomStream& stream, const int n, const double percent)
 {
     const int num_to_select = static_cast<int>(n * percent);
     vector<int> selected_nodes;
@@ -36,7 +30,7 @@ vector<int> choose_percent(const int n, const double percent)
     // incrementally choose nodes without repetition from uniform distribution
     while (selected_nodes.size() < num_to_select)
     {
-        int candidate = uniform_distribution(0, n - 1);
+        int candidate = uniform_distribution(stream, 0, n - 1);
         if (find(selected_nodes.begin(), selected_nodes.end(), candidate) == selected_nodes.end())
             selected_nodes.push_back(candidate);
     }
@@ -44,7 +38,7 @@ vector<int> choose_percent(const int n, const double percent)
 }
 
 // return k node ids as vector randomly from |total nodes| - |excluded nodes|
-vector<int> choose_neighbours(int n, int k, vector<int> excluded)
+vector<int> choose_neighbours(RandomStream& stream, int n, int k, vector<int> excluded)
 {
     vector<int> selected_nodes;
     selected_nodes.reserve(k);
@@ -52,7 +46,7 @@ vector<int> choose_neighbours(int n, int k, vector<int> excluded)
     // incrementally choose nodes without repetition from uniform distribution
     while (selected_nodes.size() < k)
     {
-        int candidate = uniform_distribution(0, n - 1);
+        int candidate = uniform_distribution(stream, 0, n - 1);
         if (find(excluded.begin(), excluded.end(), candidate) == excluded.end() &&
             find(selected_nodes.begin(), selected_nodes.end(), candidate) == selected_nodes.end())
             selected_nodes.push_back(candidate);
@@ -61,7 +55,7 @@ vector<int> choose_neighbours(int n, int k, vector<int> excluded)
 }
 
 // return k node ids as vector randomly from given possible choices as the universe_set
-vector<int> choose_neighbours_values(vector<int> universe_set, int k, vector<int> excluded) {
+vector<int> choose_neighbours_values(RandomStream& stream, vector<int> universe_set, int k, vector<int> excluded) {
 
     int n = universe_set.size();
     vector<int> selected_nodes;
@@ -69,7 +63,7 @@ vector<int> choose_neighbours_values(vector<int> universe_set, int k, vector<int
 
     // incrementally choose nodes without repetition from uniform distribution
     while (selected_nodes.size() < k) {
-        int candidate_idx = uniform_distribution(0, n - 1);
+        int candidate_idx = uniform_distribution(stream, 0, n - 1);
         int candidate = universe_set[candidate_idx];
         if (find(excluded.begin(), excluded.end(), candidate) == excluded.end() &&
             find(selected_nodes.begin(), selected_nodes.end(), candidate) == selected_nodes.end()) {
@@ -114,9 +108,9 @@ bool check_connected(vector<vector<int>>& al)
 
 // checks if the given graph is connected using dfs: ml is map
 bool check_connected_map(map<int, vector<int>>& al) {
-    static int cnt = 0;
+    static thread_local int cnt = 0;
     cnt++;
-    cout << "Check connected map called " << cnt << " times" << endl;
+    *console << "Check connected map called " << cnt << " times" << endl;
 
     int n = static_cast<int>(al.size());
     if (n == 0) return true;
@@ -237,21 +231,3 @@ void write_network_to_file_map(map<int, vector<int>>& al,const string &fname)
     adj_file.close();
 
 }
-//
-// //  Hash computation taken from MICA key-value store by Hyeontaek Lim
-// string md5(const string &data) {
-//     unsigned char digest[EVP_MAX_MD_SIZE];
-//     unsigned int digest_len;
-//
-//     EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-//     EVP_DigestInit_ex(ctx, EVP_md5(), nullptr);
-//     EVP_DigestUpdate(ctx, data.c_str(), data.size());
-//     EVP_DigestFinal_ex(ctx, digest, &digest_len);
-//     EVP_MD_CTX_free(ctx);
-//
-//     stringstream ss;
-//     for (unsigned int i = 0; i < digest_len; i++) {
-//         ss << hex << setw(2) << setfill('0') << (int)digest[i];
-//     }
-//     return ss.str();
-// }
\ No newline at end of file
@@ -6,27 +6,30 @@
 #include <iostream>
 #include <filesystem>
 #include <map>
+#include "RandomStream.h"
 
 using namespace std;
 namespace fs = filesystem;
 
-extern unsigned int global_seed;
-extern string output_dir;
+extern thread_local unsigned int global_seed;
+extern thread_local string output_dir;
+// progress messages and chain traces of the run on this thread, stdout or the log of a sweep run
+extern thread_local ostream* console;
 
 
 // min and max are inclusive
-int uniform_distribution(int min, int max);
+int uniform_distribution(RandomStream& stream, int min, int max);
 
 // returns discrete values (milliseconds)
-int exponential_distribution(double mean);
+int exponential_distribution(RandomStream& stream, double mean);
 
 // returns percentage of nodes from given 0 to n-1 nodes
-vector<int> choose_percent(int n, double percent);
+vector<int> choose_percent(RandomStream& stream, int n, double percent);
 
 // returns k nodes apart from those in <excluded> from 0 to n-1 nodes.
-vector<int> choose_neighbours(int n, int k, vector<int> excluded);
+vector<int> choose_neighbours(RandomStream& stream, int n, int k, vector<int> excluded);
 
-vector<int> choose_neighbours_values(vector<int> universe_set, int k, vector<int> excluded);
+vector<int> choose_neighbours_values(RandomStream& stream, vector<int> universe_set, int k, vector<int> excluded);
 
 // checks if the given graph is connected using dfs
 bool check_connected(vector<vector<int>>& al);
@@ -38,7 +41,4 @@ void write_network_to_file(vector<vector<int>>& al,const string& fname);
 
 void write_network_to_file_map(map<int, vector<int>>& al,const string &fname);
 
-//  Hash computation taken from MICA key-value store by Hyeontaek Lim
-// string md5(const string &data);
-
 #endif //UTILITY_H